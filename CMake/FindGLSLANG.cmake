@@ -0,0 +1,88 @@
+#
+# Find glslang
+#
+# Try to find glslang : Khronos GLSL reference compiler, with its SPIR-V
+# backend. Looks for the installed layout (glslang/Public, glslang/SPIRV).
+# This module defines the following variables:
+# - GLSLANG_INCLUDE_DIRS
+# - GLSLANG_LIBRARIES
+# - GLSLANG_FOUND
+#
+# The following variables can be set as arguments for the module.
+# - GLSLANG_ROOT_DIR : Root library directory of glslang
+#
+
+# Additional modules
+include(FindPackageHandleStandardArgs)
+
+if (WIN32)
+	set(GLSLANG_INCLUDE_PATHS
+		$ENV{PROGRAMFILES}/include
+		$ENV{VULKAN_SDK}/Include
+		${GLSLANG_ROOT_DIR}/include)
+	set(GLSLANG_LIBRARY_PATHS
+		$ENV{PROGRAMFILES}/lib
+		$ENV{VULKAN_SDK}/Lib
+		${GLSLANG_ROOT_DIR}/lib)
+else()
+	set(GLSLANG_INCLUDE_PATHS
+		/usr/include
+		/usr/local/include
+		/sw/include
+		/opt/local/include
+		$ENV{VULKAN_SDK}/include
+		${GLSLANG_ROOT_DIR}/include)
+	set(GLSLANG_LIBRARY_PATHS
+		/usr/lib64
+		/usr/lib
+		/usr/local/lib64
+		/usr/local/lib
+		/sw/lib
+		/opt/local/lib
+		$ENV{VULKAN_SDK}/lib
+		${GLSLANG_ROOT_DIR}/lib)
+endif()
+
+# Find include files
+find_path(
+	GLSLANG_INCLUDE_DIR
+	NAMES glslang/SPIRV/GlslangToSpv.h
+	PATHS ${GLSLANG_INCLUDE_PATHS}
+	DOC "The directory where glslang/SPIRV/GlslangToSpv.h resides")
+
+# Find library files
+find_library(
+	GLSLANG_LIBRARY
+	NAMES glslang
+	PATHS ${GLSLANG_LIBRARY_PATHS}
+	DOC "The glslang library")
+find_library(
+	GLSLANG_SPIRV_LIBRARY
+	NAMES SPIRV
+	PATHS ${GLSLANG_LIBRARY_PATHS}
+	DOC "The glslang SPIR-V backend library")
+
+# Static builds split glslang in more libraries, depending on the version
+set(GLSLANG_EXTRA_LIBRARIES)
+foreach(_lib MachineIndependent GenericCodeGen OSDependent OGLCompiler HLSL)
+	find_library(GLSLANG_${_lib}_LIBRARY NAMES ${_lib}
+		PATHS ${GLSLANG_LIBRARY_PATHS})
+	if (GLSLANG_${_lib}_LIBRARY)
+		list(APPEND GLSLANG_EXTRA_LIBRARIES ${GLSLANG_${_lib}_LIBRARY})
+	endif()
+	mark_as_advanced(GLSLANG_${_lib}_LIBRARY)
+endforeach()
+
+# Handle REQUIRD argument, define *_FOUND variable
+find_package_handle_standard_args(GLSLANG DEFAULT_MSG GLSLANG_INCLUDE_DIR
+	GLSLANG_LIBRARY GLSLANG_SPIRV_LIBRARY)
+
+# Define GLSLANG_LIBRARIES and GLSLANG_INCLUDE_DIRS
+if (GLSLANG_FOUND)
+	set(GLSLANG_LIBRARIES ${GLSLANG_SPIRV_LIBRARY} ${GLSLANG_LIBRARY}
+		${GLSLANG_EXTRA_LIBRARIES})
+	set(GLSLANG_INCLUDE_DIRS ${GLSLANG_INCLUDE_DIR})
+endif()
+
+# Hide some variables
+mark_as_advanced(GLSLANG_INCLUDE_DIR GLSLANG_LIBRARY GLSLANG_SPIRV_LIBRARY)
@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+// Calls ParallelRecorder::record on the main thread while a second thread
+//    keeps waiting on the same JobSystem, so both end up recording chunks.
+//    Every draw job checks that no other thread records on its command pool
+//    at the same time.
+
+#include <lava/lava.h>
+#include <lavaUtils/ParallelRecorder.h>
+using namespace lava;
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+
+const uint32_t ITERATIONS = 200;
+const uint32_t DRAWS_PER_RECORD = 64;
+
+int main( void )
+{
+  vk::ApplicationInfo appInfo(
+    "ParallelRecorderStress",
+    VK_MAKE_VERSION( 1, 0, 0 ),
+    "Lava",
+    VK_MAKE_VERSION( 1, 0, 0 ),
+    VK_API_VERSION_1_0
+  );
+  auto instance = Instance::create( vk::InstanceCreateInfo(
+    { }, &appInfo, 0, nullptr, 0, nullptr ) );
+
+  assert( instance->getPhysicalDeviceCount( ) != 0 );
+  auto physicalDevice = instance->getPhysicalDevice( 0 );
+
+  auto queueFamilies = physicalDevice->getQueueFamilyProperties( );
+  uint32_t queueFamilyIndex = 0;
+  while ( queueFamilyIndex < queueFamilies.size( ) &&
+    !( queueFamilies[ queueFamilyIndex ].queueFlags &
+      vk::QueueFlagBits::eGraphics ) )
+  {
+    ++queueFamilyIndex;
+  }
+  assert( queueFamilyIndex < queueFamilies.size( ) );
+  std::vector<float> queuePriorities = { 1.0f };
+  vk::DeviceQueueCreateInfo queueCreateInfo( { }, queueFamilyIndex,
+    queuePriorities.size( ), queuePriorities.data( ) );
+
+  auto device = physicalDevice->createDevice(
+    { queueCreateInfo }, { }, { }, physicalDevice->getDeviceFeatures( )
+  );
+
+  const vk::Format colorFormat = vk::Format::eR8G8B8A8Unorm;
+  const vk::Extent2D extent( 64, 64 );
+
+  vk::AttachmentDescription colorAttachment( { }, colorFormat,
+    vk::SampleCountFlagBits::e1, vk::AttachmentLoadOp::eClear,
+    vk::AttachmentStoreOp::eStore, vk::AttachmentLoadOp::eDontCare,
+    vk::AttachmentStoreOp::eDontCare, vk::ImageLayout::eUndefined,
+    vk::ImageLayout::eColorAttachmentOptimal );
+  vk::AttachmentReference colorReference( 0,
+    vk::ImageLayout::eColorAttachmentOptimal );
+  vk::SubpassDescription subpass( { }, vk::PipelineBindPoint::eGraphics,
+    0, nullptr, 1, &colorReference, nullptr, nullptr, 0, nullptr );
+  auto renderPass = device->createRenderPass( colorAttachment, subpass,
+    nullptr );
+
+  auto colorImage = device->createImage( { }, vk::ImageType::e2D,
+    colorFormat, vk::Extent3D( extent.width, extent.height, 1 ), 1, 1,
+    vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+    vk::ImageUsageFlagBits::eColorAttachment, vk::SharingMode::eExclusive,
+    { }, vk::ImageLayout::eUndefined,
+    vk::MemoryPropertyFlagBits::eDeviceLocal );
+  auto colorView = colorImage->createImageView( vk::ImageViewType::e2D,
+    colorFormat );
+  auto framebuffer = device->createFramebuffer( renderPass,
+    { colorView }, extent, 1 );
+
+  utility::JobSystem jobSystem( 3 );
+  utility::ParallelRecorder recorder( device, queueFamilyIndex, jobSystem );
+
+  std::mutex ownersMutex;
+  std::map<CommandPool*, std::thread::id> owners;
+  std::atomic<uint32_t> conflicts( 0 );
+  std::atomic<uint32_t> externalDraws( 0 );
+  const std::thread::id mainThread = std::this_thread::get_id( );
+  std::thread::id waiterThread;
+
+  // Unrelated work on the same JobSystem: its wait runs recording chunks too
+  std::atomic<bool> done( false );
+  std::thread waiter( [ & ]( )
+  {
+    while ( !done.load( ) )
+    {
+      utility::JobCounter counter;
+      for ( uint32_t i = 0; i < 16; ++i )
+      {
+        jobSystem.run( [ ]( )
+        {
+          std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+        }, &counter );
+      }
+      jobSystem.wait( counter );
+    }
+  } );
+  waiterThread = waiter.get_id( );
+
+  utility::DrawJob draw = [ & ]( const std::shared_ptr<CommandBuffer>& cmd )
+  {
+    CommandPool* pool = cmd->getCommandPool( ).get( );
+    std::thread::id self = std::this_thread::get_id( );
+    {
+      std::lock_guard<std::mutex> lock( ownersMutex );
+      auto it = owners.find( pool );
+      if ( it != owners.end( ) && it->second != self )
+      {
+        ++conflicts;
+      }
+      owners[ pool ] = self;
+    }
+    if ( self == mainThread || self == waiterThread )
+    {
+      ++externalDraws;
+    }
+    std::this_thread::sleep_for( std::chrono::microseconds( 20 ) );
+    {
+      std::lock_guard<std::mutex> lock( ownersMutex );
+      auto it = owners.find( pool );
+      if ( it != owners.end( ) && it->second == self )
+      {
+        owners.erase( it );
+      }
+    }
+  };
+  std::vector<utility::DrawJob> jobs( DRAWS_PER_RECORD, draw );
+
+  for ( uint32_t i = 0; i < ITERATIONS; ++i )
+  {
+    recorder.beginFrame( 0 );
+    auto secondaries = recorder.record( renderPass, 0, framebuffer, jobs );
+    assert( secondaries.size( ) != 0 );
+  }
+
+  done = true;
+  waiter.join( );
+  device->waitIdle( );
+
+  std::cout << ITERATIONS << " records of " << DRAWS_PER_RECORD
+    << " draws, " << externalDraws.load( ) << " draws on non-worker threads"
+    << std::endl;
+  std::cout << "Command pools shared between threads: " << conflicts.load( )
+    << std::endl;
+
+  return conflicts.load( ) == 0 ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+// Compares Queue::submit with shared_ptr SubmitInfos against the SubmitBatch
+//    fast path. Both paths make the same vkQueueSubmit calls: first one per
+//    command buffer, then one per frame with every command buffer. Heap
+//    allocations made while submitting are counted too.
+
+#include <lava/lava.h>
+using namespace lava;
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+const uint32_t SUBMITS_PER_FRAME = 8;
+const uint32_t WARMUP_FRAMES = 16;
+const uint32_t FRAMES = 2000;
+
+static std::atomic<uint64_t> allocations( 0 );
+
+void* operator new( size_t size )
+{
+  ++allocations;
+  void* ptr = malloc( size != 0 ? size : 1 );
+  if ( !ptr )
+  {
+    throw std::bad_alloc( );
+  }
+  return ptr;
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  free( ptr );
+}
+
+struct Result
+{
+  double submitsPerSecond;
+  double allocationsPerFrame;
+};
+
+// Every frame submits the SUBMITS_PER_FRAME command buffers
+template <typename Func>
+Result measure( Func frame )
+{
+  for ( uint32_t i = 0; i < WARMUP_FRAMES; ++i )
+  {
+    frame( );
+  }
+  uint64_t startAllocations = allocations.load( );
+  auto start = std::chrono::high_resolution_clock::now( );
+  for ( uint32_t i = 0; i < FRAMES; ++i )
+  {
+    frame( );
+  }
+  auto end = std::chrono::high_resolution_clock::now( );
+  double seconds = std::chrono::duration<double>( end - start ).count( );
+
+  Result result;
+  result.submitsPerSecond = ( FRAMES * SUBMITS_PER_FRAME ) / seconds;
+  result.allocationsPerFrame =
+    double( allocations.load( ) - startAllocations ) / FRAMES;
+  return result;
+}
+
+void report( const char* name, const Result& result )
+{
+  std::cout << "  " << name << ": " << result.submitsPerSecond
+    << " submits/sec, " << result.allocationsPerFrame
+    << " allocations/frame" << std::endl;
+}
+
+int main( void )
+{
+  vk::ApplicationInfo appInfo(
+    "SubmitBenchmark",
+    VK_MAKE_VERSION( 1, 0, 0 ),
+    "Lava",
+    VK_MAKE_VERSION( 1, 0, 0 ),
+    VK_API_VERSION_1_0
+  );
+  auto instance = Instance::create( vk::InstanceCreateInfo(
+    { }, &appInfo, 0, nullptr, 0, nullptr ) );
+
+  assert( instance->getPhysicalDeviceCount( ) != 0 );
+  auto physicalDevice = instance->getPhysicalDevice( 0 );
+
+  auto queueFamilyIndices = physicalDevice->getComputeQueueFamilyIndices( );
+  assert( !queueFamilyIndices.empty( ) );
+  const uint32_t queueFamilyIndex = queueFamilyIndices[ 0 ];
+  std::vector<float> queuePriorities = { 1.0f };
+  vk::DeviceQueueCreateInfo queueCreateInfo( { }, queueFamilyIndex,
+    queuePriorities.size( ), queuePriorities.data( ) );
+
+  auto device = physicalDevice->createDevice(
+    { queueCreateInfo }, { }, { }, physicalDevice->getDeviceFeatures( )
+  );
+  auto queue = device->getQueue( queueFamilyIndex, 0 );
+  auto commandPool = device->createCommandPool( { }, queueFamilyIndex );
+
+  // Empty command buffers: only the submission cost is measured. Both
+  //    paths get one caller fence per vkQueueSubmit.
+  std::vector<std::shared_ptr<CommandBuffer>> commandBuffers;
+  std::vector<vk::CommandBuffer> handles;
+  std::vector<SubmitInfo> submitInfos;
+  std::vector<std::shared_ptr<Fence>> fences;
+  for ( uint32_t i = 0; i < SUBMITS_PER_FRAME; ++i )
+  {
+    auto cmd = commandPool->allocateCommandBuffer( );
+    cmd->begin( );
+    cmd->end( );
+    commandBuffers.push_back( cmd );
+    handles.push_back( *cmd );
+    submitInfos.push_back( SubmitInfo( nullptr, nullptr, cmd, nullptr ) );
+    fences.push_back( device->createFence( false ) );
+  }
+  auto waitAndReset = [ & ]( uint32_t count )
+  {
+    for ( uint32_t i = 0; i < count; ++i )
+    {
+      fences[ i ]->wait( );
+      fences[ i ]->reset( );
+    }
+  };
+
+  SubmitBatch batch;
+
+  Result legacySingle = measure( [ & ]( )
+  {
+    for ( uint32_t i = 0; i < SUBMITS_PER_FRAME; ++i )
+    {
+      queue->submit( submitInfos[ i ], fences[ i ] );
+    }
+    waitAndReset( SUBMITS_PER_FRAME );
+  } );
+
+  Result batchedSingle = measure( [ & ]( )
+  {
+    for ( uint32_t i = 0; i < SUBMITS_PER_FRAME; ++i )
+    {
+      batch.clear( );
+      batch.add( nullptr, nullptr, handles[ i ], nullptr );
+      queue->submit( batch, fences[ i ] );
+    }
+    waitAndReset( SUBMITS_PER_FRAME );
+  } );
+
+  Result legacyFrame = measure( [ & ]( )
+  {
+    queue->submit( submitInfos, fences[ 0 ] );
+    waitAndReset( 1 );
+  } );
+
+  Result batchedFrame = measure( [ & ]( )
+  {
+    batch.clear( );
+    for ( auto& cmd : handles )
+    {
+      batch.add( nullptr, nullptr, cmd, nullptr );
+    }
+    queue->submit( batch, fences[ 0 ] );
+    waitAndReset( 1 );
+  } );
+
+  device->waitIdle( );
+
+  std::cout << SUBMITS_PER_FRAME << " command buffers per frame, " << FRAMES
+    << " frames" << std::endl;
+  std::cout << "One vkQueueSubmit per command buffer" << std::endl;
+  report( "SubmitInfo path", legacySingle );
+  report( "SubmitBatch path", batchedSingle );
+  std::cout << "One vkQueueSubmit per frame" << std::endl;
+  report( "SubmitInfo path", legacyFrame );
+  report( "SubmitBatch path", batchedFrame );
+
+  return 0;
+}
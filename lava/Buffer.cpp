@@ -21,6 +21,8 @@
 
 #include "Image.h"
 
+#include <algorithm>
+
 namespace lava
 {
   Buffer::Buffer( const std::shared_ptr<Device>& device, 
@@ -30,6 +32,9 @@ namespace lava
     : VulkanResource( device )
     , _memoryPropertyFlags( memoryPropFlags )
     , _size( size )
+    , _hostCoherent( true )
+    , _dirtyBegin( VK_WHOLE_SIZE )
+    , _dirtyEnd( 0 )
   {
     vk::BufferCreateInfo bci;
     bci.flags = createFlags;
@@ -39,6 +44,8 @@ namespace lava
 
     _buffer = static_cast< vk::Device >( *_device ).createBuffer( bci );
     _memory = _device->allocateBufferMemory( _buffer, _memoryPropertyFlags );
+    _hostCoherent = _device->getMemoryAllocator( )->isHostCoherent(
+      _memory.memoryTypeIndex );
 
     // updateDescriptor( );
   }
@@ -58,18 +65,19 @@ namespace lava
 
   void Buffer::map( vk::DeviceSize offset, vk::DeviceSize length, void * data )
   {
-    vk::Result result = static_cast< vk::Device >( *_device ).mapMemory(
-      _memory, offset, length, { }, &data
-    );
-    // lava::utils::translateVulkanResult( result );
-    assert( result == vk::Result::eSuccess );
+    data = map( offset, length );
   }
 
   void * Buffer::map( vk::DeviceSize offset, vk::DeviceSize length ) const
   {
+    // Host visible memory is persistently mapped by the allocator
+    if ( _memory.mapped )
+    {
+      return static_cast< uint8_t* >( _memory.mapped ) + offset;
+    }
     void* data;
     vk::Result result = static_cast< vk::Device >( *_device ).mapMemory(
-      _memory, offset, length, { }, &data
+      _memory.memory, _memory.offset + offset, length, { }, &data
     );
     // lava::utils::translateVulkanResult( result );
     assert( result == vk::Result::eSuccess );
@@ -77,7 +85,10 @@ namespace lava
   }
   void Buffer::unmap( void )
   {
-    static_cast< vk::Device >( *_device ).unmapMemory( _memory );
+    if ( !_memory.mapped )
+    {
+      static_cast< vk::Device >( *_device ).unmapMemory( _memory.memory );
+    }
   }
   void Buffer::copy( const std::shared_ptr<CommandBuffer>& cmd,
     std::shared_ptr<Buffer> dst, vk::DeviceSize srcOffset,
@@ -109,28 +120,21 @@ namespace lava
 
   vk::Result Buffer::flush( vk::DeviceSize offset, vk::DeviceSize size )
   {
-    vk::MappedMemoryRange mappedRange;
-    mappedRange.memory = _memory;
-    mappedRange.offset = offset;
-    mappedRange.size = size;
-    //static_cast< vk::Device >( *_device ).flushMappedMemoryRanges( { mappedRange } );
-    return static_cast< vk::Device >( *_device ).flushMappedMemoryRanges( 1, &mappedRange );
+    return _device->getMemoryAllocator( )->flush( _memory, offset, size );
   }
 
   void Buffer::invalidate( vk::DeviceSize size, vk::DeviceSize offset )
   {
-    vk::MappedMemoryRange mappedRange;
-    mappedRange.memory = _memory;
-    mappedRange.offset = offset;
-    mappedRange.size = size;
-    static_cast< vk::Device >( *_device )
-      .invalidateMappedMemoryRanges( { mappedRange } );
+    _device->getMemoryAllocator( )->invalidate( _memory, offset, size );
   }
 
   void Buffer::readData( vk::DeviceSize offset, vk::DeviceSize length, void* dst )
   {
-    void* data = map( offset, length );
-    memcpy( dst, data, length );
+    if ( !_hostCoherent )
+    {
+      invalidate( length, offset );
+    }
+    memcpy( dst, map( offset, length ), length );
     unmap( );
   }
   void Buffer::read( void * dst )
@@ -141,11 +145,67 @@ namespace lava
     const void * src )
   {
     // We can't access to VRAM, but we can copy our data to DRAM
-    if ( _memoryPropertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal ) throw;
-    void* data = map( offset, length );
-    memcpy( data, src, length );
-    //if ( flush( VK_WHOLE_SIZE, 0 ) != vk::Result::eSuccess ) throw;
-    unmap( );
+    if ( !_memory.mapped )
+    {
+      throw std::runtime_error( "Buffer memory is not host visible" );
+    }
+    memcpy( static_cast< uint8_t* >( _memory.mapped ) + offset, src, length );
+    if ( !_hostCoherent )
+    {
+      // Flushed right away (with any pending dirty range), like update( )
+      markDirty( offset, length );
+      flushDirty( );
+    }
+  }
+  void Buffer::markDirty( vk::DeviceSize offset, vk::DeviceSize size )
+  {
+    if ( _hostCoherent )
+    {
+      return;
+    }
+    if ( size == VK_WHOLE_SIZE )
+    {
+      size = _size - offset;
+    }
+    _dirtyBegin = std::min( _dirtyBegin, offset );
+    _dirtyEnd = std::max( _dirtyEnd, offset + size );
+  }
+  vk::Result Buffer::flushDirty( void )
+  {
+    if ( _dirtyEnd <= _dirtyBegin )
+    {
+      return vk::Result::eSuccess;
+    }
+    vk::Result result = flush( _dirtyBegin, _dirtyEnd - _dirtyBegin );
+    _dirtyBegin = VK_WHOLE_SIZE;
+    _dirtyEnd = 0;
+    return result;
+  }
+  vk::Result Buffer::flushDirty(
+    vk::ArrayProxy<const std::shared_ptr<Buffer>> buffers )
+  {
+    std::shared_ptr<Device> device;
+    std::vector<vk::MappedMemoryRange> ranges;
+    ranges.reserve( buffers.size( ) );
+    for ( auto const& buffer : buffers )
+    {
+      if ( buffer->_dirtyEnd <= buffer->_dirtyBegin )
+      {
+        continue;
+      }
+      device = buffer->_device;
+      ranges.push_back( device->getMemoryAllocator( )->mappedRange(
+        buffer->_memory, buffer->_dirtyBegin,
+        buffer->_dirtyEnd - buffer->_dirtyBegin ) );
+      buffer->_dirtyBegin = VK_WHOLE_SIZE;
+      buffer->_dirtyEnd = 0;
+    }
+    if ( ranges.empty( ) )
+    {
+      return vk::Result::eSuccess;
+    }
+    return static_cast< vk::Device >( *device ).flushMappedMemoryRanges(
+      ranges.size( ), ranges.data( ) );
   }
   void Buffer::set( const void * dst )
   {
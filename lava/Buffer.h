@@ -22,6 +22,7 @@
 
 #include <lava/CommandBuffer.h>
 #include <lava/Device.h>
+#include <lava/StagingRing.h>
 #include <lava/VulkanResource.h>
 #include <memory>
 
@@ -84,6 +85,7 @@ namespace lava
     void readData( vk::DeviceSize offset, vk::DeviceSize length, void* dst );
     LAVA_API
     void read( void* dst );
+    // Copies into the mapped memory and flushes it if not coherent
     LAVA_API
     void writeData( vk::DeviceSize offset, vk::DeviceSize length, const void* src );
     LAVA_API
@@ -92,6 +94,42 @@ namespace lava
     LAVA_API
     void updateDescriptor( void );
 
+    /**
+    * Host visible buffers are mapped once at creation. Returns the persistent
+    *   pointer, or nullptr if the buffer lives in device local memory.
+    */
+    LAVA_API
+    inline void* data( void ) const
+    {
+      return _memory.mapped;
+    }
+    template <typename T>
+    inline vk::ArrayProxy<T> span( void ) const
+    {
+      return vk::ArrayProxy<T>( uint32_t( _size / sizeof( T ) ),
+        static_cast< T* >( _memory.mapped ) );
+    }
+    LAVA_API
+    inline bool isHostCoherent( void ) const
+    {
+      return _hostCoherent;
+    }
+
+    /**
+    * Records a range written through data( ) that must be flushed. Ranges
+    *   are merged until flushDirty( ) is called, nothing flushes them
+    *   implicitly. writeData and update flush on their own. Noop on
+    *   coherent memory.
+    */
+    LAVA_API
+    void markDirty( vk::DeviceSize offset, vk::DeviceSize size );
+    LAVA_API
+    vk::Result flushDirty( void );
+    // Flushes the dirty ranges of all the buffers with a single call
+    LAVA_API
+    static vk::Result flushDirty(
+      vk::ArrayProxy<const std::shared_ptr<Buffer>> buffers );
+
     LAVA_API
     inline vk::DeviceSize getSize( void ) const { return _size; }
 
@@ -119,9 +157,12 @@ namespace lava
     //protected:
     vk::Buffer _buffer;
     vk::MemoryPropertyFlags _memoryPropertyFlags;
-    vk::DeviceMemory _memory;
+    MemoryAllocation _memory;
   protected:
     vk::DeviceSize _size;
+    bool _hostCoherent;
+    vk::DeviceSize _dirtyBegin;
+    vk::DeviceSize _dirtyEnd;
     //DescriptorBufferInfo descriptor;
   };
 
@@ -159,31 +200,22 @@ namespace lava
     {
       cmdBuff->updateBuffer( shared_from_this( ), offset, data );
     }
-    else if ( getMemoryPropertyFlags( ) &
-      vk::MemoryPropertyFlagBits::eHostVisible )
+    else if ( _memory.mapped )
     {
-      void* pData = this->map( offset, size );
-      memcpy( pData, data.data( ), size );
-      if ( !( getMemoryPropertyFlags( ) &
-        vk::MemoryPropertyFlagBits::eHostCoherent ) )
+      memcpy( static_cast< uint8_t* >( _memory.mapped ) + offset,
+        data.data( ), size );
+      if ( !_hostCoherent )
       {
-        this->flush( size, offset );
+        markDirty( offset, size );
+        flushDirty( );
       }
-      this->unmap( );
     }
     else
     {
-      std::shared_ptr<Buffer> stagingBuffer = _device->createBuffer(
-        _size, vk::BufferUsageFlagBits::eTransferSrc,
-        vk::SharingMode::eExclusive, nullptr,
-        vk::MemoryPropertyFlagBits::eHostVisible
-      );
-      void * pData = stagingBuffer->map( offset, size );
-      memcpy( pData, data.data( ), size );
-      stagingBuffer->flush( offset, size );
-      stagingBuffer->unmap( );
-      cmdBuff->copyBuffer( stagingBuffer, shared_from_this( ),
-        vk::BufferCopy( 0, 0, size ) );
+      // Device local, copy through the device staging ring
+      StagingRegion region = _device->getStagingRing( )->write(
+        *cmdBuff, data.data( ), size );
+      cmdBuff->copyBuffer( region, shared_from_this( ), offset );
     }
   }
 
@@ -28,6 +28,10 @@
 #include <lava/PhysicalDevice.h>
 #include <lava/RenderPass.h>
 #include <lava/QueryPool.h>
+#include <lava/StagingRing.h>
+#include <lava/UniformArena.h>
+
+#include <algorithm>
 
 namespace lava
 {
@@ -92,6 +96,18 @@ namespace lava
     return( commandBuffer );
   }
 
+  void CommandPool::reset( vk::CommandPoolResetFlags flags )
+  {
+    static_cast< vk::Device >( *_device ).resetCommandPool( _commandPool,
+      flags );
+    for ( auto cmd : _commandBuffers )
+    {
+      assert( cmd->_state != CommandBuffer::State::Recording &&
+        cmd->_state != CommandBuffer::State::RecordingRenderPass );
+      cmd->_state = CommandBuffer::State::Ready;
+    }
+  }
+
   bool CommandPool::supportsCompute( void ) const
   {
     return !!( _device->getPhysicalDevice( )
@@ -136,6 +152,9 @@ namespace lava
     {
 
     }
+    auto& poolBuffers = _commandPool->_commandBuffers;
+    poolBuffers.erase( std::remove( poolBuffers.begin( ), poolBuffers.end( ),
+      this ), poolBuffers.end( ) );
     static_cast<vk::Device>( *_commandPool->getDevice( ) )
       .freeCommandBuffers( *_commandPool, _commandBuffer );
   }
@@ -497,6 +516,26 @@ namespace lava
       regions );
   }
 
+  void CommandBuffer::copyBuffer( const StagingRegion& src,
+    const std::shared_ptr<Buffer>& dstBuffer, vk::DeviceSize dstOffset )
+  {
+    _commandBuffer.copyBuffer( src.buffer, *dstBuffer,
+      vk::BufferCopy( src.offset, dstOffset, src.size ) );
+  }
+
+  void CommandBuffer::copyBufferToImage( const StagingRegion& src,
+    const std::shared_ptr<Image>& dstImage, vk::ImageLayout dstImageLayout,
+    vk::ArrayProxy<const vk::BufferImageCopy> regions )
+  {
+    std::vector<vk::BufferImageCopy> copies( regions.begin( ), regions.end( ) );
+    for ( auto& copy : copies )
+    {
+      copy.bufferOffset += src.offset;
+    }
+    _commandBuffer.copyBufferToImage( src.buffer, *dstImage, dstImageLayout,
+      copies );
+  }
+
   void CommandBuffer::copyImage( const std::shared_ptr<Image>& srcImage,
     vk::ImageLayout srcImageLayout, const std::shared_ptr<Image>& dstImage,
     vk::ImageLayout dstImageLayout, vk::ArrayProxy<const vk::ImageCopy> regions )
@@ -551,6 +590,16 @@ namespace lava
       firstSet, _bindDescriptorSets, dynamicOffsets );
   }
 
+  void CommandBuffer::bindDescriptorSets(
+    vk::PipelineBindPoint pipelineBindPoint,
+    const std::shared_ptr<PipelineLayout>& pipelineLayout, uint32_t set,
+    const UniformAllocation& uniform )
+  {
+    vk::DescriptorSet descriptorSet = *uniform.descriptorSet;
+    _commandBuffer.bindDescriptorSets( pipelineBindPoint, *pipelineLayout,
+      set, descriptorSet, uniform.dynamicOffset );
+  }
+
   void CommandBuffer::bindPipeline( vk::PipelineBindPoint bindingPoint,
     const std::shared_ptr<Pipeline>& pipeline )
   {
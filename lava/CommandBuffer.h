@@ -32,6 +32,8 @@ namespace lava
   class QueryPool;
   class RenderPass;
   class Framebuffer;
+  struct StagingRegion;
+  struct UniformAllocation;
 }
 
 namespace lava
@@ -91,7 +93,16 @@ namespace lava
     LAVA_API
     std::shared_ptr<CommandBuffer> allocateCommandBuffer(
       vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary );
+
+    /**
+    * Resets every command buffer of the pool at once (vkResetCommandPool)
+    *   and moves them back to the ready state. None of them can be pending.
+    */
+    LAVA_API
+    void reset( vk::CommandPoolResetFlags flags = { } );
   protected:
+    friend class CommandBuffer;
+
     vk::CommandPool _commandPool;
     std::vector<CommandBuffer*> _commandBuffers;
     uint32_t _familyIndex;
@@ -112,6 +123,8 @@ namespace lava
       // Buffer is done recording and is currently submitted on a queue.
       Submitted
     };
+    friend class CommandPool;
+    friend class Queue;
   public:
     LAVA_API
     CommandBuffer( const std::shared_ptr<CommandPool>& cmdPool,
@@ -307,6 +320,11 @@ namespace lava
       const std::shared_ptr<PipelineLayout>& pipelineLayout, uint32_t firstSet,
       vk::ArrayProxy<const std::shared_ptr<DescriptorSet>> descriptorSets,
       vk::ArrayProxy<const uint32_t> dynamicOffsets );
+    // Binds the arena set of the allocation at its dynamic offset
+    LAVA_API
+    void bindDescriptorSets( vk::PipelineBindPoint pipelineBindPoint,
+      const std::shared_ptr<PipelineLayout>& pipelineLayout, uint32_t set,
+      const UniformAllocation& uniform );
     LAVA_API
     void bindPipeline( vk::PipelineBindPoint bindingPoint,
       const std::shared_ptr<Pipeline>& pipeline );
@@ -325,6 +343,15 @@ namespace lava
     void copyBufferToImage( const std::shared_ptr<Buffer>& srcBuffer,
       const std::shared_ptr<Image>& dstImage, vk::ImageLayout dstImageLayout,
       vk::ArrayProxy<const vk::BufferImageCopy> regions );
+    // Copies the whole staging region into dstBuffer at dstOffset
+    LAVA_API
+    void copyBuffer( const StagingRegion& src,
+      const std::shared_ptr<Buffer>& dstBuffer, vk::DeviceSize dstOffset );
+    // Region bufferOffsets are relative to the staging region
+    LAVA_API
+    void copyBufferToImage( const StagingRegion& src,
+      const std::shared_ptr<Image>& dstImage, vk::ImageLayout dstImageLayout,
+      vk::ArrayProxy<const vk::BufferImageCopy> regions );
     LAVA_API
     void copyImage( const std::shared_ptr<Image>& srcImage,
       vk::ImageLayout srcImageLayout, const std::shared_ptr<Image>& dstImage,
@@ -358,6 +385,11 @@ namespace lava
     {
       return _framebuffer;
     }
+    LAVA_API
+    inline std::shared_ptr<CommandPool> getCommandPool( void ) const
+    {
+      return _commandPool;
+    }
 
   protected:
     std::shared_ptr<CommandPool> _commandPool;
@@ -0,0 +1,876 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "CompressedTexture.h"
+
+#include <lava/CommandBuffer.h>
+#include <lava/Device.h>
+#include <lava/PhysicalDevice.h>
+#include <lava/Queue.h>
+#include <lava/StagingRing.h>
+#include <lava/UploadEngine.h>
+
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace lava
+{
+  namespace
+  {
+    std::vector<unsigned char> readFile( const std::string& filename )
+    {
+      std::ifstream file( filename, std::ios::ate | std::ios::binary );
+      if ( !file.is_open( ) )
+      {
+        throw std::runtime_error( "failed to open file!" );
+      }
+      std::vector<unsigned char> bytes( static_cast< size_t >( file.tellg( ) ) );
+      file.seekg( 0 );
+      file.read( reinterpret_cast< char* >( bytes.data( ) ), bytes.size( ) );
+      return bytes;
+    }
+
+    // Both containers are little endian
+    template <typename T>
+    T readValue( const std::vector<unsigned char>& bytes, size_t offset )
+    {
+      if ( offset + sizeof( T ) > bytes.size( ) )
+      {
+        throw std::runtime_error( "CompressedTexture: truncated file" );
+      }
+      T value;
+      memcpy( &value, bytes.data( ) + offset, sizeof( T ) );
+      return value;
+    }
+
+    uint32_t fourCC( char a, char b, char c, char d )
+    {
+      return uint32_t( uint8_t( a ) ) | ( uint32_t( uint8_t( b ) ) << 8 ) |
+        ( uint32_t( uint8_t( c ) ) << 16 ) | ( uint32_t( uint8_t( d ) ) << 24 );
+    }
+
+    // Larger images are rejected, which also keeps the size math in 64 bits
+    const uint32_t MAX_DIMENSION = 65536;
+    const uint32_t MAX_LAYERS = 65536;
+
+    // Texel block width/height and size in bytes of the formats DDS can hold
+    bool blockInfo( vk::Format format, uint32_t& blockDim, uint32_t& blockBytes )
+    {
+      switch ( format )
+      {
+      case vk::Format::eBc1RgbUnormBlock:
+      case vk::Format::eBc1RgbSrgbBlock:
+      case vk::Format::eBc1RgbaUnormBlock:
+      case vk::Format::eBc1RgbaSrgbBlock:
+      case vk::Format::eBc4UnormBlock:
+      case vk::Format::eBc4SnormBlock:
+        blockDim = 4;
+        blockBytes = 8;
+        return true;
+      case vk::Format::eBc2UnormBlock:
+      case vk::Format::eBc2SrgbBlock:
+      case vk::Format::eBc3UnormBlock:
+      case vk::Format::eBc3SrgbBlock:
+      case vk::Format::eBc5UnormBlock:
+      case vk::Format::eBc5SnormBlock:
+      case vk::Format::eBc6HUfloatBlock:
+      case vk::Format::eBc6HSfloatBlock:
+      case vk::Format::eBc7UnormBlock:
+      case vk::Format::eBc7SrgbBlock:
+        blockDim = 4;
+        blockBytes = 16;
+        return true;
+      case vk::Format::eR8G8B8A8Unorm:
+      case vk::Format::eR8G8B8A8Srgb:
+      case vk::Format::eB8G8R8A8Unorm:
+      case vk::Format::eB8G8R8A8Srgb:
+        blockDim = 1;
+        blockBytes = 4;
+        return true;
+      case vk::Format::eR16G16B16A16Sfloat:
+        blockDim = 1;
+        blockBytes = 8;
+        return true;
+      case vk::Format::eR32G32B32A32Sfloat:
+        blockDim = 1;
+        blockBytes = 16;
+        return true;
+      default:
+        return false;
+      }
+    }
+
+    vk::DeviceSize levelSize( uint32_t width, uint32_t height, uint32_t level,
+      uint32_t blockDim, uint32_t blockBytes )
+    {
+      uint32_t w = std::max( width >> level, 1u );
+      uint32_t h = std::max( height >> level, 1u );
+      return vk::DeviceSize( ( w + blockDim - 1 ) / blockDim ) *
+        ( ( h + blockDim - 1 ) / blockDim ) * blockBytes;
+    }
+
+    // Header checks shared by both containers. Every subresource holds at
+    //    least one block, so dataSize bounds how many there can be.
+    void validateHeader( uint32_t width, uint32_t height, uint32_t mipLevels,
+      uint32_t layerCount, uint32_t blockBytes, size_t dataSize )
+    {
+      if ( width == 0 || width > MAX_DIMENSION || height > MAX_DIMENSION )
+      {
+        throw std::runtime_error( "CompressedTexture: invalid image size" );
+      }
+      if ( uint64_t( mipLevels ) * layerCount > dataSize / blockBytes )
+      {
+        throw std::runtime_error( "CompressedTexture: truncated file" );
+      }
+      uint32_t maxLevels = 1;
+      while ( ( std::max( width, height ) >> maxLevels ) != 0 )
+      {
+        ++maxLevels;
+      }
+      if ( mipLevels > maxLevels )
+      {
+        throw std::runtime_error( "CompressedTexture: too many mip levels" );
+      }
+    }
+
+    vk::Format formatFromDXGI( uint32_t dxgiFormat )
+    {
+      switch ( dxgiFormat )
+      {
+      case 2: return vk::Format::eR32G32B32A32Sfloat;
+      case 10: return vk::Format::eR16G16B16A16Sfloat;
+      case 28: return vk::Format::eR8G8B8A8Unorm;
+      case 29: return vk::Format::eR8G8B8A8Srgb;
+      case 71: return vk::Format::eBc1RgbaUnormBlock;
+      case 72: return vk::Format::eBc1RgbaSrgbBlock;
+      case 74: return vk::Format::eBc2UnormBlock;
+      case 75: return vk::Format::eBc2SrgbBlock;
+      case 77: return vk::Format::eBc3UnormBlock;
+      case 78: return vk::Format::eBc3SrgbBlock;
+      case 80: return vk::Format::eBc4UnormBlock;
+      case 81: return vk::Format::eBc4SnormBlock;
+      case 83: return vk::Format::eBc5UnormBlock;
+      case 84: return vk::Format::eBc5SnormBlock;
+      case 87: return vk::Format::eB8G8R8A8Unorm;
+      case 91: return vk::Format::eB8G8R8A8Srgb;
+      case 95: return vk::Format::eBc6HUfloatBlock;
+      case 96: return vk::Format::eBc6HSfloatBlock;
+      case 98: return vk::Format::eBc7UnormBlock;
+      case 99: return vk::Format::eBc7SrgbBlock;
+      default: return vk::Format::eUndefined;
+      }
+    }
+
+    void expand565( uint16_t color, unsigned char* rgba )
+    {
+      uint32_t r = ( color >> 11 ) & 0x1F;
+      uint32_t g = ( color >> 5 ) & 0x3F;
+      uint32_t b = color & 0x1F;
+      rgba[ 0 ] = static_cast< unsigned char >( ( r << 3 ) | ( r >> 2 ) );
+      rgba[ 1 ] = static_cast< unsigned char >( ( g << 2 ) | ( g >> 4 ) );
+      rgba[ 2 ] = static_cast< unsigned char >( ( b << 3 ) | ( b >> 2 ) );
+      rgba[ 3 ] = 255;
+    }
+
+    // BC1 color block. BC2 and BC3 always use the four color mode.
+    void decodeColorBlock( const unsigned char* block, unsigned char* rgba,
+      bool fourColors )
+    {
+      uint16_t c0 = uint16_t( block[ 0 ] | ( block[ 1 ] << 8 ) );
+      uint16_t c1 = uint16_t( block[ 2 ] | ( block[ 3 ] << 8 ) );
+
+      unsigned char palette[ 4 ][ 4 ];
+      expand565( c0, palette[ 0 ] );
+      expand565( c1, palette[ 1 ] );
+      if ( fourColors || c0 > c1 )
+      {
+        for ( int c = 0; c < 3; ++c )
+        {
+          palette[ 2 ][ c ] = static_cast< unsigned char >(
+            ( 2 * palette[ 0 ][ c ] + palette[ 1 ][ c ] ) / 3 );
+          palette[ 3 ][ c ] = static_cast< unsigned char >(
+            ( palette[ 0 ][ c ] + 2 * palette[ 1 ][ c ] ) / 3 );
+        }
+        palette[ 2 ][ 3 ] = palette[ 3 ][ 3 ] = 255;
+      }
+      else
+      {
+        for ( int c = 0; c < 3; ++c )
+        {
+          palette[ 2 ][ c ] = static_cast< unsigned char >(
+            ( palette[ 0 ][ c ] + palette[ 1 ][ c ] ) / 2 );
+        }
+        palette[ 2 ][ 3 ] = 255;
+        memset( palette[ 3 ], 0, 4 );
+      }
+
+      uint32_t indices = uint32_t( block[ 4 ] ) | ( uint32_t( block[ 5 ] ) << 8 ) |
+        ( uint32_t( block[ 6 ] ) << 16 ) | ( uint32_t( block[ 7 ] ) << 24 );
+      for ( uint32_t i = 0; i < 16; ++i )
+      {
+        memcpy( rgba + 4 * i, palette[ ( indices >> ( 2 * i ) ) & 3 ], 4 );
+      }
+    }
+
+    // BC3 alpha block, also the BC4 red and BC5 red/green blocks. Signed
+    //    blocks write two's complement bytes for an SNORM target.
+    void decodeChannelBlock( const unsigned char* block, unsigned char* rgba,
+      uint32_t channel, bool isSigned )
+    {
+      int a0 = block[ 0 ];
+      int a1 = block[ 1 ];
+      if ( isSigned )
+      {
+        // -128 and -127 both mean -1.0
+        a0 = std::max( int( int8_t( block[ 0 ] ) ), -127 );
+        a1 = std::max( int( int8_t( block[ 1 ] ) ), -127 );
+      }
+
+      int values[ 8 ];
+      values[ 0 ] = a0;
+      values[ 1 ] = a1;
+      if ( a0 > a1 )
+      {
+        for ( int i = 1; i < 7; ++i )
+        {
+          values[ i + 1 ] = ( ( 7 - i ) * a0 + i * a1 ) / 7;
+        }
+      }
+      else
+      {
+        for ( int i = 1; i < 5; ++i )
+        {
+          values[ i + 1 ] = ( ( 5 - i ) * a0 + i * a1 ) / 5;
+        }
+        values[ 6 ] = isSigned ? -127 : 0;
+        values[ 7 ] = isSigned ? 127 : 255;
+      }
+
+      uint64_t indices = 0;
+      for ( uint32_t i = 0; i < 6; ++i )
+      {
+        indices |= uint64_t( block[ 2 + i ] ) << ( 8 * i );
+      }
+      for ( uint32_t i = 0; i < 16; ++i )
+      {
+        rgba[ 4 * i + channel ] = static_cast< unsigned char >(
+          values[ ( indices >> ( 3 * i ) ) & 7 ] );
+      }
+    }
+
+    // Decodes one 4x4 block to 16 RGBA8 texels
+    void decodeBlock( vk::Format format, const unsigned char* block,
+      unsigned char* rgba )
+    {
+      switch ( format )
+      {
+      case vk::Format::eBc1RgbUnormBlock:
+      case vk::Format::eBc1RgbSrgbBlock:
+        decodeColorBlock( block, rgba, false );
+        for ( uint32_t i = 0; i < 16; ++i )
+        {
+          rgba[ 4 * i + 3 ] = 255;
+        }
+        break;
+      case vk::Format::eBc1RgbaUnormBlock:
+      case vk::Format::eBc1RgbaSrgbBlock:
+        decodeColorBlock( block, rgba, false );
+        break;
+      case vk::Format::eBc2UnormBlock:
+      case vk::Format::eBc2SrgbBlock:
+      {
+        decodeColorBlock( block + 8, rgba, true );
+        uint64_t alpha;
+        memcpy( &alpha, block, sizeof( alpha ) );
+        for ( uint32_t i = 0; i < 16; ++i )
+        {
+          rgba[ 4 * i + 3 ] = static_cast< unsigned char >(
+            ( ( alpha >> ( 4 * i ) ) & 0xF ) * 17 );
+        }
+        break;
+      }
+      case vk::Format::eBc3UnormBlock:
+      case vk::Format::eBc3SrgbBlock:
+        decodeColorBlock( block + 8, rgba, true );
+        decodeChannelBlock( block, rgba, 3, false );
+        break;
+      case vk::Format::eBc4UnormBlock:
+      case vk::Format::eBc4SnormBlock:
+      case vk::Format::eBc5UnormBlock:
+      case vk::Format::eBc5SnormBlock:
+      {
+        bool isSigned = format == vk::Format::eBc4SnormBlock ||
+          format == vk::Format::eBc5SnormBlock;
+        memset( rgba, 0, 64 );
+        decodeChannelBlock( block, rgba, 0, isSigned );
+        if ( format == vk::Format::eBc5UnormBlock ||
+          format == vk::Format::eBc5SnormBlock )
+        {
+          decodeChannelBlock( block + 8, rgba, 1, isSigned );
+        }
+        // 1.0 alpha: 127 in SNORM
+        for ( uint32_t i = 0; i < 16; ++i )
+        {
+          rgba[ 4 * i + 3 ] = isSigned ? 127 : 255;
+        }
+        break;
+      }
+      default:
+        assert( false && "format can't be decoded" );
+        break;
+      }
+    }
+
+    bool isSRGB( vk::Format format )
+    {
+      switch ( format )
+      {
+      case vk::Format::eBc1RgbSrgbBlock:
+      case vk::Format::eBc1RgbaSrgbBlock:
+      case vk::Format::eBc2SrgbBlock:
+      case vk::Format::eBc3SrgbBlock:
+        return true;
+      default:
+        return false;
+      }
+    }
+
+    bool isSNORM( vk::Format format )
+    {
+      return format == vk::Format::eBc4SnormBlock ||
+        format == vk::Format::eBc5SnormBlock;
+    }
+  }
+
+  CompressedImageData CompressedImageData::load( const std::string& filename )
+  {
+    std::ifstream file( filename, std::ios::binary );
+    if ( !file.is_open( ) )
+    {
+      throw std::runtime_error( "failed to open file!" );
+    }
+    char magic[ 4 ] = { };
+    file.read( magic, sizeof( magic ) );
+    file.close( );
+
+    if ( memcmp( magic, "DDS ", 4 ) == 0 )
+    {
+      return loadDDS( filename );
+    }
+    if ( memcmp( magic, "\xABKTX", 4 ) == 0 )
+    {
+      return loadKTX2( filename );
+    }
+    throw std::runtime_error( "CompressedTexture: unknown container" );
+  }
+
+  CompressedImageData CompressedImageData::loadKTX2( const std::string& filename )
+  {
+    static const unsigned char identifier[ 12 ] =
+    {
+      0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+    };
+    const size_t levelIndexOffset = 80;
+
+    std::vector<unsigned char> file = readFile( filename );
+    if ( file.size( ) < levelIndexOffset ||
+      memcmp( file.data( ), identifier, sizeof( identifier ) ) != 0 )
+    {
+      throw std::runtime_error( "CompressedTexture: not a KTX2 file" );
+    }
+
+    CompressedImageData image;
+    uint32_t vkFormat = readValue<uint32_t>( file, 12 );
+    image.width = readValue<uint32_t>( file, 20 );
+    image.height = std::max( readValue<uint32_t>( file, 24 ), 1u );
+    uint32_t depth = readValue<uint32_t>( file, 28 );
+    uint32_t layers = std::max( readValue<uint32_t>( file, 32 ), 1u );
+    uint32_t faces = readValue<uint32_t>( file, 36 );
+    // 0 asks the loader to generate the chain, keep the base level only
+    image.mipLevels = std::max( readValue<uint32_t>( file, 40 ), 1u );
+    uint32_t supercompression = readValue<uint32_t>( file, 44 );
+
+    if ( vkFormat == 0 )
+    {
+      throw std::runtime_error(
+        "CompressedTexture: KTX2 without a Vulkan format (Basis) not supported" );
+    }
+    if ( supercompression != 0 )
+    {
+      throw std::runtime_error(
+        "CompressedTexture: KTX2 supercompression not supported" );
+    }
+    if ( depth > 1 )
+    {
+      throw std::runtime_error( "CompressedTexture: 3D textures not supported" );
+    }
+    if ( ( faces != 0 && faces != 1 && faces != 6 ) || layers > MAX_LAYERS )
+    {
+      throw std::runtime_error( "CompressedTexture: invalid KTX2 layer count" );
+    }
+    image.format = static_cast< vk::Format >( vkFormat );
+    image.cubemap = faces == 6;
+    image.layerCount = layers * std::max( faces, 1u );
+
+    uint32_t blockDim, blockBytes;
+    if ( !blockInfo( image.format, blockDim, blockBytes ) )
+    {
+      throw std::runtime_error( "CompressedTexture: KTX2 format not supported" );
+    }
+    validateHeader( image.width, image.height, image.mipLevels,
+      image.layerCount, blockBytes, file.size( ) );
+
+    // The level index points at every level, each one holds layer x face images
+    image.subresources.reserve( image.mipLevels * image.layerCount );
+    for ( uint32_t level = 0; level < image.mipLevels; ++level )
+    {
+      size_t entry = levelIndexOffset + level * 24;
+      uint64_t byteOffset = readValue<uint64_t>( file, entry );
+      uint64_t byteLength = readValue<uint64_t>( file, entry + 8 );
+      if ( byteOffset > file.size( ) || byteLength > file.size( ) - byteOffset )
+      {
+        throw std::runtime_error( "CompressedTexture: truncated file" );
+      }
+      vk::DeviceSize faceSize = levelSize( image.width, image.height, level,
+        blockDim, blockBytes );
+      if ( byteLength % image.layerCount != 0 ||
+        byteLength / image.layerCount != faceSize )
+      {
+        throw std::runtime_error(
+          "CompressedTexture: KTX2 level size doesn't match its format" );
+      }
+      for ( uint32_t layer = 0; layer < image.layerCount; ++layer )
+      {
+        Subresource subresource;
+        subresource.level = level;
+        subresource.layer = layer;
+        subresource.offset = image.data.size( );
+        subresource.size = faceSize;
+        image.subresources.push_back( subresource );
+
+        const unsigned char* src = file.data( ) + byteOffset + layer * faceSize;
+        image.data.insert( image.data.end( ), src, src + faceSize );
+      }
+    }
+    return image;
+  }
+
+  CompressedImageData CompressedImageData::loadDDS( const std::string& filename )
+  {
+    const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDPF_RGB = 0x40;
+    const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+    const uint32_t DDSCAPS2_CUBEMAP_ALLFACES = 0xFC00;
+    const uint32_t DDSCAPS2_VOLUME = 0x200000;
+    const uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+    const uint32_t DDS_DIMENSION_TEXTURE3D = 4;
+
+    std::vector<unsigned char> file = readFile( filename );
+    if ( file.size( ) < 128 || memcmp( file.data( ), "DDS ", 4 ) != 0 ||
+      readValue<uint32_t>( file, 4 ) != 124 )
+    {
+      throw std::runtime_error( "CompressedTexture: not a DDS file" );
+    }
+
+    CompressedImageData image;
+    uint32_t flags = readValue<uint32_t>( file, 8 );
+    image.height = std::max( readValue<uint32_t>( file, 12 ), 1u );
+    image.width = readValue<uint32_t>( file, 16 );
+    uint32_t mipMapCount = readValue<uint32_t>( file, 28 );
+    uint32_t pixelFlags = readValue<uint32_t>( file, 80 );
+    uint32_t pixelFourCC = readValue<uint32_t>( file, 84 );
+    uint32_t rgbBitCount = readValue<uint32_t>( file, 88 );
+    uint32_t redMask = readValue<uint32_t>( file, 92 );
+    uint32_t caps2 = readValue<uint32_t>( file, 112 );
+
+    image.mipLevels = ( flags & DDSD_MIPMAPCOUNT ) ?
+      std::max( mipMapCount, 1u ) : 1;
+
+    size_t dataOffset = 128;
+    if ( ( pixelFlags & DDPF_FOURCC ) && pixelFourCC == fourCC( 'D', 'X', '1', '0' ) )
+    {
+      image.format = formatFromDXGI( readValue<uint32_t>( file, 128 ) );
+      uint32_t dimension = readValue<uint32_t>( file, 132 );
+      uint32_t miscFlag = readValue<uint32_t>( file, 136 );
+      uint32_t arraySize = std::max( readValue<uint32_t>( file, 140 ), 1u );
+      if ( dimension == DDS_DIMENSION_TEXTURE3D )
+      {
+        throw std::runtime_error( "CompressedTexture: 3D textures not supported" );
+      }
+      if ( arraySize > MAX_LAYERS )
+      {
+        throw std::runtime_error( "CompressedTexture: invalid DDS array size" );
+      }
+      image.cubemap = ( miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE ) != 0;
+      image.layerCount = arraySize * ( image.cubemap ? 6 : 1 );
+      dataOffset = 148;
+    }
+    else
+    {
+      if ( caps2 & DDSCAPS2_VOLUME )
+      {
+        throw std::runtime_error( "CompressedTexture: 3D textures not supported" );
+      }
+      if ( caps2 & DDSCAPS2_CUBEMAP )
+      {
+        if ( ( caps2 & DDSCAPS2_CUBEMAP_ALLFACES ) != DDSCAPS2_CUBEMAP_ALLFACES )
+        {
+          throw std::runtime_error(
+            "CompressedTexture: partial cubemaps not supported" );
+        }
+        image.cubemap = true;
+        image.layerCount = 6;
+      }
+
+      if ( pixelFlags & DDPF_FOURCC )
+      {
+        if ( pixelFourCC == fourCC( 'D', 'X', 'T', '1' ) )
+        {
+          image.format = vk::Format::eBc1RgbaUnormBlock;
+        }
+        else if ( pixelFourCC == fourCC( 'D', 'X', 'T', '2' ) ||
+          pixelFourCC == fourCC( 'D', 'X', 'T', '3' ) )
+        {
+          image.format = vk::Format::eBc2UnormBlock;
+        }
+        else if ( pixelFourCC == fourCC( 'D', 'X', 'T', '4' ) ||
+          pixelFourCC == fourCC( 'D', 'X', 'T', '5' ) )
+        {
+          image.format = vk::Format::eBc3UnormBlock;
+        }
+        else if ( pixelFourCC == fourCC( 'A', 'T', 'I', '1' ) ||
+          pixelFourCC == fourCC( 'B', 'C', '4', 'U' ) )
+        {
+          image.format = vk::Format::eBc4UnormBlock;
+        }
+        else if ( pixelFourCC == fourCC( 'B', 'C', '4', 'S' ) )
+        {
+          image.format = vk::Format::eBc4SnormBlock;
+        }
+        else if ( pixelFourCC == fourCC( 'A', 'T', 'I', '2' ) ||
+          pixelFourCC == fourCC( 'B', 'C', '5', 'U' ) )
+        {
+          image.format = vk::Format::eBc5UnormBlock;
+        }
+        else if ( pixelFourCC == fourCC( 'B', 'C', '5', 'S' ) )
+        {
+          image.format = vk::Format::eBc5SnormBlock;
+        }
+        else if ( pixelFourCC == 113 )  // D3DFMT_A16B16G16R16F
+        {
+          image.format = vk::Format::eR16G16B16A16Sfloat;
+        }
+        else if ( pixelFourCC == 116 )  // D3DFMT_A32B32G32R32F
+        {
+          image.format = vk::Format::eR32G32B32A32Sfloat;
+        }
+      }
+      else if ( ( pixelFlags & DDPF_RGB ) && rgbBitCount == 32 )
+      {
+        image.format = redMask == 0x000000FF ?
+          vk::Format::eR8G8B8A8Unorm : vk::Format::eB8G8R8A8Unorm;
+      }
+    }
+
+    uint32_t blockDim, blockBytes;
+    if ( !blockInfo( image.format, blockDim, blockBytes ) )
+    {
+      throw std::runtime_error( "CompressedTexture: DDS format not supported" );
+    }
+    if ( dataOffset > file.size( ) )
+    {
+      throw std::runtime_error( "CompressedTexture: truncated file" );
+    }
+    validateHeader( image.width, image.height, image.mipLevels,
+      image.layerCount, blockBytes, file.size( ) - dataOffset );
+
+    // Layers are stored one after another, each with its whole mip chain
+    vk::DeviceSize offset = 0;
+    image.subresources.reserve( image.layerCount * image.mipLevels );
+    for ( uint32_t layer = 0; layer < image.layerCount; ++layer )
+    {
+      for ( uint32_t level = 0; level < image.mipLevels; ++level )
+      {
+        Subresource subresource;
+        subresource.level = level;
+        subresource.layer = layer;
+        subresource.offset = offset;
+        subresource.size = levelSize( image.width, image.height, level,
+          blockDim, blockBytes );
+        // Checked per subresource so a bogus layer count stops early
+        if ( subresource.size > file.size( ) - dataOffset - offset )
+        {
+          throw std::runtime_error( "CompressedTexture: truncated file" );
+        }
+        image.subresources.push_back( subresource );
+
+        offset += subresource.size;
+      }
+    }
+    image.data.assign( file.begin( ) + dataOffset,
+      file.begin( ) + dataOffset + offset );
+    return image;
+  }
+
+  bool CompressedImageData::canDecode( vk::Format format )
+  {
+    switch ( format )
+    {
+    case vk::Format::eBc1RgbUnormBlock:
+    case vk::Format::eBc1RgbSrgbBlock:
+    case vk::Format::eBc1RgbaUnormBlock:
+    case vk::Format::eBc1RgbaSrgbBlock:
+    case vk::Format::eBc2UnormBlock:
+    case vk::Format::eBc2SrgbBlock:
+    case vk::Format::eBc3UnormBlock:
+    case vk::Format::eBc3SrgbBlock:
+    case vk::Format::eBc4UnormBlock:
+    case vk::Format::eBc4SnormBlock:
+    case vk::Format::eBc5UnormBlock:
+    case vk::Format::eBc5SnormBlock:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  CompressedImageData CompressedImageData::decodeRGBA8( void ) const
+  {
+    if ( !canDecode( format ) )
+    {
+      throw std::runtime_error( "CompressedTexture: format can't be decoded" );
+    }
+
+    CompressedImageData image;
+    image.format = isSRGB( format ) ? vk::Format::eR8G8B8A8Srgb :
+      isSNORM( format ) ? vk::Format::eR8G8B8A8Snorm :
+      vk::Format::eR8G8B8A8Unorm;
+    image.width = width;
+    image.height = height;
+    image.mipLevels = mipLevels;
+    image.layerCount = layerCount;
+    image.cubemap = cubemap;
+    image.subresources.reserve( subresources.size( ) );
+
+    uint32_t blockDim, blockBytes;
+    blockInfo( format, blockDim, blockBytes );
+
+    unsigned char texels[ 64 ];
+    for ( const auto& src : subresources )
+    {
+      uint32_t w = std::max( width >> src.level, 1u );
+      uint32_t h = std::max( height >> src.level, 1u );
+      uint32_t blocksX = ( w + 3 ) / 4;
+      uint32_t blocksY = ( h + 3 ) / 4;
+      // The image may not come from load, don't read past its data
+      vk::DeviceSize needed = vk::DeviceSize( blocksX ) * blocksY * blockBytes;
+      if ( src.size < needed || src.offset > data.size( ) ||
+        needed > data.size( ) - src.offset )
+      {
+        throw std::runtime_error(
+          "CompressedTexture: subresource smaller than its level" );
+      }
+
+      Subresource dst = src;
+      dst.offset = image.data.size( );
+      dst.size = vk::DeviceSize( w ) * h * 4;
+      image.data.resize( dst.offset + dst.size );
+      image.subresources.push_back( dst );
+
+      const unsigned char* block = data.data( ) + src.offset;
+      unsigned char* pixels = image.data.data( ) + dst.offset;
+      for ( uint32_t by = 0; by < blocksY; ++by )
+      {
+        for ( uint32_t bx = 0; bx < blocksX; ++bx, block += blockBytes )
+        {
+          decodeBlock( format, block, texels );
+
+          // Edge blocks of levels not multiple of 4 are clipped
+          uint32_t rows = std::min( 4u, h - by * 4 );
+          uint32_t cols = std::min( 4u, w - bx * 4 );
+          for ( uint32_t y = 0; y < rows; ++y )
+          {
+            memcpy( pixels + ( ( by * 4 + y ) * w + bx * 4 ) * 4,
+              texels + y * 16, cols * 4 );
+          }
+        }
+      }
+    }
+    return image;
+  }
+
+  CompressedTexture::CompressedTexture( const std::shared_ptr<Device>& device_,
+    const std::string& filename, const std::shared_ptr<CommandPool>& cmdPool,
+    const std::shared_ptr<Queue>& queue, vk::ImageUsageFlags imageUsageFlags_,
+    vk::ImageLayout imageLayout_ )
+    : Texture( device_ )
+  {
+    CompressedImageData file = CompressedImageData::load( filename );
+    std::vector<vk::BufferImageCopy> regions = createImage( file,
+      imageUsageFlags_, imageLayout_ );
+
+    auto copyCmd = cmdPool->allocateCommandBuffer( );
+    copyCmd->begin( vk::CommandBufferUsageFlagBits::eOneTimeSubmit );
+
+    StagingRegion staging = _device->getStagingRing( )->write( *copyCmd,
+      file.data.data( ), file.data.size( ) );
+
+    vk::ImageSubresourceRange subresourceRange(
+      vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, layerCount );
+    utils::transitionImageLayout( copyCmd, image, vk::ImageLayout::eUndefined,
+      vk::ImageLayout::eTransferDstOptimal, subresourceRange );
+    copyCmd->copyBufferToImage( staging, image,
+      vk::ImageLayout::eTransferDstOptimal, regions );
+    utils::transitionImageLayout( copyCmd, image,
+      vk::ImageLayout::eTransferDstOptimal, imageLayout, subresourceRange );
+
+    copyCmd->end( );
+
+    queue->submitAndWait( copyCmd );
+
+    createView( file );
+  }
+
+  CompressedTexture::CompressedTexture( const std::shared_ptr<Device>& device_,
+    const std::string& filename, const std::shared_ptr<UploadEngine>& uploader,
+    vk::ImageUsageFlags imageUsageFlags_, vk::ImageLayout imageLayout_ )
+    : Texture( device_ )
+  {
+    CompressedImageData file = CompressedImageData::load( filename );
+    std::vector<vk::BufferImageCopy> regions = createImage( file,
+      imageUsageFlags_, imageLayout_ );
+
+    uploader->upload( image, file.data.data( ), file.data.size( ), regions,
+      vk::ImageSubresourceRange( vk::ImageAspectFlagBits::eColor, 0,
+        mipLevels, 0, layerCount ), imageLayout );
+
+    createView( file );
+  }
+
+  bool CompressedTexture::isFormatSupported(
+    const std::shared_ptr<Device>& device, vk::Format format )
+  {
+    const vk::PhysicalDeviceFeatures& features = device->getEnabledFeatures( );
+    VkFormat f = static_cast< VkFormat >( format );
+    if ( f >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && f <= VK_FORMAT_BC7_SRGB_BLOCK &&
+      !features.textureCompressionBC )
+    {
+      return false;
+    }
+    if ( f >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK &&
+      f <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK && !features.textureCompressionETC2 )
+    {
+      return false;
+    }
+    if ( f >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK &&
+      f <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK && !features.textureCompressionASTC_LDR )
+    {
+      return false;
+    }
+    vk::FormatProperties props =
+      device->getPhysicalDevice( )->getFormatProperties( format );
+    return static_cast< bool >( props.optimalTilingFeatures &
+      vk::FormatFeatureFlagBits::eSampledImage );
+  }
+
+  std::vector<vk::BufferImageCopy> CompressedTexture::createImage(
+    CompressedImageData& file, vk::ImageUsageFlags imageUsageFlags_,
+    vk::ImageLayout imageLayout_ )
+  {
+    _decoded = false;
+    if ( !isFormatSupported( _device, file.format ) )
+    {
+      if ( !CompressedImageData::canDecode( file.format ) )
+      {
+        throw std::runtime_error(
+          "CompressedTexture: format not supported by the device" );
+      }
+      file = file.decodeRGBA8( );
+      _decoded = true;
+    }
+
+    _format = file.format;
+    width = file.width;
+    height = file.height;
+    mipLevels = file.mipLevels;
+    layerCount = file.layerCount;
+    imageLayout = imageLayout_;
+
+    vk::ImageCreateFlags createFlags;
+    if ( file.cubemap )
+    {
+      createFlags |= vk::ImageCreateFlagBits::eCubeCompatible;
+    }
+    image = _device->createImage( createFlags, vk::ImageType::e2D, _format,
+      vk::Extent3D( width, height, 1 ), mipLevels, layerCount,
+      vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+      imageUsageFlags_ | vk::ImageUsageFlagBits::eTransferDst,
+      vk::SharingMode::eExclusive, { }, vk::ImageLayout::eUndefined,
+      vk::MemoryPropertyFlagBits::eDeviceLocal );
+
+    std::vector<vk::BufferImageCopy> regions;
+    regions.reserve( file.subresources.size( ) );
+    for ( const auto& subresource : file.subresources )
+    {
+      vk::BufferImageCopy region;
+      region.bufferOffset = subresource.offset;
+      region.imageSubresource = vk::ImageSubresourceLayers(
+        vk::ImageAspectFlagBits::eColor, subresource.level, subresource.layer, 1 );
+      region.imageExtent = vk::Extent3D(
+        std::max( width >> subresource.level, 1u ),
+        std::max( height >> subresource.level, 1u ), 1 );
+      regions.push_back( region );
+    }
+    return regions;
+  }
+
+  void CompressedTexture::createView( const CompressedImageData& file )
+  {
+    vk::ImageViewType viewType = vk::ImageViewType::e2D;
+    if ( file.cubemap )
+    {
+      viewType = layerCount > 6 ?
+        vk::ImageViewType::eCubeArray : vk::ImageViewType::eCube;
+    }
+    else if ( layerCount > 1 )
+    {
+      viewType = vk::ImageViewType::e2DArray;
+    }
+    vk::SamplerAddressMode addressMode = file.cubemap ?
+      vk::SamplerAddressMode::eClampToEdge : vk::SamplerAddressMode::eRepeat;
+
+    sampler = _device->createSampler( vk::Filter::eLinear, vk::Filter::eLinear,
+      vk::SamplerMipmapMode::eLinear, addressMode, addressMode, addressMode,
+      0.0f, true, 1.0f, false, vk::CompareOp::eNever, 0.0f,
+      static_cast< float >( mipLevels ), vk::BorderColor::eFloatOpaqueWhite,
+      false );
+
+    view = image->createImageView( viewType, _format,
+      vk::ComponentMapping( vk::ComponentSwizzle::eR, vk::ComponentSwizzle::eG,
+        vk::ComponentSwizzle::eB, vk::ComponentSwizzle::eA ),
+      vk::ImageSubresourceRange( vk::ImageAspectFlagBits::eColor, 0,
+        mipLevels, 0, layerCount ) );
+
+    updateDescriptor( );
+  }
+}
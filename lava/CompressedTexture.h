@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_COMPRESSED_TEXTURE__
+#define __LAVA_COMPRESSED_TEXTURE__
+
+#include "includes.hpp"
+
+#include "Texture.h"
+
+#include <lava/api.h>
+
+namespace lava
+{
+  class CommandPool;
+  class Queue;
+  class UploadEngine;
+
+  /**
+  * Contents of a KTX2 or DDS file. Subresources are packed in data in copy
+  *   order and keep the layout of the file format (block compressed formats
+  *   stay compressed). Cubemap faces count as layers.
+  */
+  struct CompressedImageData
+  {
+    struct Subresource
+    {
+      uint32_t level;
+      uint32_t layer;
+      vk::DeviceSize offset;
+      vk::DeviceSize size;
+    };
+
+    vk::Format format = vk::Format::eUndefined;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipLevels = 1;
+    uint32_t layerCount = 1;
+    bool cubemap = false;
+    std::vector<unsigned char> data;
+    std::vector<Subresource> subresources;
+
+    // Picks the container from the file signature. Throws on error.
+    LAVA_API
+    static CompressedImageData load( const std::string& filename );
+    LAVA_API
+    static CompressedImageData loadKTX2( const std::string& filename );
+    LAVA_API
+    static CompressedImageData loadDDS( const std::string& filename );
+
+    // True for the BC1 to BC5 formats, which decodeRGBA8 can decode
+    LAVA_API
+    static bool canDecode( vk::Format format );
+    // Decodes every subresource to RGBA8 (sRGB formats keep sRGB, BC4/BC5
+    //    SNORM decode to RGBA8 SNORM). Throws if it can't.
+    LAVA_API
+    CompressedImageData decodeRGBA8( void ) const;
+  };
+
+  /**
+  * Texture loaded from a KTX2 or DDS file, with the mip chain stored in
+  *   the file. Block compressed data is uploaded as is; when the device
+  *   can't sample the format it is decoded to RGBA8 on the CPU first.
+  */
+  class CompressedTexture : public Texture
+  {
+  public:
+    LAVA_API
+    CompressedTexture( const std::shared_ptr<Device>& device,
+      const std::string& filename, const std::shared_ptr<CommandPool>& cmdPool,
+      const std::shared_ptr<Queue>& queue,
+      vk::ImageUsageFlags imageUsageFlags = vk::ImageUsageFlagBits::eSampled,
+      vk::ImageLayout imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal );
+    /**
+    * Records the upload on uploader without waiting. The texture can be
+    *   used once the token returned by the next uploader->flush( ) is done.
+    */
+    LAVA_API
+    CompressedTexture( const std::shared_ptr<Device>& device,
+      const std::string& filename, const std::shared_ptr<UploadEngine>& uploader,
+      vk::ImageUsageFlags imageUsageFlags = vk::ImageUsageFlagBits::eSampled,
+      vk::ImageLayout imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal );
+
+    // Format of the image, RGBA8 if the file had to be decoded
+    inline vk::Format getFormat( void ) const
+    {
+      return _format;
+    }
+    inline bool isDecoded( void ) const
+    {
+      return _decoded;
+    }
+
+    /**
+    * True if device can sample format with optimal tiling. Block compressed
+    *   formats also need their feature (textureCompressionBC) enabled.
+    */
+    LAVA_API
+    static bool isFormatSupported( const std::shared_ptr<Device>& device,
+      vk::Format format );
+  private:
+    // Decodes if needed, creates the image and returns the copy regions
+    std::vector<vk::BufferImageCopy> createImage( CompressedImageData& image,
+      vk::ImageUsageFlags imageUsageFlags, vk::ImageLayout imageLayout );
+    void createView( const CompressedImageData& image );
+
+    vk::Format _format;
+    bool _decoded;
+  };
+}
+
+#endif /* __LAVA_COMPRESSED_TEXTURE__ */
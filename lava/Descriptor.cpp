@@ -21,6 +21,8 @@
 
 #include "Device.h"
 
+#include <algorithm>
+
 namespace lava
 {
   DescriptorSetLayoutBinding::DescriptorSetLayoutBinding(
@@ -103,6 +105,18 @@ namespace lava
         dscptCount = samplers.back( ).size( );
       }
 
+      auto poolSize = std::find_if( _poolSizes.begin( ), _poolSizes.end( ),
+        [ &bind ]( const vk::DescriptorPoolSize& ps )
+        {
+          return ps.type == bind.descriptorType;
+        } );
+      if ( poolSize == _poolSizes.end( ) )
+      {
+        _poolSizes.push_back( vk::DescriptorPoolSize( bind.descriptorType, 0 ) );
+        poolSize = _poolSizes.end( ) - 1;
+      }
+      poolSize->descriptorCount += dscptCount;
+
       dslb.push_back( 
         vk::DescriptorSetLayoutBinding( 
           bind.binding, 
@@ -133,9 +147,9 @@ namespace lava
     vk::DescriptorPoolCreateFlags flags, uint32_t maxSets,
     vk::ArrayProxy<const vk::DescriptorPoolSize> poolSizes )
     : VulkanResource( device )
+    , _flags( flags )
+    , _maxSets( maxSets )
   {
-    // we need to set this bit to enable free on their descriptor sets
-    flags |= vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
     vk::DescriptorPoolCreateInfo dci(
       flags,
       maxSets,
@@ -154,30 +168,53 @@ namespace lava
 
   void DescriptorPool::reset( void )
   {
+    std::lock_guard<std::mutex> lock( _mutex );
     static_cast< vk::Device >( *_device ).resetDescriptorPool( _descriptorPool );
   }
 
+  vk::Result DescriptorPool::allocate( vk::DescriptorSetLayout layout,
+    vk::DescriptorSet& descriptorSet )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    vk::DescriptorSetAllocateInfo dci( _descriptorPool, 1, &layout );
+    return static_cast< vk::Device >( *_device ).allocateDescriptorSets(
+      &dci, &descriptorSet );
+  }
+
+  void DescriptorPool::free( vk::DescriptorSet descriptorSet )
+  {
+    assert( canFreeSets( ) );
+    std::lock_guard<std::mutex> lock( _mutex );
+    static_cast< vk::Device >( *_device ).freeDescriptorSets( _descriptorPool,
+      descriptorSet );
+  }
+
   DescriptorSet::DescriptorSet( const std::shared_ptr<Device>& device, 
     const std::shared_ptr<DescriptorPool>& descriptorPool,
     const std::shared_ptr<DescriptorSetLayout>& layout)
     : VulkanResource( device )
     , _descriptorPool( descriptorPool )
   {
-    vk::DescriptorSetLayout lay = *layout;
-    vk::DescriptorSetAllocateInfo dci( *_descriptorPool, 1, &lay );
-
-    std::vector< vk::DescriptorSet > vds = static_cast< vk::Device >( *_device)
-      .allocateDescriptorSets( dci );
-
-    assert( !vds.empty( ) );
+    vk::Result result = _descriptorPool->allocate( *layout, _descriptorSet );
+    vk::createResultValue( result, "lava::DescriptorSet::DescriptorSet" );
+  }
 
-    _descriptorSet = vds.front( );
+  DescriptorSet::DescriptorSet( const std::shared_ptr<Device>& device,
+    const std::shared_ptr<DescriptorPool>& descriptorPool,
+    vk::DescriptorSet descriptorSet )
+    : VulkanResource( device )
+    , _descriptorSet( descriptorSet )
+    , _descriptorPool( descriptorPool )
+  {
   }
 
   DescriptorSet::~DescriptorSet( void )
   {
-    static_cast< vk::Device > ( *_device ).freeDescriptorSets( *_descriptorPool, 
-      _descriptorSet );
+    // Sets of pools without the free flag go back on DescriptorPool::reset
+    if ( _descriptorPool->canFreeSets( ) )
+    {
+      _descriptorPool->free( _descriptorSet );
+    }
   }
   DescriptorImageInfo::DescriptorImageInfo( vk::ImageLayout imageLayout_, 
     const std::shared_ptr<ImageView>& imageView_, 
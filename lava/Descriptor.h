@@ -30,6 +30,8 @@
 #include <lava/Image.h>
 #include <lava/Sampler.h>
 
+#include <mutex>
+
 namespace lava
 {
   struct DescriptorSetLayoutBinding
@@ -67,9 +69,21 @@ namespace lava
     {
       return _descriptorSetLayout;
     }
+    LAVA_API
+    inline const std::vector<DescriptorSetLayoutBinding>& getBindings( void ) const
+    {
+      return _bindings;
+    }
+    // Descriptors of each type a set with this layout takes from its pool
+    LAVA_API
+    inline const std::vector<vk::DescriptorPoolSize>& getPoolSizes( void ) const
+    {
+      return _poolSizes;
+    }
   private:
     vk::DescriptorSetLayout _descriptorSetLayout;
     std::vector<DescriptorSetLayoutBinding> _bindings;
+    std::vector<vk::DescriptorPoolSize> _poolSizes;
   };
   class DescriptorPool : public VulkanResource, private NonCopyable<DescriptorPool>
   {
@@ -80,9 +94,32 @@ namespace lava
     LAVA_API
     ~DescriptorPool( void );
 
+    // Returns every set to the pool. Sets allocated from it become invalid.
     LAVA_API
     void reset( void );
 
+    /**
+    * Allocates a set without throwing: eErrorOutOfPoolMemory or
+    *   eErrorFragmentedPool tell the caller to try another pool.
+    */
+    LAVA_API
+    vk::Result allocate( vk::DescriptorSetLayout layout,
+      vk::DescriptorSet& descriptorSet );
+    // Only valid on pools created with eFreeDescriptorSet
+    LAVA_API
+    void free( vk::DescriptorSet descriptorSet );
+
+    LAVA_API
+    inline bool canFreeSets( void ) const
+    {
+      return !!( _flags & vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet );
+    }
+    LAVA_API
+    inline uint32_t getMaxSets( void ) const
+    {
+      return _maxSets;
+    }
+
     LAVA_API
     inline operator vk::DescriptorPool( void ) const
     {
@@ -91,6 +128,10 @@ namespace lava
 
   private:
     vk::DescriptorPool  _descriptorPool;
+    vk::DescriptorPoolCreateFlags _flags;
+    uint32_t _maxSets;
+    // Pools are externally synchronized: sets may be freed from any thread
+    std::mutex _mutex;
   };
 
   class DescriptorSet: public VulkanResource, private NonCopyable<DescriptorSet>
@@ -109,6 +150,13 @@ namespace lava
       return _descriptorSet;
     }
   protected:
+    friend class DescriptorAllocator;
+
+    // Wraps a set already allocated from descriptorPool
+    DescriptorSet( const std::shared_ptr<Device>& device,
+      const std::shared_ptr<DescriptorPool>& descriptorPool,
+      vk::DescriptorSet descriptorSet );
+
     vk::DescriptorSet _descriptorSet;
     std::shared_ptr< DescriptorPool > _descriptorPool;
   };
@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "DescriptorAllocator.h"
+
+#include "Descriptor.h"
+#include "Device.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace lava
+{
+  // Chained pools stop growing here, allocations keep chaining
+  static const uint32_t MAX_POOL_SETS = 4096;
+
+  DescriptorAllocator::DescriptorAllocator( const std::shared_ptr<Device>& device,
+    bool freeable, uint32_t initialSets )
+    : VulkanResource( device )
+    , _freeable( freeable )
+    , _nextPoolSets( std::max( initialSets, 1u ) )
+    , _currentPool( 0 )
+    , _setCount( 0 )
+  {
+  }
+
+  std::shared_ptr<DescriptorSet> DescriptorAllocator::allocate(
+    const std::shared_ptr<DescriptorSetLayout>& layout )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    ++_setCount;
+    for ( auto const& ps : layout->getPoolSizes( ) )
+    {
+      _descriptorCounts[ ps.type ] += ps.descriptorCount;
+    }
+
+    vk::DescriptorSet descriptorSet;
+    if ( !_pools.empty( ) )
+    {
+      if ( _pools[ _currentPool ]->allocate( *layout, descriptorSet ) ==
+        vk::Result::eSuccess )
+      {
+        return std::shared_ptr<DescriptorSet>( new DescriptorSet( _device,
+          _pools[ _currentPool ], descriptorSet ) );
+      }
+      // Sets freed since we moved on may have made room in older pools
+      for ( size_t i = 0; i < _pools.size( ); ++i )
+      {
+        if ( i == _currentPool || ( !_freeable && i < _currentPool ) )
+        {
+          continue;
+        }
+        if ( _pools[ i ]->allocate( *layout, descriptorSet ) ==
+          vk::Result::eSuccess )
+        {
+          _currentPool = i;
+          return std::shared_ptr<DescriptorSet>( new DescriptorSet( _device,
+            _pools[ i ], descriptorSet ) );
+        }
+      }
+      _nextPoolSets = std::min( _nextPoolSets * 2, MAX_POOL_SETS );
+    }
+
+    // A fresh pool sized from the usage above, and for this layout
+    _pools.push_back( createPool( _nextPoolSets, layout.get( ) ) );
+    _currentPool = _pools.size( ) - 1;
+    vk::Result result = _pools.back( )->allocate( *layout, descriptorSet );
+    vk::createResultValue( result, "lava::DescriptorAllocator::allocate" );
+    return std::shared_ptr<DescriptorSet>( new DescriptorSet( _device,
+      _pools.back( ), descriptorSet ) );
+  }
+
+  void DescriptorAllocator::reset( void )
+  {
+    assert( !_freeable );
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    if ( _pools.size( ) > 1 )
+    {
+      // Next frame needs as much as this one: replace the chain by one pool
+      uint32_t maxSets = 0;
+      for ( auto const& pool : _pools )
+      {
+        maxSets += pool->getMaxSets( );
+      }
+      _nextPoolSets = std::max( _nextPoolSets, maxSets );
+      _pools.clear( );
+      _pools.push_back( createPool( _nextPoolSets, nullptr ) );
+    }
+    else if ( !_pools.empty( ) )
+    {
+      _pools.front( )->reset( );
+    }
+    _currentPool = 0;
+  }
+
+  size_t DescriptorAllocator::getPoolCount( void ) const
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    return _pools.size( );
+  }
+
+  std::shared_ptr<DescriptorPool> DescriptorAllocator::createPool(
+    uint32_t maxSets, const DescriptorSetLayout* layout )
+  {
+    assert( _setCount > 0 );
+
+    // Each type gets its average count per set seen so far, times maxSets
+    std::vector<vk::DescriptorPoolSize> poolSizes;
+    poolSizes.reserve( _descriptorCounts.size( ) );
+    for ( auto const& dc : _descriptorCounts )
+    {
+      uint64_t count = ( dc.second * maxSets + _setCount - 1 ) / _setCount;
+      if ( layout )
+      {
+        // Averages may undercount a rare layout with many descriptors
+        for ( auto const& ps : layout->getPoolSizes( ) )
+        {
+          if ( ps.type == dc.first )
+          {
+            count = std::max< uint64_t >( count, ps.descriptorCount );
+          }
+        }
+      }
+      poolSizes.push_back( vk::DescriptorPoolSize( dc.first,
+        static_cast< uint32_t >( std::max< uint64_t >( count, 1 ) ) ) );
+    }
+
+    vk::DescriptorPoolCreateFlags flags;
+    if ( _freeable )
+    {
+      flags |= vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
+    }
+    return _device->createDescriptorPool( flags, maxSets, poolSizes );
+  }
+}
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_DESCRIPTOR_ALLOCATOR__
+#define __LAVA_DESCRIPTOR_ALLOCATOR__
+
+#include "includes.hpp"
+
+#include "VulkanResource.h"
+#include "noncopyable.hpp"
+
+#include <lava/api.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace lava
+{
+  class DescriptorPool;
+  class DescriptorSet;
+  class DescriptorSetLayout;
+
+  /**
+  * Hands out descriptor sets from a chain of pools. When the current pool
+  *   runs out a new one is created, sized from the descriptor types and
+  *   counts seen so far, so callers never have to guess pool sizes.
+  *
+  * Freeable allocators create pools with eFreeDescriptorSet and sets go back
+  *   to their pool when destroyed; use them for long-lived sets.
+  * Frame allocators skip the flag and are recycled with reset( ) once the
+  *   GPU is done with the frame, which costs one vkResetDescriptorPool.
+  *
+  * allocate and reset may be called from any thread.
+  */
+  class DescriptorAllocator : public VulkanResource,
+    private NonCopyable<DescriptorAllocator>
+  {
+  public:
+    LAVA_API
+    DescriptorAllocator( const std::shared_ptr<Device>& device, bool freeable,
+      uint32_t initialSets = 64 );
+
+    LAVA_API
+    std::shared_ptr<DescriptorSet> allocate(
+      const std::shared_ptr<DescriptorSetLayout>& layout );
+
+    /**
+    * Frame allocators only. Every set allocated since the last reset becomes
+    *   invalid. Pools chained during the frame are merged into a single
+    *   pool big enough for all of them.
+    */
+    LAVA_API
+    void reset( void );
+
+    LAVA_API
+    inline bool isFreeable( void ) const
+    {
+      return _freeable;
+    }
+    LAVA_API
+    size_t getPoolCount( void ) const;
+
+  protected:
+    // layout, when given, must fit in the new pool
+    std::shared_ptr<DescriptorPool> createPool( uint32_t maxSets,
+      const DescriptorSetLayout* layout );
+
+    bool _freeable;
+    uint32_t _nextPoolSets;
+    std::vector<std::shared_ptr<DescriptorPool>> _pools;
+    size_t _currentPool;
+
+    // Observed usage, drives the size of the next pool
+    std::map<vk::DescriptorType, uint64_t> _descriptorCounts;
+    uint64_t _setCount;
+
+    mutable std::mutex _mutex;
+  };
+}
+
+#endif /* __LAVA_DESCRIPTOR_ALLOCATOR__ */
@@ -21,22 +21,34 @@
 
 #include <lava/Buffer.h>
 #include <lava/CommandBuffer.h>
+#include <lava/CompressedTexture.h>
 #include <lava/Descriptor.h>
+#include <lava/DescriptorAllocator.h>
 #include <lava/Image.h>
+#include <lava/LayoutCache.h>
 #include <lava/Event.h>
 #include <lava/Fence.h>
+#include <lava/FrameCommandPool.h>
 #include <lava/Framebuffer.h>
 #include <lava/Pipeline.h>
 #include <lava/PhysicalDevice.h>
+#include <lava/PipelineCacheManager.h>
+#include <lava/PipelineStateCache.h>
 #include <lava/Queue.h>
 #include <lava/QueryPool.h>
 #include <lava/RenderPass.h>
 #include <lava/Semaphore.h>
+#include <lava/ShaderCache.h>
+#include <lava/RetirementQueue.h>
+#include <lava/StagingRing.h>
+#include <lava/SyncPool.h>
 #include <lava/Swapchain.h>
 #include <lava/Texture1D.h>
 #include <lava/Texture2D.h>
 #include <lava/Texture2DArray.h>
 #include <lava/TextureCubemap.h>
+#include <lava/UniformArena.h>
+#include <lava/UploadEngine.h>
 
 namespace lava
 {
@@ -73,6 +85,16 @@ namespace lava
   Device::~Device( void )
   {
     //_queues.clear();
+    // Staging regions of completed uploads go back before the pools
+    _stagingRing->reclaim( );
+    _retirementQueue.reset( );
+    _stagingRing.reset( );
+    _fencePool.reset( );
+    _semaphorePool.reset( );
+    _pipelineStateCache.reset( );
+    _layoutCache.reset( );
+    _shaderCache.reset( );
+    _allocator.reset( );
     _device.destroy( );
   }
   vk::Result Device::waitForFences(
@@ -96,6 +118,9 @@ namespace lava
   void Device::waitIdle( void )
   {
     _device.waitIdle( );
+    // Every fence is signaled now
+    _retirementQueue->collect( );
+    _stagingRing->reclaim( );
   }
 
   std::shared_ptr<Semaphore> Device::createSemaphore( void )
@@ -103,23 +128,29 @@ namespace lava
     return std::make_shared<Semaphore>( shared_from_this( ) );
   }
 
-  vk::DeviceMemory Device::allocateImageMemory( vk::Image image, 
-    vk::MemoryPropertyFlags flags )
+  std::shared_ptr<Semaphore> Device::acquireSemaphore( void )
+  {
+    return std::shared_ptr<Semaphore>( new Semaphore( shared_from_this( ),
+      _semaphorePool->acquire( ), _semaphorePool.get( ) ) );
+  }
+
+  MemoryAllocation Device::allocateImageMemory( vk::Image image, 
+    vk::MemoryPropertyFlags flags, bool linearTiling )
   {
     auto memReqs = _device.getImageMemoryRequirements( image );
-    auto mem = allocateMemReqMemory( memReqs, flags );
+    auto mem = _allocator->allocate( memReqs, flags, linearTiling );
 
-    _device.bindImageMemory( image, mem, 0 );
+    _device.bindImageMemory( image, mem.memory, mem.offset );
 
     return mem;
   }
-  vk::DeviceMemory Device::allocateBufferMemory( 
+  MemoryAllocation Device::allocateBufferMemory( 
     vk::Buffer buffer, vk::MemoryPropertyFlags flags )
   {
     auto memReqs = _device.getBufferMemoryRequirements( buffer );
-    auto mem = allocateMemReqMemory( memReqs, flags );
+    auto mem = _allocator->allocate( memReqs, flags, true );
 
-    _device.bindBufferMemory( buffer, mem, 0 );
+    _device.bindBufferMemory( buffer, mem.memory, mem.offset );
 
     return mem;
   }
@@ -143,10 +174,24 @@ namespace lava
   {
     _device.freeMemory( memory );
   }
+  void Device::freeMemory( MemoryAllocation& allocation )
+  {
+    _allocator->free( allocation );
+  }
+  MemoryStats Device::getMemoryStats( void ) const
+  {
+    return _allocator->getStats( );
+  }
   std::shared_ptr<Fence> Device::createFence( bool signaled )
   {
     return std::make_shared<Fence>( shared_from_this( ), signaled );
   }
+
+  std::shared_ptr<Fence> Device::acquireFence( void )
+  {
+    return std::shared_ptr<Fence>( new Fence( shared_from_this( ),
+      _fencePool->acquire( ), _fencePool.get( ) ) );
+  }
   std::shared_ptr<Sampler> Device::createSampler( vk::Filter magFilter,
     vk::Filter minFilter, vk::SamplerMipmapMode mipmapMode,
     vk::SamplerAddressMode addressModeU, vk::SamplerAddressMode addressModeV,
@@ -165,19 +210,41 @@ namespace lava
   {
     return std::make_shared<CommandPool>( shared_from_this( ), flags, famIdx );
   }
+
+  std::shared_ptr<FrameCommandPool> Device::createFrameCommandPool(
+    uint32_t familyIndex, uint32_t framesInFlight )
+  {
+    return std::make_shared<FrameCommandPool>( shared_from_this( ),
+      familyIndex, framesInFlight );
+  }
   std::shared_ptr<DescriptorSetLayout> Device::createDescriptorSetLayout(
     vk::ArrayProxy<const DescriptorSetLayoutBinding> bindings,
     vk::DescriptorSetLayoutCreateFlags flags )
   {
-    return std::make_shared<DescriptorSetLayout>( shared_from_this( ), 
-      bindings, flags );
+    return _layoutCache->getDescriptorSetLayout( bindings, flags, [ & ]( )
+    {
+      return std::make_shared<DescriptorSetLayout>( shared_from_this( ),
+        bindings, flags );
+    } );
   }
   std::shared_ptr<DescriptorPool> Device::createDescriptorPool(
-    /*vk::DescriptorPoolCreateFlags flags, */uint32_t maxSets,
+    vk::DescriptorPoolCreateFlags flags, uint32_t maxSets,
     vk::ArrayProxy<const vk::DescriptorPoolSize> poolSizes )
   {
     return std::make_shared<DescriptorPool>( shared_from_this( ),
-      vk::DescriptorPoolCreateFlags( ), maxSets, poolSizes );
+      flags, maxSets, poolSizes );
+  }
+  std::shared_ptr<DescriptorPool> Device::createDescriptorPool(
+    uint32_t maxSets, vk::ArrayProxy<const vk::DescriptorPoolSize> poolSizes )
+  {
+    return createDescriptorPool(
+      vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, maxSets, poolSizes );
+  }
+  std::shared_ptr<DescriptorAllocator> Device::createDescriptorAllocator(
+    bool freeable, uint32_t initialSets )
+  {
+    return std::make_shared<DescriptorAllocator>( shared_from_this( ),
+      freeable, initialSets );
   }
   std::shared_ptr<Image> Device::createImage( vk::ImageCreateFlags createFlags,
     vk::ImageType type, vk::Format format, const vk::Extent3D & extent,
@@ -226,6 +293,30 @@ namespace lava
       queueFamilyIndices, memPropFlags );
   }
 
+  std::shared_ptr<UniformArena> Device::createUniformArena(
+    vk::DeviceSize frameSize, uint32_t framesInFlight, vk::DeviceSize maxRange,
+    vk::ShaderStageFlags stages, uint32_t binding )
+  {
+    return std::make_shared<UniformArena>( shared_from_this( ), frameSize,
+      framesInFlight, maxRange, stages, binding );
+  }
+
+  std::shared_ptr<UploadEngine> Device::createUploadEngine(
+    uint32_t dstFamilyIndex )
+  {
+    uint32_t familyIndex = dstFamilyIndex;
+    for ( auto idx : _physicalDevice->getTransferQueueFamilyIndices( ) )
+    {
+      if ( _queues.find( idx ) != _queues.end( ) )
+      {
+        familyIndex = idx;
+        break;
+      }
+    }
+    return std::make_shared<UploadEngine>( shared_from_this( ),
+      getQueue( familyIndex, 0 ), dstFamilyIndex );
+  }
+
   std::shared_ptr<BufferView> Device::createBufferView( 
     std::shared_ptr<Buffer> buffer, vk::Format format, vk::DeviceSize offset,
     vk::DeviceSize size )
@@ -356,6 +447,12 @@ namespace lava
   {
     return std::make_shared<PipelineCache>( shared_from_this( ), src );
   }
+  std::shared_ptr<PipelineCacheManager> Device::createPipelineCacheManager(
+    const std::string& directory )
+  {
+    return std::make_shared<PipelineCacheManager>( shared_from_this( ),
+      directory );
+  }
   std::shared_ptr<Pipeline> Device::createGraphicsPipeline(
     const std::shared_ptr<PipelineCache>& pipelineCache,
     vk::PipelineCreateFlags flags,
@@ -374,11 +471,27 @@ namespace lava
     std::shared_ptr<Pipeline> const& basePipelineHandle,
     uint32_t basePipelineIndex )
   {
-    return std::make_shared<GraphicsPipeline>( shared_from_this( ), pipelineCache,
-      flags, stages, vertexInputState, inputAssemblyState, tessellationState,
-      viewportState, rasterizationState, multisampleState, depthStencilState,
-      colorBlendState, dynamicState, pipelineLayout, renderPass, subpass,
-      basePipelineHandle, basePipelineIndex );
+    auto create = [ & ]( )
+    {
+      return std::static_pointer_cast<Pipeline>( std::make_shared<GraphicsPipeline>(
+        shared_from_this( ), pipelineCache, flags, stages, vertexInputState,
+        inputAssemblyState, tessellationState, viewportState, rasterizationState,
+        multisampleState, depthStencilState, colorBlendState, dynamicState,
+        pipelineLayout, renderPass, subpass, basePipelineHandle,
+        basePipelineIndex ) );
+    };
+
+    std::string key;
+    PipelineStateCache::Dependencies dependencies;
+    if ( _pipelineStateCache->isEnabled( ) && PipelineStateCache::graphicsKey(
+      key, dependencies, flags, stages, vertexInputState, inputAssemblyState,
+      tessellationState, viewportState, rasterizationState, multisampleState,
+      depthStencilState, colorBlendState, dynamicState, pipelineLayout,
+      renderPass, subpass, basePipelineHandle, basePipelineIndex ) )
+    {
+      return _pipelineStateCache->getOrCreate( key, dependencies, create );
+    }
+    return create( );
   }
 
   std::shared_ptr<Pipeline> Device::createComputePipeline(
@@ -389,32 +502,54 @@ namespace lava
     std::shared_ptr<Pipeline> const& basePipelineHandle,
     uint32_t basePipelineIndex )
   {
-    return std::make_shared<ComputePipeline>( shared_from_this( ), pipelineCache,
-      flags, stage, pipelineLayout, basePipelineHandle, basePipelineIndex );
+    auto create = [ & ]( )
+    {
+      return std::static_pointer_cast<Pipeline>( std::make_shared<ComputePipeline>(
+        shared_from_this( ), pipelineCache, flags, stage, pipelineLayout,
+        basePipelineHandle, basePipelineIndex ) );
+    };
+
+    std::string key;
+    PipelineStateCache::Dependencies dependencies;
+    if ( _pipelineStateCache->isEnabled( ) && PipelineStateCache::computeKey(
+      key, dependencies, flags, stage, pipelineLayout, basePipelineHandle,
+      basePipelineIndex ) )
+    {
+      return _pipelineStateCache->getOrCreate( key, dependencies, create );
+    }
+    return create( );
   }
 
   std::shared_ptr<PipelineLayout> Device::createPipelineLayout(
     vk::ArrayProxy<const std::shared_ptr<DescriptorSetLayout>> setLayouts,
     vk::ArrayProxy<const vk::PushConstantRange> pushConstantRanges )
   {
-    return std::make_shared<PipelineLayout>( shared_from_this( ),
-      setLayouts, pushConstantRanges );
+    return _layoutCache->getPipelineLayout( setLayouts, pushConstantRanges,
+      [ & ]( )
+    {
+      return std::make_shared<PipelineLayout>( shared_from_this( ),
+        setLayouts, pushConstantRanges );
+    } );
   }
 
   std::shared_ptr<ShaderModule> Device::createShaderModule(
-    const std::string& filePath, vk::ShaderStageFlagBits type )
+    const std::string& filePath, vk::ShaderStageFlagBits )
   {
-    return std::make_shared<ShaderModule>( shared_from_this( ), filePath, type );
+    return createShaderModule( filePath );
   }
   std::shared_ptr<ShaderModule> Device::createShaderModule( 
     const std::string& filePath )
   {
-    return std::make_shared<ShaderModule>( shared_from_this( ), filePath );
+    ShaderCache::Code code = _shaderCache->readFile( filePath );
+    return createShaderModule( *code );
   }
   std::shared_ptr<ShaderModule> Device::createShaderModule( 
     vk::ArrayProxy<const uint32_t> code )
   {
-    return std::make_shared<ShaderModule>( shared_from_this( ), code );
+    return _shaderCache->getModule( code, [ & ]( )
+    {
+      return std::make_shared<ShaderModule>( shared_from_this( ), code );
+    } );
   }
   const PipelineShaderStageCreateInfo Device::createShaderPipelineShaderStage(
     const std::string& spvFile, vk::ShaderStageFlagBits stage,
@@ -469,6 +604,13 @@ namespace lava
     return std::make_shared<TextureCubemap>( shared_from_this( ), cubeImages,
       cmdPool, queue, format );
   }
+  std::shared_ptr<CompressedTexture> Device::createCompressedTexture(
+    const std::string& textureSrc, std::shared_ptr<CommandPool> cmdPool,
+    std::shared_ptr<Queue> queue )
+  {
+    return std::make_shared<CompressedTexture>( shared_from_this( ), textureSrc,
+      cmdPool, queue );
+  }
 #endif
   std::shared_ptr<QueryPool> Device::createQuery( vk::QueryPoolCreateFlags flags,
     vk::QueryType queryType, uint32_t entryCount,
@@ -531,6 +673,18 @@ namespace lava
       extensions.data( ),
       &enabledFeatures );
     _device = vk::PhysicalDevice( *_physicalDevice ).createDevice( dci );
+    _enabledFeatures = enabledFeatures;
+
+    _allocator.reset( new MemoryAllocator( _device,
+      _physicalDevice->getDeviceProperties( ),
+      _physicalDevice->getMemoryProperties( ) ) );
+    _stagingRing.reset( new StagingRing( _device, _allocator.get( ) ) );
+    _retirementQueue.reset( new RetirementQueue( ) );
+    _fencePool.reset( new FencePool( _device ) );
+    _semaphorePool.reset( new SemaphorePool( _device ) );
+    _pipelineStateCache.reset( new PipelineStateCache( ) );
+    _layoutCache.reset( new LayoutCache( ) );
+    _shaderCache.reset( new ShaderCache( ) );
 
     for ( auto const& ci : queueCreateInfos )
     {
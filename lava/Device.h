@@ -25,6 +25,7 @@
 #include "includes.hpp"
 
 #include <lava/noncopyable.hpp>
+#include <lava/MemoryAllocator.h>
 #include <memory>
 #include <map>
 
@@ -35,16 +36,26 @@ namespace lava
   class CommandPool;
   class Event;
   class Fence;
+  class FrameCommandPool;
   class Framebuffer;
   class Image;
   class ImageView;
+  class LayoutCache;
   class PhysicalDevice;
+  class PipelineCacheManager;
+  class PipelineStateCache;
   class Surface;
   class RenderPass;
   class Semaphore;
   class Sampler;
+  class StagingRing;
+  class FencePool;
+  class SemaphorePool;
   class Swapchain;
+  class UniformArena;
+  class UploadEngine;
   class Queue;
+  class RetirementQueue;
   class QueryPool;
 
   class UniformBuffer;
@@ -52,12 +63,14 @@ namespace lava
   class UniformTexelBuffer;
   class VertexBuffer;
   class IndexBuffer;
+  class CompressedTexture;
   class Texture2D;
   class Texture2DArray;
   class TextureCubemap;
 
   class DescriptorSetLayout;
   struct DescriptorSetLayoutBinding;
+  class DescriptorAllocator;
   class DescriptorPool;
   class DescriptorSet;
 
@@ -75,6 +88,7 @@ namespace lava
   struct PipelineColorBlendStateCreateInfo;
   struct PipelineDynamicStateCreateInfo;
 
+  class ShaderCache;
   class ShaderModule;
   struct PipelineShaderStageCreateInfo;
   struct SpecializationInfo;
@@ -112,6 +126,11 @@ namespace lava
     {
       return _physicalDevice;
     }
+    // Features the device was created with
+    inline const vk::PhysicalDeviceFeatures& getEnabledFeatures( void ) const
+    {
+      return _enabledFeatures;
+    }
 
     LAVA_API
     std::shared_ptr<Event> createEvent( void );
@@ -121,25 +140,34 @@ namespace lava
 
     LAVA_API
     std::shared_ptr<Semaphore> createSemaphore( void );
+    /**
+    * Returns a recycled semaphore. The handle goes back to the device pool
+    *   when the last reference drops, so it must not have a pending signal.
+    */
+    LAVA_API
+    std::shared_ptr<Semaphore> acquireSemaphore( void );
 
     /**
-    * Allocates memory for the provided image, and binds it to the image.
-    * Returns null if it cannot find memory with the specified flags.
+    * Sub-allocates memory for the provided image from the device allocator,
+    *   and binds it to the image. Throws if it cannot find memory with the
+    *   specified flags.
     */
     LAVA_API
-    vk::DeviceMemory allocateImageMemory( vk::Image image, 
-      vk::MemoryPropertyFlags flags );
+    MemoryAllocation allocateImageMemory( vk::Image image, 
+      vk::MemoryPropertyFlags flags, bool linearTiling = false );
 
     /**
-    * Allocates memory for the provided buffer, and binds it to the buffer.
-    * Returns null if it cannot find memory with the specified flags.
+    * Sub-allocates memory for the provided buffer from the device allocator,
+    *   and binds it to the buffer. Throws if it cannot find memory with the
+    *   specified flags.
     */
     LAVA_API
-    vk::DeviceMemory allocateBufferMemory( vk::Buffer buffer, 
+    MemoryAllocation allocateBufferMemory( vk::Buffer buffer, 
       vk::MemoryPropertyFlags flags );
 
     /**
     * Allocates a block of memory according to the provided memory requirements.
+    * This bypasses the allocator, so use it only for long-lived resources.
     * Returns null if it cannot find memory with the specified flags.
     */
     LAVA_API
@@ -149,9 +177,65 @@ namespace lava
     // Frees a previously allocated block of memory.
     LAVA_API
     void freeMemory( vk::DeviceMemory memory );
+    // Returns a sub-allocation to the device allocator.
+    LAVA_API
+    void freeMemory( MemoryAllocation& allocation );
+
+    LAVA_API
+    inline MemoryAllocator* getMemoryAllocator( void ) const
+    {
+      return _allocator.get( );
+    }
+    LAVA_API
+    MemoryStats getMemoryStats( void ) const;
+
+    // Shared upload buffer used by Buffer::update and the texture loaders.
+    LAVA_API
+    inline StagingRing* getStagingRing( void ) const
+    {
+      return _stagingRing.get( );
+    }
+
+    /**
+    * Keeps references to resources used by in-flight work. Queue::submit
+    *   retires its submit infos here and sweeps finished entries.
+    */
+    LAVA_API
+    inline RetirementQueue* getRetirementQueue( void ) const
+    {
+      return _retirementQueue.get( );
+    }
+
+    /**
+    * createGraphicsPipeline and createComputePipeline return the existing
+    *   pipeline when an identical one is still alive.
+    */
+    LAVA_API
+    inline PipelineStateCache* getPipelineStateCache( void ) const
+    {
+      return _pipelineStateCache.get( );
+    }
+    // createDescriptorSetLayout and createPipelineLayout share identical layouts
+    LAVA_API
+    inline LayoutCache* getLayoutCache( void ) const
+    {
+      return _layoutCache.get( );
+    }
+    /**
+    * createShaderModule reads each SPIR-V file once and shares modules with
+    *   equal code. Also stores compiled SPIR-V, see ShaderCache.
+    */
+    LAVA_API
+    inline ShaderCache* getShaderCache( void ) const
+    {
+      return _shaderCache.get( );
+    }
 
     LAVA_API
     std::shared_ptr<Fence> createFence( bool signaled );
+    // Returns a recycled unsignaled fence, reset when the last reference drops
+    LAVA_API
+    std::shared_ptr<Fence> acquireFence( void );
     LAVA_API
     std::shared_ptr<Sampler> createSampler( vk::Filter magFilter,
       vk::Filter minFilter, vk::SamplerMipmapMode mipmapMode,
@@ -164,6 +248,10 @@ namespace lava
     LAVA_API
     std::shared_ptr<CommandPool> createCommandPool( 
       vk::CommandPoolCreateFlags flags = { }, uint32_t familyIndex = 0 );
+    // Command pools reset wholesale once per frame in flight
+    LAVA_API
+    std::shared_ptr<FrameCommandPool> createFrameCommandPool(
+      uint32_t familyIndex, uint32_t framesInFlight );
 
     LAVA_API
     std::shared_ptr<DescriptorSetLayout> createDescriptorSetLayout(
@@ -171,8 +259,20 @@ namespace lava
       vk::DescriptorSetLayoutCreateFlags flags = { } );
     LAVA_API
     std::shared_ptr<DescriptorPool> createDescriptorPool(
-      /* TODO: CHECK !vk::DescriptorPoolCreateFlags flags, */uint32_t maxSets,
+      vk::DescriptorPoolCreateFlags flags, uint32_t maxSets,
       vk::ArrayProxy<const vk::DescriptorPoolSize> poolSizes );
+    // Pool whose sets can be freed individually (eFreeDescriptorSet)
+    LAVA_API
+    std::shared_ptr<DescriptorPool> createDescriptorPool( uint32_t maxSets,
+      vk::ArrayProxy<const vk::DescriptorPoolSize> poolSizes );
+    /**
+    * Chains descriptor pools sized from observed usage. Freeable allocators
+    *   return sets to their pool on destruction; the others only recycle
+    *   them on DescriptorAllocator::reset (one per frame in flight).
+    */
+    LAVA_API
+    std::shared_ptr<DescriptorAllocator> createDescriptorAllocator(
+      bool freeable, uint32_t initialSets = 64 );
 
     LAVA_API
     std::shared_ptr<Image> createImage( vk::ImageCreateFlags createFlags, 
@@ -210,6 +310,18 @@ namespace lava
       vk::ArrayProxy<const uint32_t> queueFamilyIndices,
       vk::MemoryPropertyFlags memoryPropertyFlags );
 
+    LAVA_API
+    std::shared_ptr<UniformArena> createUniformArena( vk::DeviceSize frameSize,
+      uint32_t framesInFlight, vk::DeviceSize maxRange,
+      vk::ShaderStageFlags stages, uint32_t binding = 0 );
+
+    /**
+    * Creates an upload engine on a dedicated transfer queue if one was
+    *   created with the device, or on the first queue of dstFamilyIndex.
+    */
+    LAVA_API
+    std::shared_ptr<UploadEngine> createUploadEngine( uint32_t dstFamilyIndex );
+
     LAVA_API
     std::shared_ptr<BufferView> createBufferView( std::shared_ptr<Buffer> buf,
       vk::Format format, vk::DeviceSize offset, vk::DeviceSize size );
@@ -255,6 +367,10 @@ namespace lava
     LAVA_API
     std::shared_ptr<PipelineCache> createPipelineCache( 
       const std::string& filePath );
+    // Pipeline cache persisted in directory, validated against this device
+    LAVA_API
+    std::shared_ptr<PipelineCacheManager> createPipelineCacheManager(
+      const std::string& directory );
 
     LAVA_API
     std::shared_ptr<Pipeline> createGraphicsPipeline(
@@ -333,6 +449,11 @@ namespace lava
       std::array< std::string, 6 >& cubeImages,
       std::shared_ptr<CommandPool> cmdPool, std::shared_ptr< Queue > queue,
       vk::Format format );
+    // KTX2 or DDS file, format and mip chain come from the file
+    LAVA_API
+    std::shared_ptr< CompressedTexture > createCompressedTexture(
+      const std::string& textureSrc, std::shared_ptr<CommandPool> cmdPool,
+      std::shared_ptr< Queue > queue );
 #endif
     LAVA_API
     std::shared_ptr<QueryPool> createQuery( vk::QueryPoolCreateFlags flags, 
@@ -355,7 +476,16 @@ namespace lava
   protected:
     vk::Device _device;
     std::shared_ptr<PhysicalDevice> _physicalDevice;
+    vk::PhysicalDeviceFeatures _enabledFeatures;
     std::map<uint32_t, std::vector<std::unique_ptr<Queue>>> _queues;
+    std::unique_ptr<MemoryAllocator> _allocator;
+    std::unique_ptr<StagingRing> _stagingRing;
+    std::unique_ptr<RetirementQueue> _retirementQueue;
+    std::unique_ptr<FencePool> _fencePool;
+    std::unique_ptr<SemaphorePool> _semaphorePool;
+    std::unique_ptr<PipelineStateCache> _pipelineStateCache;
+    std::unique_ptr<LayoutCache> _layoutCache;
+    std::unique_ptr<ShaderCache> _shaderCache;
   };
 }
 
@@ -19,10 +19,13 @@
 
 #include "Fence.h"
 
+#include <lava/SyncPool.h>
+
 namespace lava
 {
   Fence::Fence( const std::shared_ptr<Device>& device, bool signaled )
     : VulkanResource( device )
+    , _pool( nullptr )
   {
     vk::FenceCreateInfo fenceCreateInfo( signaled ?
       vk::FenceCreateFlagBits::eSignaled : vk::FenceCreateFlags( ) );
@@ -30,11 +33,26 @@ namespace lava
     _fence = static_cast< vk::Device >( *_device ).createFence( fenceCreateInfo );
   }
 
+  Fence::Fence( const std::shared_ptr<Device>& device, vk::Fence fence,
+    FencePool* pool )
+    : VulkanResource( device )
+    , _fence( fence )
+    , _pool( pool )
+  {
+  }
+
   Fence::~Fence( )
   {
     // From the spec:
     //    fence must not be associated with any queue command that has not yet completed execution on that queue
-    static_cast< vk::Device >( *_device ).destroyFence( _fence );
+    if ( _pool )
+    {
+      _pool->release( _fence );
+    }
+    else
+    {
+      static_cast< vk::Device >( *_device ).destroyFence( _fence );
+    }
   }
 
   bool Fence::isSignaled( ) const
@@ -30,6 +30,8 @@
 
 namespace lava
 {
+  class FencePool;
+
   class Fence
     : public VulkanResource
     , private NonCopyable< Fence >
@@ -60,7 +62,13 @@ namespace lava
       vk::ArrayProxy< const std::shared_ptr< Fence > > fences );
 
   private:
+    friend class Device;
+    // Wraps a pooled handle that goes back to the pool on destruction
+    Fence( const std::shared_ptr<Device>& device, vk::Fence fence,
+      FencePool* pool );
+
     vk::Fence _fence;
+    FencePool* _pool;
   };
 }
 
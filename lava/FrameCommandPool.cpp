@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "FrameCommandPool.h"
+
+namespace lava
+{
+  FrameCommandPool::FrameCommandPool( const std::shared_ptr<Device>& device,
+    uint32_t familyIndex, uint32_t framesInFlight )
+    : VulkanResource( device )
+    , _currentFrame( 0 )
+  {
+    _frames.resize( framesInFlight );
+    for ( auto& frame : _frames )
+    {
+      // Buffers are only reset with the pool, so the flag is not needed
+      frame.pool = _device->createCommandPool(
+        vk::CommandPoolCreateFlagBits::eTransient, familyIndex );
+      frame.usedPrimaries = 0;
+      frame.usedSecondaries = 0;
+    }
+  }
+
+  FrameCommandPool::~FrameCommandPool( void )
+  {
+    _frames.clear( );
+  }
+
+  void FrameCommandPool::beginFrame( uint32_t frameIndex )
+  {
+    assert( frameIndex < _frames.size( ) );
+    _currentFrame = frameIndex;
+
+    Frame& frame = _frames[ _currentFrame ];
+    if ( frame.usedPrimaries + frame.usedSecondaries > 0 )
+    {
+      frame.pool->reset( );
+    }
+    frame.usedPrimaries = 0;
+    frame.usedSecondaries = 0;
+  }
+
+  std::shared_ptr<CommandBuffer> FrameCommandPool::allocateCommandBuffer(
+    vk::CommandBufferLevel level )
+  {
+    Frame& frame = _frames[ _currentFrame ];
+
+    bool primary = ( level == vk::CommandBufferLevel::ePrimary );
+    auto& cache = primary ? frame.primaries : frame.secondaries;
+    size_t& used = primary ? frame.usedPrimaries : frame.usedSecondaries;
+
+    if ( used == cache.size( ) )
+    {
+      cache.push_back( frame.pool->allocateCommandBuffer( level ) );
+    }
+    return cache[ used++ ];
+  }
+}
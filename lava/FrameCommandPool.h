@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_FRAME_COMMAND_POOL__
+#define __LAVA_FRAME_COMMAND_POOL__
+
+#include "includes.hpp"
+
+#include "CommandBuffer.h"
+#include "VulkanResource.h"
+#include "noncopyable.hpp"
+
+#include <lava/api.h>
+
+#include <vector>
+
+namespace lava
+{
+  /**
+  * One command pool per frame in flight. beginFrame resets the whole pool
+  *   of that frame with vkResetCommandPool and allocateCommandBuffer hands
+  *   out the command buffers recorded the last time the frame was used, so
+  *   in steady state no command buffer is allocated or freed.
+  */
+  class FrameCommandPool
+    : public VulkanResource
+    , private NonCopyable<FrameCommandPool>
+  {
+  public:
+    LAVA_API
+    FrameCommandPool( const std::shared_ptr<Device>& device,
+      uint32_t familyIndex, uint32_t framesInFlight );
+    LAVA_API
+    virtual ~FrameCommandPool( void );
+
+    /**
+    * Resets the pool of frameIndex. The caller must ensure the GPU work
+    *   recorded on it the last time has finished.
+    */
+    LAVA_API
+    void beginFrame( uint32_t frameIndex );
+
+    // Returns a ready command buffer from the current frame pool
+    LAVA_API
+    std::shared_ptr<CommandBuffer> allocateCommandBuffer(
+      vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary );
+
+    LAVA_API
+    inline const std::shared_ptr<CommandPool>& getCurrentPool( void ) const
+    {
+      return _frames[ _currentFrame ].pool;
+    }
+    LAVA_API
+    inline uint32_t framesInFlight( void ) const
+    {
+      return static_cast< uint32_t >( _frames.size( ) );
+    }
+  protected:
+    struct Frame
+    {
+      std::shared_ptr<CommandPool> pool;
+      std::vector<std::shared_ptr<CommandBuffer>> primaries;
+      std::vector<std::shared_ptr<CommandBuffer>> secondaries;
+      size_t usedPrimaries;
+      size_t usedSecondaries;
+    };
+
+    std::vector<Frame> _frames;
+    uint32_t _currentFrame;
+  };
+}
+
+#endif /* __LAVA_FRAME_COMMAND_POOL__ */
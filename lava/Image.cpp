@@ -54,14 +54,8 @@ namespace lava
       _queueFamilyIndices.size( ), _queueFamilyIndices.data( ), initialLayout );
     _image = static_cast< vk::Device >( *_device ).createImage( createInfo );
 
-    auto memReqs = static_cast< vk::Device >( *_device )
-                        .getImageMemoryRequirements( _image );
-    uint32_t memoryTypeIndex = findMemoryType( _device->getPhysicalDevice( )
-                        ->getMemoryProperties( ), memReqs.memoryTypeBits, 
-                        _memoryPropertyFlags );
-    assert( memoryTypeIndex != uint32_t( -1 ) );
-    imageMemory = _device->allocateMemReqMemory( memReqs, _memoryPropertyFlags );
-    vk::Device( *_device ).bindImageMemory( _image, imageMemory, 0 );
+    imageMemory = _device->allocateImageMemory( _image, _memoryPropertyFlags,
+      _tiling == vk::ImageTiling::eLinear );
   }
   Image::~Image( void )
   {
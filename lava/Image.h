@@ -99,7 +99,7 @@ namespace lava
     vk::ImageTiling _tiling;
     vk::ImageType _type;
   public:
-    vk::DeviceMemory imageMemory;
+    MemoryAllocation imageMemory;
   };
 
   class ImageView : private NonCopyable<ImageView>
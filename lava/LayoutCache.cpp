@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "LayoutCache.h"
+
+#include <lava/Descriptor.h>
+#include <lava/Pipeline.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace lava
+{
+  namespace
+  {
+    template <typename T>
+    void append( std::string& key, const T& value )
+    {
+      key.append( reinterpret_cast< const char* >( &value ), sizeof( T ) );
+    }
+  }
+
+  LayoutCache::LayoutCache( void )
+    : _enabled( true )
+  {
+  }
+
+  std::shared_ptr<DescriptorSetLayout> LayoutCache::getDescriptorSetLayout(
+    vk::ArrayProxy<const DescriptorSetLayoutBinding> bindings,
+    vk::DescriptorSetLayoutCreateFlags flags,
+    const std::function<std::shared_ptr<DescriptorSetLayout>( )>& create )
+  {
+    if ( !_enabled )
+    {
+      return create( );
+    }
+
+    // Binding order does not change the layout
+    std::vector<const DescriptorSetLayoutBinding*> sorted;
+    sorted.reserve( bindings.size( ) );
+    for ( auto const& b : bindings )
+    {
+      sorted.push_back( &b );
+    }
+    std::sort( sorted.begin( ), sorted.end( ),
+      []( const DescriptorSetLayoutBinding* a, const DescriptorSetLayoutBinding* b )
+      {
+        return a->binding < b->binding;
+      } );
+
+    std::string key;
+    append( key, static_cast< VkDescriptorSetLayoutCreateFlags >( flags ) );
+    append( key, static_cast< uint64_t >( sorted.size( ) ) );
+    for ( auto b : sorted )
+    {
+      append( key, b->binding );
+      append( key, b->descriptorType );
+      append( key, static_cast< VkShaderStageFlags >( b->stageFlags ) );
+      // The layout keeps its samplers alive, addresses can not be reused
+      append( key, static_cast< uint64_t >( b->immutableSamplers.size( ) ) );
+      for ( auto const& sampler : b->immutableSamplers )
+      {
+        append( key, sampler.get( ) );
+      }
+    }
+    return _descriptorSetLayouts.getOrCreate( key, create );
+  }
+
+  std::shared_ptr<PipelineLayout> LayoutCache::getPipelineLayout(
+    vk::ArrayProxy<const std::shared_ptr<DescriptorSetLayout>> setLayouts,
+    vk::ArrayProxy<const vk::PushConstantRange> pushConstantRanges,
+    const std::function<std::shared_ptr<PipelineLayout>( )>& create )
+  {
+    if ( !_enabled )
+    {
+      return create( );
+    }
+
+    // Set layouts are interned too, so equal layouts share an address
+    std::string key;
+    append( key, static_cast< uint64_t >( setLayouts.size( ) ) );
+    for ( auto const& setLayout : setLayouts )
+    {
+      append( key, setLayout.get( ) );
+    }
+    append( key, static_cast< uint64_t >( pushConstantRanges.size( ) ) );
+    for ( auto const& range : pushConstantRanges )
+    {
+      append( key, static_cast< VkShaderStageFlags >( range.stageFlags ) );
+      append( key, range.offset );
+      append( key, range.size );
+    }
+    return _pipelineLayouts.getOrCreate( key, create );
+  }
+
+  void LayoutCache::resetCounters( void )
+  {
+    _descriptorSetLayouts.resetCounters( );
+    _pipelineLayouts.resetCounters( );
+  }
+
+  size_t LayoutCache::size( void ) const
+  {
+    return _descriptorSetLayouts.size( ) + _pipelineLayouts.size( );
+  }
+
+  void LayoutCache::clear( void )
+  {
+    _descriptorSetLayouts.clear( );
+    _pipelineLayouts.clear( );
+  }
+}
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_LAYOUT_CACHE__
+#define __LAVA_LAYOUT_CACHE__
+
+#include "includes.hpp"
+
+#include <lava/noncopyable.hpp>
+#include <lava/WeakInternCache.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <lava/api.h>
+
+namespace lava
+{
+  class DescriptorSetLayout;
+  struct DescriptorSetLayoutBinding;
+  class PipelineLayout;
+
+  /**
+  * Interns descriptor set layouts and pipeline layouts created through
+  *   Device, so identical descriptions share one Vulkan object. Shared set
+  *   layouts make the pipeline layouts built on them equal too, which lets
+  *   a set bound once (e.g. per-frame set 0) stay valid across pipelines.
+  *
+  * Bindings are keyed regardless of their order; immutable samplers enter
+  *   by address. Entries are weak: unused layouts are still destroyed.
+  */
+  class LayoutCache : private NonCopyable<LayoutCache>
+  {
+  public:
+    LAVA_API
+    LayoutCache( void );
+
+    LAVA_API
+    std::shared_ptr<DescriptorSetLayout> getDescriptorSetLayout(
+      vk::ArrayProxy<const DescriptorSetLayoutBinding> bindings,
+      vk::DescriptorSetLayoutCreateFlags flags,
+      const std::function<std::shared_ptr<DescriptorSetLayout>( )>& create );
+    LAVA_API
+    std::shared_ptr<PipelineLayout> getPipelineLayout(
+      vk::ArrayProxy<const std::shared_ptr<DescriptorSetLayout>> setLayouts,
+      vk::ArrayProxy<const vk::PushConstantRange> pushConstantRanges,
+      const std::function<std::shared_ptr<PipelineLayout>( )>& create );
+
+    // Disabled caches always create
+    LAVA_API
+    inline void setEnabled( bool enabled )
+    {
+      _enabled = enabled;
+    }
+    LAVA_API
+    inline bool isEnabled( void ) const
+    {
+      return _enabled;
+    }
+
+    LAVA_API
+    inline uint64_t hits( void ) const
+    {
+      return _descriptorSetLayouts.hits( ) + _pipelineLayouts.hits( );
+    }
+    LAVA_API
+    inline uint64_t misses( void ) const
+    {
+      return _descriptorSetLayouts.misses( ) + _pipelineLayouts.misses( );
+    }
+    LAVA_API
+    void resetCounters( void );
+    // Entries stored, including stale ones not swept yet
+    LAVA_API
+    size_t size( void ) const;
+    LAVA_API
+    void clear( void );
+  protected:
+    WeakInternCache<std::string, DescriptorSetLayout> _descriptorSetLayouts;
+    WeakInternCache<std::string, PipelineLayout> _pipelineLayouts;
+    std::atomic<bool> _enabled;
+  };
+}
+
+#endif /* __LAVA_LAYOUT_CACHE__ */
@@ -0,0 +1,501 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "MemoryAllocator.h"
+
+#include <algorithm>
+#include <map>
+
+namespace lava
+{
+  static inline vk::DeviceSize alignUp( vk::DeviceSize value,
+    vk::DeviceSize alignment )
+  {
+    return ( value + alignment - 1 ) / alignment * alignment;
+  }
+  static inline vk::DeviceSize alignDown( vk::DeviceSize value,
+    vk::DeviceSize alignment )
+  {
+    return value / alignment * alignment;
+  }
+
+  class MemoryBlock
+  {
+  public:
+    MemoryBlock( vk::DeviceMemory memory_, vk::DeviceSize size_, void* mapped_ )
+      : memory( memory_ )
+      , size( size_ )
+      , mapped( mapped_ )
+      , used( 0 )
+      , allocationCount( 0 )
+    {
+      insertFreeRange( 0, size );
+    }
+
+    bool allocate( vk::DeviceSize reqSize, vk::DeviceSize alignment,
+      vk::DeviceSize& offset )
+    {
+      // Smallest range that fits the size, then skip the ones
+      //    where the alignment padding doesn't fit
+      for ( auto it = _freeBySize.lower_bound( reqSize );
+        it != _freeBySize.end( ); ++it )
+      {
+        vk::DeviceSize rangeSize = it->first;
+        vk::DeviceSize rangeOffset = it->second;
+        vk::DeviceSize alignedOffset = alignUp( rangeOffset, alignment );
+        vk::DeviceSize padding = alignedOffset - rangeOffset;
+        if ( padding + reqSize > rangeSize )
+        {
+          continue;
+        }
+
+        _freeBySize.erase( it );
+        _freeByOffset.erase( rangeOffset );
+
+        if ( padding > 0 )
+        {
+          insertFreeRange( rangeOffset, padding );
+        }
+        vk::DeviceSize tail = rangeSize - padding - reqSize;
+        if ( tail > 0 )
+        {
+          insertFreeRange( alignedOffset + reqSize, tail );
+        }
+
+        offset = alignedOffset;
+        used += reqSize;
+        ++allocationCount;
+        return true;
+      }
+      return false;
+    }
+
+    void free( vk::DeviceSize offset, vk::DeviceSize rangeSize )
+    {
+      used -= rangeSize;
+      --allocationCount;
+
+      // Merge with the next free range
+      auto next = _freeByOffset.find( offset + rangeSize );
+      if ( next != _freeByOffset.end( ) )
+      {
+        rangeSize += next->second;
+        eraseFreeRange( next->first, next->second );
+      }
+      // Merge with the previous free range
+      auto prev = _freeByOffset.lower_bound( offset );
+      if ( prev != _freeByOffset.begin( ) )
+      {
+        --prev;
+        if ( prev->first + prev->second == offset )
+        {
+          offset = prev->first;
+          rangeSize += prev->second;
+          eraseFreeRange( prev->first, prev->second );
+        }
+      }
+      insertFreeRange( offset, rangeSize );
+    }
+
+    inline bool empty( void ) const
+    {
+      return allocationCount == 0;
+    }
+    inline uint32_t freeRangeCount( void ) const
+    {
+      return static_cast< uint32_t >( _freeByOffset.size( ) );
+    }
+    inline vk::DeviceSize largestFreeRange( void ) const
+    {
+      return _freeBySize.empty( ) ? 0 : _freeBySize.rbegin( )->first;
+    }
+
+    vk::DeviceMemory memory;
+    vk::DeviceSize size;
+    void* mapped;
+    vk::DeviceSize used;
+    uint32_t allocationCount;
+  protected:
+    void insertFreeRange( vk::DeviceSize offset, vk::DeviceSize rangeSize )
+    {
+      _freeByOffset[ offset ] = rangeSize;
+      _freeBySize.insert( std::make_pair( rangeSize, offset ) );
+    }
+    void eraseFreeRange( vk::DeviceSize offset, vk::DeviceSize rangeSize )
+    {
+      _freeByOffset.erase( offset );
+      auto range = _freeBySize.equal_range( rangeSize );
+      for ( auto it = range.first; it != range.second; ++it )
+      {
+        if ( it->second == offset )
+        {
+          _freeBySize.erase( it );
+          break;
+        }
+      }
+    }
+
+    // offset -> size, used to coalesce neighbours
+    std::map< vk::DeviceSize, vk::DeviceSize > _freeByOffset;
+    // size -> offset, used for best-fit lookups
+    std::multimap< vk::DeviceSize, vk::DeviceSize > _freeBySize;
+  };
+
+  float MemoryHeapStats::fragmentation( void ) const
+  {
+    vk::DeviceSize freeBytes = 0;
+    if ( bytesReserved > bytesUsed )
+    {
+      freeBytes = bytesReserved - bytesUsed;
+    }
+    if ( freeBytes == 0 || freeRangeCount <= 1 )
+    {
+      return 0.0f;
+    }
+    return 1.0f - float( largestFreeRange ) / float( freeBytes );
+  }
+
+  MemoryAllocator::MemoryAllocator( vk::Device device,
+    const vk::PhysicalDeviceProperties& deviceProps,
+    const vk::PhysicalDeviceMemoryProperties& memoryProps,
+    vk::DeviceSize preferredBlockSize )
+    : _device( device )
+    , _memoryProperties( memoryProps )
+    , _nonCoherentAtomSize( std::max< vk::DeviceSize >( 1,
+      deviceProps.limits.nonCoherentAtomSize ) )
+    , _preferredBlockSize( preferredBlockSize )
+  {
+    _pools.resize( _memoryProperties.memoryTypeCount * 2 );
+    _dedicatedCount.resize( _memoryProperties.memoryTypeCount, 0 );
+    _dedicatedBytes.resize( _memoryProperties.memoryTypeCount, 0 );
+  }
+
+  MemoryAllocator::~MemoryAllocator( void )
+  {
+    for ( auto& pool : _pools )
+    {
+      for ( auto& block : pool )
+      {
+        if ( !block->empty( ) )
+        {
+          std::cerr << "MemoryAllocator: block destroyed with "
+            << block->allocationCount << " live allocations" << std::endl;
+        }
+        if ( block->mapped )
+        {
+          _device.unmapMemory( block->memory );
+        }
+        _device.freeMemory( block->memory );
+      }
+      pool.clear( );
+    }
+  }
+
+  vk::DeviceSize MemoryAllocator::blockSizeForType(
+    uint32_t memoryTypeIndex ) const
+  {
+    uint32_t heapIndex = _memoryProperties
+      .memoryTypes[ memoryTypeIndex ].heapIndex;
+    vk::DeviceSize heapSize = _memoryProperties.memoryHeaps[ heapIndex ].size;
+    // Small heaps (e.g. host visible device local) use smaller blocks
+    return std::min( _preferredBlockSize, heapSize / 8 );
+  }
+
+  MemoryAllocation MemoryAllocator::allocate(
+    const vk::MemoryRequirements& reqs, vk::MemoryPropertyFlags flags,
+    bool linear )
+  {
+    uint32_t memoryTypeIndex = uint32_t( -1 );
+    for ( uint32_t i = 0; i < _memoryProperties.memoryTypeCount; ++i )
+    {
+      if ( ( reqs.memoryTypeBits & ( 1 << i ) ) &&
+        ( _memoryProperties.memoryTypes[ i ].propertyFlags & flags ) == flags )
+      {
+        memoryTypeIndex = i;
+        break;
+      }
+    }
+    if ( memoryTypeIndex == uint32_t( -1 ) )
+    {
+      throw std::runtime_error( "MemoryAllocator: no memory type found" );
+    }
+
+    const vk::MemoryPropertyFlags typeFlags =
+      _memoryProperties.memoryTypes[ memoryTypeIndex ].propertyFlags;
+    const bool hostVisible = static_cast< bool >(
+      typeFlags & vk::MemoryPropertyFlagBits::eHostVisible );
+
+    vk::DeviceSize size = reqs.size;
+    vk::DeviceSize alignment = std::max< vk::DeviceSize >( 1, reqs.alignment );
+    if ( hostVisible && !isHostCoherent( memoryTypeIndex ) )
+    {
+      // Keep flush/invalidate ranges of neighbours from overlapping
+      alignment = std::max( alignment, _nonCoherentAtomSize );
+      size = alignUp( size, _nonCoherentAtomSize );
+    }
+
+    MemoryAllocation allocation;
+    allocation.memoryTypeIndex = memoryTypeIndex;
+    allocation.size = size;
+
+    std::lock_guard< std::mutex > lock( _mutex );
+
+    vk::DeviceSize blockSize = blockSizeForType( memoryTypeIndex );
+
+    if ( size > blockSize / 2 )
+    {
+      // Big resources get their own allocation
+      vk::MemoryAllocateInfo mai( size, memoryTypeIndex );
+      vk::Result res = _device.allocateMemory( &mai, nullptr,
+        &allocation.memory );
+      if ( res != vk::Result::eSuccess )
+      {
+        throw std::runtime_error( "MemoryAllocator: out of device memory" );
+      }
+      if ( hostVisible )
+      {
+        allocation.mapped = _device.mapMemory( allocation.memory, 0,
+          VK_WHOLE_SIZE );
+      }
+      ++_dedicatedCount[ memoryTypeIndex ];
+      _dedicatedBytes[ memoryTypeIndex ] += size;
+      return allocation;
+    }
+
+    auto& pool = _pools[ memoryTypeIndex * 2 + ( linear ? 0 : 1 ) ];
+    for ( auto& block : pool )
+    {
+      if ( block->allocate( size, alignment, allocation.offset ) )
+      {
+        allocation.memory = block->memory;
+        allocation.block = block.get( );
+        if ( block->mapped )
+        {
+          allocation.mapped = static_cast< uint8_t* >( block->mapped )
+            + allocation.offset;
+        }
+        return allocation;
+      }
+    }
+
+    // No room, create a new block. Halve the size if the driver refuses it.
+    vk::DeviceMemory memory;
+    vk::Result res = vk::Result::eErrorOutOfDeviceMemory;
+    while ( blockSize >= size )
+    {
+      vk::MemoryAllocateInfo mai( blockSize, memoryTypeIndex );
+      res = _device.allocateMemory( &mai, nullptr, &memory );
+      if ( res == vk::Result::eSuccess )
+      {
+        break;
+      }
+      blockSize /= 2;
+    }
+    if ( res != vk::Result::eSuccess )
+    {
+      throw std::runtime_error( "MemoryAllocator: out of device memory" );
+    }
+
+    void* mapped = nullptr;
+    if ( hostVisible )
+    {
+      mapped = _device.mapMemory( memory, 0, VK_WHOLE_SIZE );
+    }
+    pool.push_back( std::unique_ptr< MemoryBlock >(
+      new MemoryBlock( memory, blockSize, mapped ) ) );
+
+    MemoryBlock* block = pool.back( ).get( );
+    bool ok = block->allocate( size, alignment, allocation.offset );
+    assert( ok );
+    (void) ok;
+    allocation.memory = block->memory;
+    allocation.block = block;
+    if ( mapped )
+    {
+      allocation.mapped = static_cast< uint8_t* >( mapped ) + allocation.offset;
+    }
+    return allocation;
+  }
+
+  void MemoryAllocator::free( MemoryAllocation& allocation )
+  {
+    if ( !allocation )
+    {
+      return;
+    }
+
+    std::lock_guard< std::mutex > lock( _mutex );
+
+    if ( allocation.block == nullptr )
+    {
+      if ( allocation.mapped )
+      {
+        _device.unmapMemory( allocation.memory );
+      }
+      _device.freeMemory( allocation.memory );
+      --_dedicatedCount[ allocation.memoryTypeIndex ];
+      _dedicatedBytes[ allocation.memoryTypeIndex ] -= allocation.size;
+    }
+    else
+    {
+      MemoryBlock* block = allocation.block;
+      block->free( allocation.offset, allocation.size );
+
+      if ( block->empty( ) )
+      {
+        // Keep one empty block per pool around to avoid thrashing
+        for ( auto& pool : _pools )
+        {
+          auto it = std::find_if( pool.begin( ), pool.end( ),
+            [ block ]( const std::unique_ptr< MemoryBlock >& b )
+          {
+            return b.get( ) == block;
+          } );
+          if ( it == pool.end( ) )
+          {
+            continue;
+          }
+          size_t emptyBlocks = std::count_if( pool.begin( ), pool.end( ),
+            [ ]( const std::unique_ptr< MemoryBlock >& b )
+          {
+            return b->empty( );
+          } );
+          if ( emptyBlocks > 1 )
+          {
+            if ( block->mapped )
+            {
+              _device.unmapMemory( block->memory );
+            }
+            _device.freeMemory( block->memory );
+            pool.erase( it );
+          }
+          break;
+        }
+      }
+    }
+    allocation = MemoryAllocation( );
+  }
+
+  bool MemoryAllocator::isHostCoherent( uint32_t memoryTypeIndex ) const
+  {
+    return static_cast< bool >(
+      _memoryProperties.memoryTypes[ memoryTypeIndex ].propertyFlags &
+      vk::MemoryPropertyFlagBits::eHostCoherent );
+  }
+
+  vk::MappedMemoryRange MemoryAllocator::mappedRange(
+    const MemoryAllocation& allocation, vk::DeviceSize offset,
+    vk::DeviceSize size ) const
+  {
+    if ( size == VK_WHOLE_SIZE )
+    {
+      size = allocation.size - offset;
+    }
+    vk::DeviceSize memorySize = allocation.block ?
+      allocation.block->size : allocation.size;
+    vk::DeviceSize begin = alignDown( allocation.offset + offset,
+      _nonCoherentAtomSize );
+    vk::DeviceSize end = std::min( memorySize, alignUp(
+      allocation.offset + offset + size, _nonCoherentAtomSize ) );
+    return vk::MappedMemoryRange( allocation.memory, begin, end - begin );
+  }
+
+  vk::Result MemoryAllocator::flush( const MemoryAllocation& allocation,
+    vk::DeviceSize offset, vk::DeviceSize size )
+  {
+    if ( isHostCoherent( allocation.memoryTypeIndex ) )
+    {
+      return vk::Result::eSuccess;
+    }
+    vk::MappedMemoryRange range = mappedRange( allocation, offset, size );
+    return _device.flushMappedMemoryRanges( 1, &range );
+  }
+
+  vk::Result MemoryAllocator::invalidate( const MemoryAllocation& allocation,
+    vk::DeviceSize offset, vk::DeviceSize size )
+  {
+    if ( isHostCoherent( allocation.memoryTypeIndex ) )
+    {
+      return vk::Result::eSuccess;
+    }
+    vk::MappedMemoryRange range = mappedRange( allocation, offset, size );
+    return _device.invalidateMappedMemoryRanges( 1, &range );
+  }
+
+  MemoryStats MemoryAllocator::getStats( void ) const
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+
+    MemoryStats stats;
+    stats.heaps.resize( _memoryProperties.memoryHeapCount );
+
+    for ( uint32_t type = 0; type < _memoryProperties.memoryTypeCount; ++type )
+    {
+      MemoryHeapStats& heap = stats.heaps[
+        _memoryProperties.memoryTypes[ type ].heapIndex ];
+
+      heap.dedicatedAllocationCount += _dedicatedCount[ type ];
+      heap.allocationCount += _dedicatedCount[ type ];
+      heap.bytesReserved += _dedicatedBytes[ type ];
+      heap.bytesUsed += _dedicatedBytes[ type ];
+
+      for ( uint32_t kind = 0; kind < 2; ++kind )
+      {
+        for ( const auto& block : _pools[ type * 2 + kind ] )
+        {
+          ++heap.blockCount;
+          heap.allocationCount += block->allocationCount;
+          heap.bytesReserved += block->size;
+          heap.bytesUsed += block->used;
+          heap.freeRangeCount += block->freeRangeCount( );
+          heap.largestFreeRange = std::max( heap.largestFreeRange,
+            block->largestFreeRange( ) );
+        }
+      }
+    }
+
+    for ( const auto& heap : stats.heaps )
+    {
+      stats.total.blockCount += heap.blockCount;
+      stats.total.allocationCount += heap.allocationCount;
+      stats.total.dedicatedAllocationCount += heap.dedicatedAllocationCount;
+      stats.total.bytesReserved += heap.bytesReserved;
+      stats.total.bytesUsed += heap.bytesUsed;
+      stats.total.freeRangeCount += heap.freeRangeCount;
+      stats.total.largestFreeRange = std::max( stats.total.largestFreeRange,
+        heap.largestFreeRange );
+    }
+    return stats;
+  }
+
+  void MemoryAllocator::printStats( void ) const
+  {
+    MemoryStats stats = getStats( );
+    for ( size_t i = 0, l = stats.heaps.size( ); i < l; ++i )
+    {
+      const MemoryHeapStats& heap = stats.heaps[ i ];
+      std::cout << "Heap " << i << ": "
+        << heap.blockCount << " blocks, "
+        << heap.allocationCount << " allocations ("
+        << heap.dedicatedAllocationCount << " dedicated), "
+        << heap.bytesUsed << "/" << heap.bytesReserved << " bytes used, "
+        << "fragmentation " << heap.fragmentation( ) << std::endl;
+    }
+  }
+}
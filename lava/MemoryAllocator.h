@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_MEMORY_ALLOCATOR__
+#define __LAVA_MEMORY_ALLOCATOR__
+
+#include "includes.hpp"
+
+#include <lava/noncopyable.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <lava/api.h>
+
+namespace lava
+{
+  class MemoryBlock;
+
+  // Range of device memory handed out by MemoryAllocator
+  struct MemoryAllocation
+  {
+    vk::DeviceMemory memory;
+    vk::DeviceSize offset = 0;
+    vk::DeviceSize size = 0;
+    uint32_t memoryTypeIndex = uint32_t( -1 );
+    // Host pointer to offset (persistently mapped), nullptr if not host visible
+    void* mapped = nullptr;
+    // Owner block, nullptr for dedicated allocations
+    MemoryBlock* block = nullptr;
+
+    LAVA_API
+    inline explicit operator bool( void ) const
+    {
+      return static_cast< bool >( memory );
+    }
+  };
+
+  struct MemoryHeapStats
+  {
+    uint32_t blockCount = 0;
+    uint32_t allocationCount = 0;
+    uint32_t dedicatedAllocationCount = 0;
+    // Bytes requested to the driver (blocks + dedicated allocations)
+    vk::DeviceSize bytesReserved = 0;
+    // Bytes handed out to resources
+    vk::DeviceSize bytesUsed = 0;
+    uint32_t freeRangeCount = 0;
+    vk::DeviceSize largestFreeRange = 0;
+
+    /**
+    * Returns 0 when all the free space of the blocks is contiguous and
+    *   values close to 1 when it is split into many small ranges.
+    */
+    LAVA_API
+    float fragmentation( void ) const;
+  };
+
+  struct MemoryStats
+  {
+    // Indexed by memory heap
+    std::vector< MemoryHeapStats > heaps;
+    MemoryHeapStats total;
+  };
+
+  /**
+  * Block-based sub-allocator. Memory is requested to the driver in big blocks
+  *   per memory type and resources are placed inside them using a best-fit
+  *   free list that coalesces neighbours on release. Host visible blocks
+  *   are persistently mapped.
+  */
+  class MemoryAllocator : private NonCopyable<MemoryAllocator>
+  {
+  public:
+    LAVA_API
+    MemoryAllocator( vk::Device device,
+      const vk::PhysicalDeviceProperties& deviceProps,
+      const vk::PhysicalDeviceMemoryProperties& memoryProps,
+      vk::DeviceSize preferredBlockSize = 64 * 1024 * 1024 );
+    LAVA_API
+    virtual ~MemoryAllocator( void );
+
+    /**
+    * Finds space for the provided requirements. Linear resources (buffers and
+    *   linear images) and optimal images never share a block, so
+    *   bufferImageGranularity does not need to be checked between them.
+    * Throws if no memory type matches the flags or the device is out of memory.
+    */
+    LAVA_API
+    MemoryAllocation allocate( const vk::MemoryRequirements& reqs,
+      vk::MemoryPropertyFlags flags, bool linear );
+    LAVA_API
+    void free( MemoryAllocation& allocation );
+
+    // Offsets are relative to the allocation. Noop on coherent memory.
+    LAVA_API
+    vk::Result flush( const MemoryAllocation& allocation,
+      vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE );
+    LAVA_API
+    vk::Result invalidate( const MemoryAllocation& allocation,
+      vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE );
+
+    /**
+    * Returns the range to pass to vkFlush/InvalidateMappedMemoryRanges,
+    *   expanded to nonCoherentAtomSize. Useful to batch several ranges
+    *   in a single call.
+    */
+    LAVA_API
+    vk::MappedMemoryRange mappedRange( const MemoryAllocation& allocation,
+      vk::DeviceSize offset, vk::DeviceSize size ) const;
+
+    LAVA_API
+    bool isHostCoherent( uint32_t memoryTypeIndex ) const;
+
+    LAVA_API
+    MemoryStats getStats( void ) const;
+    LAVA_API
+    void printStats( void ) const;
+  protected:
+    vk::DeviceSize blockSizeForType( uint32_t memoryTypeIndex ) const;
+
+    vk::Device _device;
+    vk::PhysicalDeviceMemoryProperties _memoryProperties;
+    vk::DeviceSize _nonCoherentAtomSize;
+    vk::DeviceSize _preferredBlockSize;
+    // Two pools per memory type: [ type * 2 ] linear, [ type * 2 + 1 ] optimal
+    std::vector< std::vector< std::unique_ptr< MemoryBlock > > > _pools;
+    std::vector< uint32_t > _dedicatedCount;
+    std::vector< vk::DeviceSize > _dedicatedBytes;
+    mutable std::mutex _mutex;
+  };
+}
+
+#endif /* __LAVA_MEMORY_ALLOCATOR__ */
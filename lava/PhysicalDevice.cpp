@@ -184,4 +184,22 @@ namespace lava
     }
     return indices;
   }
+  std::vector<uint32_t> PhysicalDevice::getTransferQueueFamilyIndices( void )
+  {
+    std::vector<vk::QueueFamilyProperties> props =
+      _physicalDevice.getQueueFamilyProperties( );
+    assert( !props.empty( ) );
+
+    std::vector<uint32_t> indices;
+    for ( size_t i = 0; i < props.size( ); ++i )
+    {
+      if ( ( props[ i ].queueFlags & vk::QueueFlagBits::eTransfer ) &&
+        !( props[ i ].queueFlags & ( vk::QueueFlagBits::eGraphics |
+          vk::QueueFlagBits::eCompute ) ) )
+      {
+        indices.push_back( i );
+      }
+    }
+    return indices;
+  }
 }
\ No newline at end of file
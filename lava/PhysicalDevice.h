@@ -116,6 +116,10 @@ namespace lava
     LAVA_API
     std::vector<uint32_t> getComputeQueueFamilyIndices( void );
 
+    // Families with transfer support but no graphics or compute (DMA engines)
+    LAVA_API
+    std::vector<uint32_t> getTransferQueueFamilyIndices( void );
+
   private:
     std::shared_ptr<Instance> _instance;
     vk::PhysicalDevice _physicalDevice;
@@ -81,7 +81,7 @@ namespace lava
 
     const uint32_t* arr = reinterpret_cast< const uint32_t* >( buffer.data( ) );
 
-    return std::vector<uint32_t>( arr, arr + buffer.size( ) );
+    return std::vector<uint32_t>( arr, arr + buffer.size( ) / sizeof( uint32_t ) );
   }
 
   ShaderModule::ShaderModule( const std::shared_ptr<Device>& device,
@@ -0,0 +1,224 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "PipelineCacheManager.h"
+
+#include <lava/Device.h>
+#include <lava/PhysicalDevice.h>
+#include <lava/Pipeline.h>
+#include <lava/utils.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+namespace lava
+{
+  namespace
+  {
+    // Prepended to the driver blob: the Vulkan header has no driver version
+    //    and no way to detect a truncated file
+    struct FileHeader
+    {
+      char magic[ 4 ];
+      uint32_t version;
+      uint32_t vendorID;
+      uint32_t deviceID;
+      uint32_t driverVersion;
+      uint8_t pipelineCacheUUID[ VK_UUID_SIZE ];
+      uint64_t dataSize;
+      uint64_t checksum;
+    };
+
+    const char FILE_MAGIC[ 4 ] = { 'L', 'V', 'P', 'C' };
+    const uint32_t FILE_VERSION = 1;
+
+    // FNV-1a
+    uint64_t checksum( const uint8_t* data, size_t size )
+    {
+      uint64_t hash = 14695981039346656037ULL;
+      for ( size_t i = 0; i < size; ++i )
+      {
+        hash ^= data[ i ];
+        hash *= 1099511628211ULL;
+      }
+      return hash;
+    }
+
+    FileHeader makeHeader( const vk::PhysicalDeviceProperties& props )
+    {
+      FileHeader header;
+      memset( &header, 0, sizeof( header ) );
+      memcpy( header.magic, FILE_MAGIC, sizeof( FILE_MAGIC ) );
+      header.version = FILE_VERSION;
+      header.vendorID = props.vendorID;
+      header.deviceID = props.deviceID;
+      header.driverVersion = props.driverVersion;
+      memcpy( header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE );
+      return header;
+    }
+  }
+
+  PipelineCacheManager::PipelineCacheManager(
+    const std::shared_ptr<Device>& device, const std::string& directory )
+    : VulkanResource( device )
+    , _loaded( false )
+    , _savedSize( 0 )
+    , _autoSaveInterval( 60 )
+    , _lastSave( std::chrono::steady_clock::now( ) )
+  {
+    const vk::PhysicalDeviceProperties& props =
+      _device->getPhysicalDevice( )->getDeviceProperties( );
+
+    std::stringstream ss;
+    ss << directory;
+    if ( !directory.empty( ) && directory.back( ) != '/' &&
+      directory.back( ) != '\\' )
+    {
+      ss << '/';
+    }
+    ss << "pipelinecache_" << std::hex << std::setfill( '0' )
+      << std::setw( 4 ) << props.vendorID << '_'
+      << std::setw( 4 ) << props.deviceID << '_';
+    for ( uint32_t i = 0; i < VK_UUID_SIZE; ++i )
+    {
+      ss << std::setw( 2 ) << uint32_t( props.pipelineCacheUUID[ i ] );
+    }
+    ss << ".bin";
+    _filePath = ss.str( );
+
+    std::vector<uint8_t> data = load( );
+    _loaded = !data.empty( );
+    _savedSize = data.size( );
+    _pipelineCache = _device->createPipelineCache( data.size( ),
+      data.empty( ) ? nullptr : data.data( ) );
+  }
+
+  PipelineCacheManager::~PipelineCacheManager( void )
+  {
+    save( );
+  }
+
+  std::vector<uint8_t> PipelineCacheManager::load( void )
+  {
+    std::vector<uint8_t> data;
+
+    std::ifstream file( _filePath, std::ios::binary | std::ios::ate );
+    if ( !file.is_open( ) )
+    {
+      return data;
+    }
+    size_t fileSize = static_cast< size_t >( file.tellg( ) );
+    file.seekg( 0 );
+
+    FileHeader header;
+    FileHeader expected = makeHeader(
+      _device->getPhysicalDevice( )->getDeviceProperties( ) );
+    if ( !file.read( reinterpret_cast< char* >( &header ), sizeof( header ) ) ||
+      memcmp( header.magic, expected.magic, sizeof( header.magic ) ) != 0 ||
+      header.version != expected.version )
+    {
+      std::cerr << "Pipeline cache " << _filePath
+        << " has an unknown format, ignoring it" << std::endl;
+      return data;
+    }
+    if ( header.vendorID != expected.vendorID ||
+      header.deviceID != expected.deviceID ||
+      header.driverVersion != expected.driverVersion ||
+      memcmp( header.pipelineCacheUUID, expected.pipelineCacheUUID,
+        VK_UUID_SIZE ) != 0 )
+    {
+      std::cerr << "Pipeline cache " << _filePath
+        << " is from another device or driver, ignoring it" << std::endl;
+      return data;
+    }
+
+    if ( header.dataSize != fileSize - sizeof( header ) )
+    {
+      std::cerr << "Pipeline cache " << _filePath
+        << " is truncated, ignoring it" << std::endl;
+      return data;
+    }
+    data.resize( static_cast< size_t >( header.dataSize ) );
+    if ( !file.read( reinterpret_cast< char* >( data.data( ) ), data.size( ) ) ||
+      checksum( data.data( ), data.size( ) ) != header.checksum )
+    {
+      std::cerr << "Pipeline cache " << _filePath
+        << " is corrupted, ignoring it" << std::endl;
+      data.clear( );
+      return data;
+    }
+
+    // The driver validates its own header too, but an invalid one is
+    //    still worth reporting
+    uint32_t headerLength = 0;
+    uint32_t headerVersion = 0;
+    if ( data.size( ) >= 16 + VK_UUID_SIZE )
+    {
+      memcpy( &headerLength, data.data( ), 4 );
+      memcpy( &headerVersion, data.data( ) + 4, 4 );
+    }
+    if ( headerLength < 16 + VK_UUID_SIZE ||
+      headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE )
+    {
+      std::cerr << "Pipeline cache " << _filePath
+        << " has an invalid Vulkan header, ignoring it" << std::endl;
+      data.clear( );
+    }
+    return data;
+  }
+
+  bool PipelineCacheManager::save( void )
+  {
+    _lastSave = std::chrono::steady_clock::now( );
+
+    std::vector<uint8_t> data = _pipelineCache->getData( );
+    if ( data.empty( ) || data.size( ) == _savedSize )
+    {
+      // Caches only grow, same size means nothing new
+      return true;
+    }
+
+    FileHeader header = makeHeader(
+      _device->getPhysicalDevice( )->getDeviceProperties( ) );
+    header.dataSize = data.size( );
+    header.checksum = checksum( data.data( ), data.size( ) );
+
+    if ( !utils::writeFileAtomic( _filePath, { { &header, sizeof( header ) },
+      { data.data( ), data.size( ) } } ) )
+    {
+      std::cerr << "Failed to write pipeline cache " << _filePath << std::endl;
+      return false;
+    }
+    _savedSize = data.size( );
+    return true;
+  }
+
+  void PipelineCacheManager::update( void )
+  {
+    if ( _autoSaveInterval.count( ) > 0 &&
+      std::chrono::steady_clock::now( ) - _lastSave >= _autoSaveInterval )
+    {
+      save( );
+    }
+  }
+}
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_PIPELINE_CACHE_MANAGER__
+#define __LAVA_PIPELINE_CACHE_MANAGER__
+
+#include "includes.hpp"
+
+#include "VulkanResource.h"
+#include "noncopyable.hpp"
+
+#include <lava/api.h>
+
+#include <chrono>
+#include <string>
+
+namespace lava
+{
+  class PipelineCache;
+
+  /**
+  * Keeps a PipelineCache on disk between runs. The file lives in directory
+  *   and is named after the vendor, device and pipeline cache UUID, so
+  *   several GPUs can share a directory. On load the blob is dropped unless
+  *   its header matches the running device and driver version; saves go to
+  *   a temporary file that is then renamed over the old one, so a crash
+  *   never leaves a truncated cache behind.
+  */
+  class PipelineCacheManager
+    : public VulkanResource
+    , private NonCopyable<PipelineCacheManager>
+  {
+  public:
+    LAVA_API
+    PipelineCacheManager( const std::shared_ptr<Device>& device,
+      const std::string& directory );
+    // Saves the cache
+    LAVA_API
+    virtual ~PipelineCacheManager( void );
+
+    LAVA_API
+    inline const std::shared_ptr<PipelineCache>& getPipelineCache( void ) const
+    {
+      return _pipelineCache;
+    }
+    LAVA_API
+    inline const std::string& getFilePath( void ) const
+    {
+      return _filePath;
+    }
+    // True if the cache was initialized from a valid file
+    LAVA_API
+    inline bool loadedFromDisk( void ) const
+    {
+      return _loaded;
+    }
+
+    // Writes the cache if it grew since the last save. Returns false on error.
+    LAVA_API
+    bool save( void );
+    /**
+    * Call once per frame: saves when autoSaveInterval has elapsed since
+    *   the last save. An interval of zero disables periodic saves.
+    */
+    LAVA_API
+    void update( void );
+    LAVA_API
+    void setAutoSaveInterval( std::chrono::seconds interval )
+    {
+      _autoSaveInterval = interval;
+    }
+  protected:
+    std::vector<uint8_t> load( void );
+
+    std::shared_ptr<PipelineCache> _pipelineCache;
+    std::string _filePath;
+    bool _loaded;
+    size_t _savedSize;
+    std::chrono::seconds _autoSaveInterval;
+    std::chrono::steady_clock::time_point _lastSave;
+  };
+}
+
+#endif /* __LAVA_PIPELINE_CACHE_MANAGER__ */
@@ -0,0 +1,301 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "PipelineStateCache.h"
+
+#include <lava/Pipeline.h>
+
+#include <algorithm>
+
+namespace lava
+{
+  namespace
+  {
+    // Appends fields one by one: whole vk structs carry padding and pNext
+    class KeyWriter
+    {
+    public:
+      KeyWriter( std::string& key )
+        : _key( key )
+      {
+        _key.clear( );
+      }
+      // Only for types without padding
+      template <typename T>
+      void pod( const T& value )
+      {
+        _key.append( reinterpret_cast< const char* >( &value ), sizeof( T ) );
+      }
+      template <typename T>
+      void array( const T* data, size_t count )
+      {
+        pod( static_cast< uint64_t >( count ) );
+        if ( count != 0 )
+        {
+          _key.append( reinterpret_cast< const char* >( data ), count * sizeof( T ) );
+        }
+      }
+      template <typename T>
+      void array( const std::vector<T>& values )
+      {
+        array( values.data( ), values.size( ) );
+      }
+      template <typename BitType>
+      void flags( const vk::Flags<BitType>& value )
+      {
+        pod( static_cast< VkFlags >( value ) );
+      }
+      template <typename Enum>
+      void enumeration( Enum value )
+      {
+        pod( static_cast< int32_t >( value ) );
+      }
+      void boolean( bool value )
+      {
+        pod( static_cast< uint8_t >( value ? 1 : 0 ) );
+      }
+      void string( const std::string& value )
+      {
+        array( value.data( ), value.size( ) );
+      }
+      void object( const void* ptr )
+      {
+        pod( reinterpret_cast< uintptr_t >( ptr ) );
+      }
+    private:
+      std::string& _key;
+    };
+
+    template <typename T>
+    void addDependency( PipelineStateCache::Dependencies& dependencies,
+      const std::shared_ptr<T>& object )
+    {
+      if ( object )
+      {
+        dependencies.push_back( object );
+      }
+    }
+
+    void writeStage( KeyWriter& w, PipelineStateCache::Dependencies& deps,
+      const PipelineShaderStageCreateInfo& stage )
+    {
+      w.enumeration( stage.stage );
+      w.object( stage.module.get( ) );
+      addDependency( deps, stage.module );
+      w.string( stage.name );
+      w.boolean( !!stage.specializationInfo );
+      if ( stage.specializationInfo )
+      {
+        const SpecializationInfo& info = *stage.specializationInfo;
+        size_t dataSize = 0;
+        for ( const auto& entry : info.mapEntries )
+        {
+          w.pod( entry.constantID );
+          w.pod( entry.offset );
+          w.pod( static_cast< uint64_t >( entry.size ) );
+          dataSize = std::max( dataSize, entry.offset + entry.size );
+        }
+        w.array( static_cast< const uint8_t* >( info.data ),
+          info.data ? dataSize : 0 );
+      }
+    }
+  }
+
+  PipelineStateCache::PipelineStateCache( void )
+    : _enabled( true )
+  {
+  }
+
+  bool PipelineStateCache::graphicsKey( std::string& key,
+    Dependencies& dependencies, vk::PipelineCreateFlags flags,
+    vk::ArrayProxy<const PipelineShaderStageCreateInfo> stages,
+    vk::Optional<const PipelineVertexInputStateCreateInfo> vertexInputState,
+    vk::Optional<const vk::PipelineInputAssemblyStateCreateInfo> inputAssemblyState,
+    vk::Optional<const vk::PipelineTessellationStateCreateInfo> tessellationState,
+    vk::Optional<const PipelineViewportStateCreateInfo> viewportState,
+    vk::Optional<const vk::PipelineRasterizationStateCreateInfo> rasterizationState,
+    vk::Optional<const PipelineMultisampleStateCreateInfo> multisampleState,
+    vk::Optional<const vk::PipelineDepthStencilStateCreateInfo> depthStencilState,
+    vk::Optional<const PipelineColorBlendStateCreateInfo> colorBlendState,
+    vk::Optional<const PipelineDynamicStateCreateInfo> dynamicState,
+    const std::shared_ptr<PipelineLayout>& pipelineLayout,
+    const std::shared_ptr<RenderPass>& renderPass, uint32_t subpass,
+    const std::shared_ptr<Pipeline>& basePipelineHandle,
+    uint32_t basePipelineIndex )
+  {
+    // Extension structs can not be compared
+    if ( ( inputAssemblyState && inputAssemblyState->pNext ) ||
+      ( tessellationState && tessellationState->pNext ) ||
+      ( rasterizationState && rasterizationState->pNext ) ||
+      ( depthStencilState && depthStencilState->pNext ) )
+    {
+      return false;
+    }
+
+    KeyWriter w( key );
+    dependencies.clear( );
+
+    w.pod( 'G' );
+    w.flags( flags );
+    w.pod( stages.size( ) );
+    for ( const auto& stage : stages )
+    {
+      writeStage( w, dependencies, stage );
+    }
+
+    w.boolean( !!vertexInputState );
+    if ( vertexInputState )
+    {
+      w.array( vertexInputState->vertexBindingDescriptions );
+      w.array( vertexInputState->vertexAttrirDescriptions );
+    }
+
+    w.boolean( !!inputAssemblyState );
+    if ( inputAssemblyState )
+    {
+      w.flags( inputAssemblyState->flags );
+      w.enumeration( inputAssemblyState->topology );
+      w.pod( inputAssemblyState->primitiveRestartEnable );
+    }
+
+    w.boolean( !!tessellationState );
+    if ( tessellationState )
+    {
+      w.flags( tessellationState->flags );
+      w.pod( tessellationState->patchControlPoints );
+    }
+
+    w.boolean( !!viewportState );
+    if ( viewportState )
+    {
+      w.array( viewportState->viewports );
+      w.array( viewportState->scissors );
+    }
+
+    w.boolean( !!rasterizationState );
+    if ( rasterizationState )
+    {
+      w.flags( rasterizationState->flags );
+      w.pod( rasterizationState->depthClampEnable );
+      w.pod( rasterizationState->rasterizerDiscardEnable );
+      w.enumeration( rasterizationState->polygonMode );
+      w.flags( rasterizationState->cullMode );
+      w.enumeration( rasterizationState->frontFace );
+      w.pod( rasterizationState->depthBiasEnable );
+      w.pod( rasterizationState->depthBiasConstantFactor );
+      w.pod( rasterizationState->depthBiasClamp );
+      w.pod( rasterizationState->depthBiasSlopeFactor );
+      w.pod( rasterizationState->lineWidth );
+    }
+
+    w.boolean( !!multisampleState );
+    if ( multisampleState )
+    {
+      w.enumeration( multisampleState->rasterizationSamples );
+      w.boolean( multisampleState->sampleShadingEnable );
+      w.pod( multisampleState->minSampleShading );
+      w.array( multisampleState->sampleMasks );
+      w.boolean( multisampleState->alphaToCoverageEnable );
+      w.boolean( multisampleState->alphaToOneEnable );
+    }
+
+    w.boolean( !!depthStencilState );
+    if ( depthStencilState )
+    {
+      w.flags( depthStencilState->flags );
+      w.pod( depthStencilState->depthTestEnable );
+      w.pod( depthStencilState->depthWriteEnable );
+      w.enumeration( depthStencilState->depthCompareOp );
+      w.pod( depthStencilState->depthBoundsTestEnable );
+      w.pod( depthStencilState->stencilTestEnable );
+      w.pod( depthStencilState->front );
+      w.pod( depthStencilState->back );
+      w.pod( depthStencilState->minDepthBounds );
+      w.pod( depthStencilState->maxDepthBounds );
+    }
+
+    w.boolean( !!colorBlendState );
+    if ( colorBlendState )
+    {
+      w.boolean( colorBlendState->logicEnable );
+      w.enumeration( colorBlendState->logicOp );
+      w.array( colorBlendState->attachments );
+      w.pod( colorBlendState->blendConstants );
+    }
+
+    w.boolean( !!dynamicState );
+    if ( dynamicState )
+    {
+      w.array( dynamicState->dynamicStates );
+    }
+
+    w.object( pipelineLayout.get( ) );
+    addDependency( dependencies, pipelineLayout );
+    w.object( renderPass.get( ) );
+    addDependency( dependencies, renderPass );
+    w.pod( subpass );
+    w.object( basePipelineHandle.get( ) );
+    addDependency( dependencies, basePipelineHandle );
+    w.pod( basePipelineIndex );
+    return true;
+  }
+
+  bool PipelineStateCache::computeKey( std::string& key,
+    Dependencies& dependencies, vk::PipelineCreateFlags flags,
+    const PipelineShaderStageCreateInfo& stage,
+    const std::shared_ptr<PipelineLayout>& pipelineLayout,
+    const std::shared_ptr<Pipeline>& basePipelineHandle,
+    uint32_t basePipelineIndex )
+  {
+    KeyWriter w( key );
+    dependencies.clear( );
+
+    w.pod( 'C' );
+    w.flags( flags );
+    writeStage( w, dependencies, stage );
+    w.object( pipelineLayout.get( ) );
+    addDependency( dependencies, pipelineLayout );
+    w.object( basePipelineHandle.get( ) );
+    addDependency( dependencies, basePipelineHandle );
+    w.pod( basePipelineIndex );
+    return true;
+  }
+
+  std::shared_ptr<Pipeline> PipelineStateCache::getOrCreate(
+    const std::string& key, const Dependencies& dependencies,
+    const std::function<std::shared_ptr<Pipeline>( )>& create )
+  {
+    return _pipelines.getOrCreate( key, create, dependencies );
+  }
+
+  void PipelineStateCache::resetCounters( void )
+  {
+    _pipelines.resetCounters( );
+  }
+
+  size_t PipelineStateCache::size( void ) const
+  {
+    return _pipelines.size( );
+  }
+
+  void PipelineStateCache::clear( void )
+  {
+    _pipelines.clear( );
+  }
+}
@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_PIPELINE_STATE_CACHE__
+#define __LAVA_PIPELINE_STATE_CACHE__
+
+#include "includes.hpp"
+
+#include <lava/noncopyable.hpp>
+#include <lava/WeakInternCache.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <lava/api.h>
+
+namespace lava
+{
+  class Pipeline;
+  class PipelineLayout;
+  class RenderPass;
+  struct PipelineShaderStageCreateInfo;
+  struct PipelineVertexInputStateCreateInfo;
+  struct PipelineViewportStateCreateInfo;
+  struct PipelineMultisampleStateCreateInfo;
+  struct PipelineColorBlendStateCreateInfo;
+  struct PipelineDynamicStateCreateInfo;
+
+  /**
+  * Deduplicates pipelines created through Device. The key is a canonical
+  *   byte serialization of every create info field; objects (shader
+  *   modules, layouts, render passes) enter it by address and are tracked
+  *   with weak_ptrs, so an entry goes stale as soon as any of them, or the
+  *   pipeline itself, is destroyed. Nothing is kept alive by the cache.
+  */
+  class PipelineStateCache : private NonCopyable<PipelineStateCache>
+  {
+  public:
+    typedef WeakInternCache<std::string, Pipeline>::Dependencies Dependencies;
+
+    LAVA_API
+    PipelineStateCache( void );
+
+    /**
+    * Builds the key of a graphics pipeline. Returns false if the
+    *   description can not be cached (pNext chains).
+    */
+    LAVA_API
+    static bool graphicsKey( std::string& key, Dependencies& dependencies,
+      vk::PipelineCreateFlags flags,
+      vk::ArrayProxy<const PipelineShaderStageCreateInfo> stages,
+      vk::Optional<const PipelineVertexInputStateCreateInfo> vertexInputState,
+      vk::Optional<const vk::PipelineInputAssemblyStateCreateInfo> inputAssemblyState,
+      vk::Optional<const vk::PipelineTessellationStateCreateInfo> tessellationState,
+      vk::Optional<const PipelineViewportStateCreateInfo> viewportState,
+      vk::Optional<const vk::PipelineRasterizationStateCreateInfo> rasterizationState,
+      vk::Optional<const PipelineMultisampleStateCreateInfo> multisampleState,
+      vk::Optional<const vk::PipelineDepthStencilStateCreateInfo> depthStencilState,
+      vk::Optional<const PipelineColorBlendStateCreateInfo> colorBlendState,
+      vk::Optional<const PipelineDynamicStateCreateInfo> dynamicState,
+      const std::shared_ptr<PipelineLayout>& pipelineLayout,
+      const std::shared_ptr<RenderPass>& renderPass, uint32_t subpass,
+      const std::shared_ptr<Pipeline>& basePipelineHandle,
+      uint32_t basePipelineIndex );
+    LAVA_API
+    static bool computeKey( std::string& key, Dependencies& dependencies,
+      vk::PipelineCreateFlags flags, const PipelineShaderStageCreateInfo& stage,
+      const std::shared_ptr<PipelineLayout>& pipelineLayout,
+      const std::shared_ptr<Pipeline>& basePipelineHandle,
+      uint32_t basePipelineIndex );
+
+    /**
+    * Returns the live pipeline stored under key or calls create and stores
+    *   the result. create runs without the lock held.
+    */
+    LAVA_API
+    std::shared_ptr<Pipeline> getOrCreate( const std::string& key,
+      const Dependencies& dependencies,
+      const std::function<std::shared_ptr<Pipeline>( )>& create );
+
+    // Disabled caches always create
+    LAVA_API
+    inline void setEnabled( bool enabled )
+    {
+      _enabled = enabled;
+    }
+    LAVA_API
+    inline bool isEnabled( void ) const
+    {
+      return _enabled;
+    }
+
+    LAVA_API
+    inline uint64_t hits( void ) const
+    {
+      return _pipelines.hits( );
+    }
+    LAVA_API
+    inline uint64_t misses( void ) const
+    {
+      return _pipelines.misses( );
+    }
+    LAVA_API
+    void resetCounters( void );
+    // Entries stored, including stale ones not swept yet
+    LAVA_API
+    size_t size( void ) const;
+    LAVA_API
+    void clear( void );
+  protected:
+    WeakInternCache<std::string, Pipeline> _pipelines;
+    std::atomic<bool> _enabled;
+  };
+}
+
+#endif /* __LAVA_PIPELINE_STATE_CACHE__ */
@@ -20,6 +20,8 @@
 #include "Queue.h"
 
 #include <lava/CommandBuffer.h>
+#include <lava/RetirementQueue.h>
+#include <lava/StagingRing.h>
 #include <lava/Swapchain.h>
 
 #define DEFAULT_FENCE_TIMEOUT 100000000000
@@ -53,70 +55,141 @@ namespace lava
     return *this;
   }
 
-  vk::Result Queue::submit( vk::ArrayProxy<const SubmitInfo> submitInfos,
-    const std::shared_ptr<Fence>& fenceIn )
+  void SubmitBatch::add( vk::ArrayProxy<const vk::Semaphore> waitSemaphores,
+    vk::ArrayProxy<const vk::PipelineStageFlags> waitDstStageMasks,
+    vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
+    vk::ArrayProxy<const vk::Semaphore> signalSemaphores )
   {
-    // create a new fence if none has been passed to track completion of the submit.
-    auto fence = fenceIn ? fenceIn : _device->createFence( false );
+    assert( waitSemaphores.size( ) == waitDstStageMasks.size( ) );
 
-    _submitInfos.insert( std::make_pair( fence,
-      std::vector<SubmitInfo>( submitInfos.begin( ), submitInfos.end( ) ) ) );
+    Range range;
+    range.waitOffset = static_cast< uint32_t >( _waitSemaphores.size( ) );
+    range.waitCount = waitSemaphores.size( );
+    range.commandBufferOffset =
+      static_cast< uint32_t >( _commandBuffers.size( ) );
+    range.commandBufferCount = commandBuffers.size( );
+    range.signalOffset = static_cast< uint32_t >( _signalSemaphores.size( ) );
+    range.signalCount = signalSemaphores.size( );
+    _submits.push_back( range );
 
-    std::vector<std::vector<vk::Semaphore>> waitSemaphores;
-    waitSemaphores.reserve( submitInfos.size( ) );
+    _waitSemaphores.insert( _waitSemaphores.end( ),
+      waitSemaphores.begin( ), waitSemaphores.end( ) );
+    _waitDstStageMasks.insert( _waitDstStageMasks.end( ),
+      waitDstStageMasks.begin( ), waitDstStageMasks.end( ) );
+    _commandBuffers.insert( _commandBuffers.end( ),
+      commandBuffers.begin( ), commandBuffers.end( ) );
+    _signalSemaphores.insert( _signalSemaphores.end( ),
+      signalSemaphores.begin( ), signalSemaphores.end( ) );
+  }
 
-    std::vector<std::vector<vk::CommandBuffer>> commandBuffers;
-    commandBuffers.reserve( submitInfos.size( ) );
+  void SubmitBatch::clear( void )
+  {
+    _submits.clear( );
+    _waitSemaphores.clear( );
+    _waitDstStageMasks.clear( );
+    _commandBuffers.clear( );
+    _signalSemaphores.clear( );
+  }
 
-    std::vector<std::vector<vk::Semaphore>> signalSemaphores;
-    signalSemaphores.reserve( submitInfos.size( ) );
+  vk::Result Queue::submit( vk::ArrayProxy<const SubmitInfo> submitInfos,
+    const std::shared_ptr<Fence>& fenceIn )
+  {
+    // create a new fence if none has been passed to track completion of the submit.
+    auto fence = fenceIn ? fenceIn : _device->acquireFence( );
 
-    std::vector<vk::SubmitInfo> to_submit;
-    to_submit.reserve( submitInfos.size( ) );
+    _scratchBatch.clear( );
     for ( auto const& si : submitInfos )
     {
       assert( si.waitSemaphores.size( ) == si.waitDstStageMasks.size( ) );
 
-      waitSemaphores.push_back( std::vector<vk::Semaphore>( ) );
-      waitSemaphores.back( ).reserve( si.waitSemaphores.size( ) );
+      SubmitBatch::Range range;
+      range.waitOffset =
+        static_cast< uint32_t >( _scratchBatch._waitSemaphores.size( ) );
+      range.waitCount = static_cast< uint32_t >( si.waitSemaphores.size( ) );
+      range.commandBufferOffset =
+        static_cast< uint32_t >( _scratchBatch._commandBuffers.size( ) );
+      range.commandBufferCount =
+        static_cast< uint32_t >( si.commandBuffers.size( ) );
+      range.signalOffset =
+        static_cast< uint32_t >( _scratchBatch._signalSemaphores.size( ) );
+      range.signalCount = static_cast< uint32_t >( si.signalSemaphores.size( ) );
+      _scratchBatch._submits.push_back( range );
+
       for ( auto const& sem : si.waitSemaphores )
       {
-        waitSemaphores.back( ).push_back( sem ?
+        _scratchBatch._waitSemaphores.push_back( sem ?
           static_cast< vk::Semaphore >( *sem ) : nullptr );
       }
-
-      commandBuffers.push_back( std::vector<vk::CommandBuffer>( ) );
-      commandBuffers.back( ).reserve( si.commandBuffers.size( ) );
+      _scratchBatch._waitDstStageMasks.insert(
+        _scratchBatch._waitDstStageMasks.end( ),
+        si.waitDstStageMasks.begin( ), si.waitDstStageMasks.end( ) );
       for ( auto const& cmd : si.commandBuffers )
       {
-        commandBuffers.back( ).push_back( cmd ?
+        _scratchBatch._commandBuffers.push_back( cmd ?
           static_cast< vk::CommandBuffer >( *cmd ) : nullptr );
+        if ( cmd )
+        {
+          // Executable buffers can be submitted again
+          assert( cmd->_state == CommandBuffer::State::RecordingDone ||
+            cmd->_state == CommandBuffer::State::Submitted );
+          cmd->_state = CommandBuffer::State::Submitted;
+        }
       }
-
-      signalSemaphores.push_back( std::vector<vk::Semaphore>( ) );
-      signalSemaphores.back( ).reserve( si.signalSemaphores.size( ) );
       for ( auto const& sem : si.signalSemaphores )
       {
-        signalSemaphores.back( ).push_back( sem ?
+        _scratchBatch._signalSemaphores.push_back( sem ?
           static_cast< vk::Semaphore >( *sem ) : nullptr );
       }
+    }
+
+    vk::Result result = submit( _scratchBatch, fence );
 
-      to_submit.push_back(
-        vk::SubmitInfo(
-          waitSemaphores.back( ).size( ),
-          waitSemaphores.back( ).data( ),
-          si.waitDstStageMasks.data( ),
-          commandBuffers.back( ).size( ),
-          commandBuffers.back( ).data( ),
-          signalSemaphores.back( ).size( ),
-          signalSemaphores.back( ).data( )
-        )
-      );
+    // Command buffers and semaphores stay alive until the fence signals.
+    //    The retirement queue only watches the fence, so it rides along.
+    _device->getRetirementQueue( )->retire( fence,
+      std::make_shared<std::pair<std::shared_ptr<Fence>,
+        std::vector<SubmitInfo>>>( fence, std::vector<SubmitInfo>(
+          submitInfos.begin( ), submitInfos.end( ) ) ) );
+
+    return result;
+  }
+
+  vk::Result Queue::submit( const SubmitBatch& batch,
+    const std::shared_ptr<Fence>& fenceIn )
+  {
+    // Without a fence the retirement queue and the staging ring could not
+    //    tell when this work completes, so use a pooled one
+    auto fence = fenceIn ? fenceIn : _device->acquireFence( );
+
+    // Pointers are taken after the batch is complete, so they stay valid
+    _scratchSubmits.clear( );
+    for ( auto const& range : batch._submits )
+    {
+      _scratchSubmits.push_back( vk::SubmitInfo(
+        range.waitCount,
+        batch._waitSemaphores.data( ) + range.waitOffset,
+        batch._waitDstStageMasks.data( ) + range.waitOffset,
+        range.commandBufferCount,
+        batch._commandBuffers.data( ) + range.commandBufferOffset,
+        range.signalCount,
+        batch._signalSemaphores.data( ) + range.signalOffset ) );
     }
 
-    //_queue.submit( to_submit, *fence );
+    vk::Result result = _queue.submit( _scratchSubmits.size( ),
+      _scratchSubmits.data( ), static_cast< vk::Fence >( *fence ) );
+
+    RetirementQueue* retirement = _device->getRetirementQueue( );
+    retirement->collect( );
+    // Staging regions used by these command buffers live until the fence
+    _device->getStagingRing( )->submitted( batch._commandBuffers, fence );
+    retirement->submitted( this, fence );
+    if ( !fenceIn )
+    {
+      // Nobody else holds the pooled fence, keep it until it signals
+      retirement->retire( fence, fence );
+    }
 
-    return _queue.submit( to_submit.size( ), to_submit.data( ), *fence );
+    return result;
   }
 
   void Queue::submit( const std::shared_ptr<CommandBuffer>& commandBuffer,
@@ -161,7 +234,7 @@ namespace lava
 
   void Queue::submitAndWait( std::shared_ptr<CommandBuffer>& cmd )
   {
-    auto fence = _device->createFence( false );
+    auto fence = _device->acquireFence( );
     this->submit( cmd, fence );
 
     std::vector<vk::Fence> vkFences;
@@ -175,6 +248,10 @@ namespace lava
     // Wait for the fence to signal that command buffer has finished executing
     static_cast< vk::Device >( *_device ).waitForFences( vkFences, VK_TRUE,
       DEFAULT_FENCE_TIMEOUT );
+
+    // Release what this submit (and anything before it) kept alive now,
+    //    the next submit may never come
+    _device->getRetirementQueue( )->collect( );
   }
 
   Queue::Queue( const std::shared_ptr<Device>& device, vk::Queue queue, 
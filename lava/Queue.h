@@ -58,6 +58,51 @@ namespace lava
     std::vector< std::shared_ptr< Semaphore > > signalSemaphores;
   };
 
+  /**
+  * Reusable list of raw-handle submits flushed with a single vkQueueSubmit.
+  *   Storage keeps its capacity across clear( ), so once warmed up adding
+  *   and submitting does not allocate (lavaSubmitBenchmark counts it; the
+  *   SubmitInfo overload allocates on every call to keep its shared_ptrs
+  *   alive). Handles are not owned: the caller keeps them alive until the
+  *   submit fence signals.
+  */
+  class SubmitBatch
+  {
+  public:
+    LAVA_API
+    void add( vk::ArrayProxy<const vk::Semaphore> waitSemaphores,
+      vk::ArrayProxy<const vk::PipelineStageFlags> waitDstStageMasks,
+      vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
+      vk::ArrayProxy<const vk::Semaphore> signalSemaphores );
+    LAVA_API
+    void clear( void );
+    LAVA_API
+    inline bool empty( void ) const
+    {
+      return _submits.empty( );
+    }
+    LAVA_API
+    inline size_t size( void ) const
+    {
+      return _submits.size( );
+    }
+  protected:
+    friend class Queue;
+
+    struct Range
+    {
+      uint32_t waitOffset, waitCount;
+      uint32_t commandBufferOffset, commandBufferCount;
+      uint32_t signalOffset, signalCount;
+    };
+
+    std::vector<Range> _submits;
+    std::vector<vk::Semaphore> _waitSemaphores;
+    std::vector<vk::PipelineStageFlags> _waitDstStageMasks;
+    std::vector<vk::CommandBuffer> _commandBuffers;
+    std::vector<vk::Semaphore> _signalSemaphores;
+  };
+
   class Queue
     : public VulkanResource
     , private NonCopyable<Queue>
@@ -71,6 +116,15 @@ namespace lava
     void submit( const std::shared_ptr<CommandBuffer>& commandBuffer,
       const std::shared_ptr<Fence>& fence = std::shared_ptr<Fence>( ) );
 
+    /**
+    * Fast path: submits every entry of batch in one call. Without a fence
+    *   a pooled one is used, so the staging ring and the retirement queue
+    *   can still tell when the work completes.
+    */
+    LAVA_API
+    vk::Result submit( const SubmitBatch& batch,
+      const std::shared_ptr<Fence>& fence = std::shared_ptr<Fence>( ) );
+
     LAVA_API
     std::vector<vk::Result> present(
       vk::ArrayProxy<const std::shared_ptr<Semaphore>> waitSemaphores,
@@ -99,7 +153,9 @@ namespace lava
     Queue( const std::shared_ptr<Device>& device, vk::Queue queue, 
       uint32_t queueIndex );
 
-    std::map<std::shared_ptr<Fence>, std::vector<SubmitInfo>> _submitInfos;
+    // Submits must be externally synchronized, so scratch storage is shared
+    SubmitBatch _scratchBatch;
+    std::vector<vk::SubmitInfo> _scratchSubmits;
     vk::Queue _queue;
     uint32_t _queueFamilyIndex;
   };
@@ -0,0 +1,174 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "RetirementQueue.h"
+
+#include <lava/Fence.h>
+
+#include <algorithm>
+
+namespace lava
+{
+  namespace
+  {
+    bool isSignaled( const std::weak_ptr<Fence>& fence )
+    {
+      std::shared_ptr<Fence> f = fence.lock( );
+      return !f || f->isSignaled( );
+    }
+  }
+
+  RetirementQueue::RetirementQueue( void )
+  {
+  }
+
+  RetirementQueue::~RetirementQueue( void )
+  {
+    clear( );
+  }
+
+  void RetirementQueue::retire( const std::shared_ptr<Fence>& fence,
+    std::shared_ptr<void> resource )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    Entry entry;
+    entry.fences.push_back( fence );
+    entry.resource = std::move( resource );
+    _fenceEntries.push_back( std::move( entry ) );
+  }
+
+  void RetirementQueue::retire( std::shared_ptr<void> resource )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    Entry entry;
+    for ( auto const& it : _lastFences )
+    {
+      if ( !it.second.expired( ) )
+      {
+        entry.fences.push_back( it.second );
+      }
+    }
+    if ( entry.fences.empty( ) )
+    {
+      // Nothing in flight, nothing can be using it
+      return;
+    }
+    entry.resource = std::move( resource );
+    _fenceEntries.push_back( std::move( entry ) );
+  }
+
+  void RetirementQueue::retireAtFrame( uint64_t frame,
+    std::shared_ptr<void> resource )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    _frameEntries.insert( std::make_pair( frame, std::move( resource ) ) );
+  }
+
+  void RetirementQueue::completeFrame( uint64_t frame )
+  {
+    std::vector<std::shared_ptr<void>> released;
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto end = _frameEntries.upper_bound( frame );
+      for ( auto it = _frameEntries.begin( ); it != end; ++it )
+      {
+        released.push_back( std::move( it->second ) );
+      }
+      _frameEntries.erase( _frameEntries.begin( ), end );
+    }
+    // Destructors run outside the lock, they may retire more resources
+    released.clear( );
+  }
+
+  void RetirementQueue::submitted( const Queue* queue,
+    const std::shared_ptr<Fence>& fence )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    for ( auto& it : _lastFences )
+    {
+      if ( it.first == queue )
+      {
+        it.second = fence;
+        return;
+      }
+    }
+    _lastFences.push_back( std::make_pair( queue, fence ) );
+  }
+
+  size_t RetirementQueue::collect( void )
+  {
+    std::vector<std::shared_ptr<void>> released;
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+
+      // Every entry has its own fences, so one that never signals (a caller
+      //    fence reset or never submitted) must not hold back the rest
+      auto kept = _fenceEntries.begin( );
+      for ( auto it = _fenceEntries.begin( ); it != _fenceEntries.end( ); ++it )
+      {
+        auto& fences = it->fences;
+        fences.erase( std::remove_if( fences.begin( ), fences.end( ),
+          isSignaled ), fences.end( ) );
+        if ( fences.empty( ) )
+        {
+          released.push_back( std::move( it->resource ) );
+        }
+        else
+        {
+          if ( kept != it )
+          {
+            *kept = std::move( *it );
+          }
+          ++kept;
+        }
+      }
+      _fenceEntries.erase( kept, _fenceEntries.end( ) );
+
+      _lastFences.erase( std::remove_if( _lastFences.begin( ),
+        _lastFences.end( ),
+        [ ] ( const std::pair<const Queue*, std::weak_ptr<Fence>>& it )
+      {
+        return isSignaled( it.second );
+      } ), _lastFences.end( ) );
+    }
+    size_t count = released.size( );
+    released.clear( );
+    return count;
+  }
+
+  void RetirementQueue::clear( void )
+  {
+    std::deque<Entry> fenceEntries;
+    std::multimap<uint64_t, std::shared_ptr<void>> frameEntries;
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      fenceEntries.swap( _fenceEntries );
+      frameEntries.swap( _frameEntries );
+      _lastFences.clear( );
+    }
+  }
+
+  size_t RetirementQueue::pending( void ) const
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    return _fenceEntries.size( ) + _frameEntries.size( );
+  }
+}
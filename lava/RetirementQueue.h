@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_RETIREMENT_QUEUE__
+#define __LAVA_RETIREMENT_QUEUE__
+
+#include "includes.hpp"
+
+#include <lava/noncopyable.hpp>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <lava/api.h>
+
+namespace lava
+{
+  class Fence;
+  class Queue;
+
+  /**
+  * Holds references to resources used by in-flight GPU work and releases
+  *   them in bulk once the work completes, either when a fence is signaled
+  *   or when the owner reports a frame index as finished. Callers can
+  *   drop their shared_ptrs right after submitting without a waitIdle.
+  *   Fences are only watched, not owned: a fence destroyed before it was
+  *   seen signaled counts as signaled, so whoever submits keeps it alive
+  *   (Queue retires the fences it acquires along with the work).
+  */
+  class RetirementQueue : private NonCopyable<RetirementQueue>
+  {
+  public:
+    LAVA_API
+    RetirementQueue( void );
+    LAVA_API
+    virtual ~RetirementQueue( void );
+
+    // Keeps the resource alive until the fence is signaled or destroyed
+    LAVA_API
+    void retire( const std::shared_ptr<Fence>& fence,
+      std::shared_ptr<void> resource );
+    // Keeps the resource alive until all the work submitted so far completes
+    LAVA_API
+    void retire( std::shared_ptr<void> resource );
+    // Keeps the resource alive until completeFrame( frame ) is called
+    LAVA_API
+    void retireAtFrame( uint64_t frame, std::shared_ptr<void> resource );
+    // Releases everything retired at frame or earlier
+    LAVA_API
+    void completeFrame( uint64_t frame );
+
+    // Called by Queue after each submit
+    LAVA_API
+    void submitted( const Queue* queue, const std::shared_ptr<Fence>& fence );
+
+    // Releases the resources whose fences are signaled. Returns how many.
+    LAVA_API
+    size_t collect( void );
+    // Releases everything, the device must be idle
+    LAVA_API
+    void clear( void );
+
+    LAVA_API
+    size_t pending( void ) const;
+  protected:
+    struct Entry
+    {
+      std::vector<std::weak_ptr<Fence>> fences;
+      std::shared_ptr<void> resource;
+    };
+
+    std::deque<Entry> _fenceEntries;
+    std::multimap<uint64_t, std::shared_ptr<void>> _frameEntries;
+    // Last fence submitted on each queue. A vector keeps its capacity when
+    //    signaled fences are dropped, so submits don't allocate once warm.
+    std::vector<std::pair<const Queue*, std::weak_ptr<Fence>>> _lastFences;
+    mutable std::mutex _mutex;
+  };
+}
+
+#endif /* __LAVA_RETIREMENT_QUEUE__ */
@@ -19,15 +19,32 @@
 
 #include "Semaphore.h"
 
+#include <lava/SyncPool.h>
+
 namespace lava
 {
   Semaphore::Semaphore( const std::shared_ptr<Device>& device )
     : VulkanResource( device )
+    , _pool( nullptr )
   {
     _semaphore = vk::Device( *_device ).createSemaphore( { } );
   }
+  Semaphore::Semaphore( const std::shared_ptr<Device>& device,
+    vk::Semaphore semaphore, SemaphorePool* pool )
+    : VulkanResource( device )
+    , _semaphore( semaphore )
+    , _pool( pool )
+  {
+  }
   Semaphore::~Semaphore( void )
   {
-    static_cast< vk::Device >( *_device ).destroySemaphore( _semaphore );
+    if ( _pool )
+    {
+      _pool->release( _semaphore );
+    }
+    else
+    {
+      static_cast< vk::Device >( *_device ).destroySemaphore( _semaphore );
+    }
   }
 }
\ No newline at end of file
@@ -27,6 +27,8 @@
 
 namespace lava
 {
+  class SemaphorePool;
+
   class Semaphore
     : public VulkanResource
     , private NonCopyable< Semaphore >
@@ -46,7 +48,13 @@ namespace lava
     }
 
   protected:
+    friend class Device;
+    // Wraps a pooled handle that goes back to the pool on destruction
+    Semaphore( const std::shared_ptr<Device>& device, vk::Semaphore semaphore,
+      SemaphorePool* pool );
+
     vk::Semaphore _semaphore;
+    SemaphorePool* _pool;
   };
 }
 
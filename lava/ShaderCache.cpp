@@ -0,0 +1,227 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "ShaderCache.h"
+
+#include <lava/Pipeline.h>
+#include <lava/utils.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include <sys/stat.h>
+
+namespace lava
+{
+  namespace
+  {
+    const uint32_t SPIRV_MAGIC = 0x07230203;
+  }
+
+  ShaderCache::ShaderCache( void )
+    : _enabled( true )
+    , _hits( 0 )
+    , _misses( 0 )
+  {
+  }
+
+  uint64_t ShaderCache::hash( const void* data, size_t size, uint64_t seed )
+  {
+    const uint8_t* bytes = static_cast< const uint8_t* >( data );
+    uint64_t hash = seed;
+    for ( size_t i = 0; i < size; ++i )
+    {
+      hash ^= bytes[ i ];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  ShaderCache::Code ShaderCache::readFile( const std::string& filePath )
+  {
+    struct stat info;
+    bool known = _enabled && stat( filePath.c_str( ), &info ) == 0;
+    if ( known )
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto it = _files.find( filePath );
+      if ( it != _files.end( ) &&
+        it->second.time == static_cast< int64_t >( info.st_mtime ) &&
+        it->second.size == static_cast< uint64_t >( info.st_size ) )
+      {
+        ++_hits;
+        return it->second.code;
+      }
+    }
+
+    ++_misses;
+    std::shared_ptr<std::vector<uint32_t>> code =
+      std::make_shared<std::vector<uint32_t>>( );
+    if ( !readSpirv( filePath, *code ) )
+    {
+      std::cerr << "File " << filePath << " don't opened" << std::endl;
+      throw std::runtime_error( "failed to open file!" );
+    }
+
+    if ( known )
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      FileEntry& entry = _files[ filePath ];
+      entry.time = static_cast< int64_t >( info.st_mtime );
+      entry.size = static_cast< uint64_t >( info.st_size );
+      entry.code = code;
+    }
+    return code;
+  }
+
+  std::shared_ptr<ShaderModule> ShaderCache::getModule(
+    vk::ArrayProxy<const uint32_t> code,
+    const std::function<std::shared_ptr<ShaderModule>( )>& create )
+  {
+    if ( !_enabled )
+    {
+      return create( );
+    }
+
+    return _modules.getOrCreate(
+      std::vector<uint32_t>( code.begin( ), code.end( ) ), create );
+  }
+
+  ShaderCache::Code ShaderCache::findCompiled( uint64_t key )
+  {
+    if ( !_enabled )
+    {
+      return nullptr;
+    }
+
+    std::string filePath;
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto it = _compiled.find( key );
+      if ( it != _compiled.end( ) )
+      {
+        ++_hits;
+        return it->second;
+      }
+      filePath = compiledPath( key );
+    }
+
+    std::shared_ptr<std::vector<uint32_t>> code =
+      std::make_shared<std::vector<uint32_t>>( );
+    if ( filePath.empty( ) || !readSpirv( filePath, *code ) ||
+      code->front( ) != SPIRV_MAGIC )
+    {
+      ++_misses;
+      return nullptr;
+    }
+
+    ++_hits;
+    std::lock_guard<std::mutex> lock( _mutex );
+    _compiled[ key ] = code;
+    return code;
+  }
+
+  void ShaderCache::storeCompiled( uint64_t key, const std::vector<uint32_t>& code )
+  {
+    if ( !_enabled || code.empty( ) )
+    {
+      return;
+    }
+
+    std::string filePath;
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _compiled[ key ] = std::make_shared<const std::vector<uint32_t>>( code );
+      filePath = compiledPath( key );
+    }
+    if ( filePath.empty( ) )
+    {
+      return;
+    }
+
+    if ( !utils::writeFileAtomic( filePath,
+      { { code.data( ), code.size( ) * sizeof( uint32_t ) } } ) )
+    {
+      std::cerr << "Failed to write shader cache " << filePath << std::endl;
+    }
+  }
+
+  void ShaderCache::setDirectory( const std::string& directory )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    _directory = directory;
+  }
+
+  std::string ShaderCache::getDirectory( void ) const
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    return _directory;
+  }
+
+  bool ShaderCache::readSpirv( const std::string& filePath,
+    std::vector<uint32_t>& code )
+  {
+    std::ifstream file( filePath, std::ios::binary | std::ios::ate );
+    if ( !file.is_open( ) )
+    {
+      return false;
+    }
+
+    std::streamoff fileSize = file.tellg( );
+    if ( fileSize <= 0 || fileSize % sizeof( uint32_t ) != 0 )
+    {
+      return false;
+    }
+
+    code.resize( static_cast< size_t >( fileSize ) / sizeof( uint32_t ) );
+    file.seekg( 0 );
+    return !!file.read( reinterpret_cast< char* >( code.data( ) ), fileSize );
+  }
+
+  std::string ShaderCache::compiledPath( uint64_t key ) const
+  {
+    if ( _directory.empty( ) )
+    {
+      return std::string( );
+    }
+    std::ostringstream path;
+    path << _directory << "/" << std::hex << std::setw( 16 )
+      << std::setfill( '0' ) << key << ".spv";
+    return path.str( );
+  }
+
+  void ShaderCache::resetCounters( void )
+  {
+    _hits = 0;
+    _misses = 0;
+    _modules.resetCounters( );
+  }
+
+  void ShaderCache::clear( void )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    _files.clear( );
+    _compiled.clear( );
+    _modules.clear( );
+  }
+}
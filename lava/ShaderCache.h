@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_SHADER_CACHE__
+#define __LAVA_SHADER_CACHE__
+
+#include "includes.hpp"
+
+#include <lava/noncopyable.hpp>
+#include <lava/WeakInternCache.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lava/api.h>
+
+namespace lava
+{
+  class ShaderModule;
+
+  /**
+  * Content-addressed shader storage owned by Device.
+  *   - SPIR-V files are read once and read again only if their size or
+  *     modification time change.
+  *   - Modules are shared by code: equal SPIR-V gives the same ShaderModule
+  *     while it is alive.
+  *   - Compiled SPIR-V (see lava::utility::GLSLToSPIRVCompiler) is kept in
+  *     memory and, when a directory is set, on disk as <key>.spv, so
+  *     restarts skip the compiler too. The key must hash everything that
+  *     changes the output: source, stage, defines and compiler version.
+  */
+  class ShaderCache : private NonCopyable<ShaderCache>
+  {
+  public:
+    typedef std::shared_ptr<const std::vector<uint32_t>> Code;
+
+    LAVA_API
+    ShaderCache( void );
+
+    // FNV-1a, seed chains several buffers into one key
+    LAVA_API
+    static uint64_t hash( const void* data, size_t size,
+      uint64_t seed = 14695981039346656037ULL );
+    LAVA_API
+    static inline uint64_t hash( const std::string& str,
+      uint64_t seed = 14695981039346656037ULL )
+    {
+      return hash( str.data( ), str.size( ), seed );
+    }
+
+    // Throws std::runtime_error if the file can not be read
+    LAVA_API
+    Code readFile( const std::string& filePath );
+
+    /**
+    * Returns the live module built from code or calls create and stores
+    *   the result. create runs without the lock held.
+    */
+    LAVA_API
+    std::shared_ptr<ShaderModule> getModule( vk::ArrayProxy<const uint32_t> code,
+      const std::function<std::shared_ptr<ShaderModule>( )>& create );
+
+    // Looks in memory, then on disk. Returns nullptr on a miss.
+    LAVA_API
+    Code findCompiled( uint64_t key );
+    LAVA_API
+    void storeCompiled( uint64_t key, const std::vector<uint32_t>& code );
+
+    // Existing directory for compiled SPIR-V. Empty (default) disables it.
+    LAVA_API
+    void setDirectory( const std::string& directory );
+    LAVA_API
+    std::string getDirectory( void ) const;
+
+    // Disabled caches always read, compile and create
+    LAVA_API
+    inline void setEnabled( bool enabled )
+    {
+      _enabled = enabled;
+    }
+    LAVA_API
+    inline bool isEnabled( void ) const
+    {
+      return _enabled;
+    }
+
+    LAVA_API
+    inline uint64_t hits( void ) const
+    {
+      return _hits.load( ) + _modules.hits( );
+    }
+    LAVA_API
+    inline uint64_t misses( void ) const
+    {
+      return _misses.load( ) + _modules.misses( );
+    }
+    LAVA_API
+    void resetCounters( void );
+    // Drops memory entries. Files on disk are kept.
+    LAVA_API
+    void clear( void );
+  protected:
+    struct FileEntry
+    {
+      int64_t time;
+      uint64_t size;
+      Code code;
+    };
+    // Modules are keyed by the code itself, so hash collisions can't match
+    struct CodeHash
+    {
+      size_t operator()( const std::vector<uint32_t>& code ) const
+      {
+        return static_cast< size_t >(
+          hash( code.data( ), code.size( ) * sizeof( uint32_t ) ) );
+      }
+    };
+    static bool readSpirv( const std::string& filePath,
+      std::vector<uint32_t>& code );
+    std::string compiledPath( uint64_t key ) const;
+
+    std::unordered_map<std::string, FileEntry> _files;
+    WeakInternCache<std::vector<uint32_t>, ShaderModule, CodeHash> _modules;
+    std::unordered_map<uint64_t, Code> _compiled;
+    std::string _directory;
+    std::atomic<bool> _enabled;
+    std::atomic<uint64_t> _hits;
+    std::atomic<uint64_t> _misses;
+    mutable std::mutex _mutex;
+  };
+}
+
+#endif /* __LAVA_SHADER_CACHE__ */
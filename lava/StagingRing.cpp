@@ -0,0 +1,275 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "StagingRing.h"
+
+#include <lava/Fence.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace lava
+{
+  StagingRing::StagingRing( vk::Device device, MemoryAllocator* allocator,
+    vk::DeviceSize capacity )
+    : _device( device )
+    , _allocator( allocator )
+    , _initialCapacity( capacity )
+    , _growCount( 0 )
+  {
+  }
+
+  StagingRing::~StagingRing( void )
+  {
+    if ( _current )
+    {
+      destroyChunk( *_current );
+    }
+    for ( auto& chunk : _retired )
+    {
+      destroyChunk( *chunk );
+    }
+  }
+
+  std::unique_ptr<StagingRing::Chunk> StagingRing::createChunk(
+    vk::DeviceSize capacity )
+  {
+    std::unique_ptr<Chunk> chunk( new Chunk( ) );
+    chunk->capacity = capacity;
+    chunk->head = 0;
+    chunk->tail = 0;
+
+    vk::BufferCreateInfo bci;
+    bci.size = capacity;
+    bci.usage = vk::BufferUsageFlagBits::eTransferSrc;
+    bci.sharingMode = vk::SharingMode::eExclusive;
+    chunk->buffer = _device.createBuffer( bci );
+
+    chunk->memory = _allocator->allocate(
+      _device.getBufferMemoryRequirements( chunk->buffer ),
+      vk::MemoryPropertyFlagBits::eHostVisible |
+      vk::MemoryPropertyFlagBits::eHostCoherent, true );
+    _device.bindBufferMemory( chunk->buffer, chunk->memory.memory,
+      chunk->memory.offset );
+    assert( chunk->memory.mapped );
+
+    return chunk;
+  }
+
+  void StagingRing::destroyChunk( Chunk& chunk )
+  {
+    _device.destroyBuffer( chunk.buffer );
+    _allocator->free( chunk.memory );
+  }
+
+  bool StagingRing::isComplete( const Entry& entry )
+  {
+    if ( !entry.submitted )
+    {
+      return false;
+    }
+    std::shared_ptr<Fence> fence = entry.fence.lock( );
+    return !fence || fence->isSignaled( );
+  }
+
+  void StagingRing::reclaim( Chunk& chunk )
+  {
+    while ( !chunk.entries.empty( ) )
+    {
+      const Entry& entry = chunk.entries.front( );
+      if ( !isComplete( entry ) )
+      {
+        break;
+      }
+      chunk.tail = entry.end;
+      chunk.entries.pop_front( );
+    }
+  }
+
+  bool StagingRing::tryAllocate( Chunk& chunk, vk::CommandBuffer owner,
+    vk::DeviceSize size, vk::DeviceSize alignment, StagingRegion& region )
+  {
+    auto alignUp = [ alignment ]( vk::DeviceSize v )
+    {
+      return ( v + alignment - 1 ) / alignment * alignment;
+    };
+    if ( chunk.entries.empty( ) )
+    {
+      // Nothing in flight, start over so a large request can fit again
+      chunk.head = chunk.tail = 0;
+    }
+    vk::DeviceSize start = alignUp( chunk.head );
+    vk::DeviceSize offset = start % chunk.capacity;
+    if ( offset + size > chunk.capacity )
+    {
+      // Doesn't fit at the end, wrap to the beginning
+      start = alignUp( start + chunk.capacity - offset );
+      offset = start % chunk.capacity;
+    }
+    if ( offset + size > chunk.capacity ||
+      start + size - chunk.tail > chunk.capacity )
+    {
+      return false;
+    }
+
+    chunk.head = start + size;
+    if ( !chunk.entries.empty( ) && chunk.entries.back( ).owner == owner &&
+      !chunk.entries.back( ).submitted )
+    {
+      chunk.entries.back( ).end = chunk.head;
+    }
+    else
+    {
+      chunk.entries.push_back(
+        Entry{ owner, chunk.head, false, std::weak_ptr<Fence>( ) } );
+    }
+
+    region.buffer = chunk.buffer;
+    region.offset = offset;
+    region.size = size;
+    region.data = static_cast< uint8_t* >( chunk.memory.mapped ) + offset;
+    return true;
+  }
+
+  StagingRegion StagingRing::allocate( vk::CommandBuffer owner,
+    vk::DeviceSize size, vk::DeviceSize alignment )
+  {
+    std::unique_lock<std::mutex> lock( _mutex );
+
+    StagingRegion region;
+
+    if ( !_current )
+    {
+      _current = createChunk( _initialCapacity );
+    }
+    reclaim( *_current );
+    reclaimRetired( );
+
+    if ( size <= _current->capacity )
+    {
+      bool allocated = tryAllocate( *_current, owner, size, alignment, region );
+      while ( !allocated && !_current->entries.empty( ) &&
+        _current->entries.front( ).submitted )
+      {
+        // Wait for the oldest submitted uploads without the lock, so other
+        //    threads keep allocating meanwhile
+        std::shared_ptr<Fence> fence = _current->entries.front( ).fence.lock( );
+        lock.unlock( );
+        if ( fence )
+        {
+          fence->wait( );
+          fence.reset( );
+        }
+        lock.lock( );
+        reclaim( *_current );
+        allocated = tryAllocate( *_current, owner, size, alignment, region );
+      }
+      if ( allocated )
+      {
+        return region;
+      }
+    }
+
+    // Pending regions not submitted yet (or request too big), grow the ring
+    vk::DeviceSize capacity = _current->capacity * 2;
+    while ( capacity < size )
+    {
+      capacity *= 2;
+    }
+    if ( _current->entries.empty( ) )
+    {
+      destroyChunk( *_current );
+    }
+    else
+    {
+      _retired.push_back( std::move( _current ) );
+    }
+    _current = createChunk( capacity );
+    ++_growCount;
+
+    bool ok = tryAllocate( *_current, owner, size, alignment, region );
+    assert( ok );
+    (void) ok;
+    return region;
+  }
+
+  StagingRegion StagingRing::write( vk::CommandBuffer owner, const void* data,
+    vk::DeviceSize size, vk::DeviceSize alignment )
+  {
+    StagingRegion region = allocate( owner, size, alignment );
+    memcpy( region.data, data, size );
+    return region;
+  }
+
+  void StagingRing::submitted(
+    vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
+    const std::shared_ptr<Fence>& fence )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    auto tag = [ & ]( Chunk& chunk )
+    {
+      for ( auto& entry : chunk.entries )
+      {
+        if ( !entry.submitted && std::find( commandBuffers.begin( ),
+          commandBuffers.end( ), entry.owner ) != commandBuffers.end( ) )
+        {
+          entry.submitted = true;
+          entry.fence = fence;
+        }
+      }
+    };
+    if ( _current )
+    {
+      tag( *_current );
+    }
+    for ( auto& chunk : _retired )
+    {
+      tag( *chunk );
+    }
+  }
+
+  void StagingRing::reclaim( void )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    if ( _current )
+    {
+      reclaim( *_current );
+    }
+    reclaimRetired( );
+  }
+
+  void StagingRing::reclaimRetired( void )
+  {
+    for ( auto it = _retired.begin( ); it != _retired.end( ); )
+    {
+      reclaim( **it );
+      if ( ( *it )->entries.empty( ) )
+      {
+        destroyChunk( **it );
+        it = _retired.erase( it );
+      }
+      else
+      {
+        ++it;
+      }
+    }
+  }
+}
@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_STAGING_RING__
+#define __LAVA_STAGING_RING__
+
+#include "includes.hpp"
+
+#include <lava/MemoryAllocator.h>
+#include <lava/noncopyable.hpp>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <lava/api.h>
+
+namespace lava
+{
+  class Fence;
+
+  // Piece of the staging ring, valid until the owner command buffer completes
+  struct StagingRegion
+  {
+    vk::Buffer buffer;
+    vk::DeviceSize offset = 0;
+    vk::DeviceSize size = 0;
+    void* data = nullptr;
+  };
+
+  /**
+  * Device-wide, persistently mapped upload buffer. Regions are bump-allocated
+  *   and tagged with the command buffer that consumes them; Queue::submit
+  *   attaches the submission fence, and the space is reclaimed once the
+  *   fence is signaled (or released, pooled fences are only released once
+  *   their work is done). Fences are referenced weakly, since they keep the
+  *   Device that owns the ring alive. Regions must be submitted before the
+  *   ring wraps around them, otherwise the ring grows.
+  */
+  class StagingRing : private NonCopyable<StagingRing>
+  {
+  public:
+    LAVA_API
+    StagingRing( vk::Device device, MemoryAllocator* allocator,
+      vk::DeviceSize capacity = 16 * 1024 * 1024 );
+    LAVA_API
+    virtual ~StagingRing( void );
+
+    LAVA_API
+    StagingRegion allocate( vk::CommandBuffer owner, vk::DeviceSize size,
+      vk::DeviceSize alignment = 16 );
+    // Allocates a region and copies the data into it
+    LAVA_API
+    StagingRegion write( vk::CommandBuffer owner, const void* data,
+      vk::DeviceSize size, vk::DeviceSize alignment = 16 );
+
+    // Called by Queue after submitting the command buffers.
+    LAVA_API
+    void submitted( vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
+      const std::shared_ptr<Fence>& fence );
+    // Releases the regions whose fence has been signaled.
+    LAVA_API
+    void reclaim( void );
+
+    LAVA_API
+    inline vk::DeviceSize capacity( void ) const
+    {
+      return _current ? _current->capacity : _initialCapacity;
+    }
+    // Times the ring had to grow, regions are not submitted soon enough
+    inline uint32_t growCount( void ) const
+    {
+      return _growCount.load( std::memory_order_relaxed );
+    }
+  protected:
+    struct Entry
+    {
+      vk::CommandBuffer owner;
+      // Ring position (monotonic) where the region ends
+      vk::DeviceSize end;
+      bool submitted;
+      std::weak_ptr<Fence> fence;
+    };
+    struct Chunk
+    {
+      vk::Buffer buffer;
+      MemoryAllocation memory;
+      vk::DeviceSize capacity;
+      vk::DeviceSize head;
+      vk::DeviceSize tail;
+      std::deque<Entry> entries;
+    };
+
+    std::unique_ptr<Chunk> createChunk( vk::DeviceSize capacity );
+    void destroyChunk( Chunk& chunk );
+    void reclaim( Chunk& chunk );
+    static bool isComplete( const Entry& entry );
+    void reclaimRetired( void );
+    bool tryAllocate( Chunk& chunk, vk::CommandBuffer owner,
+      vk::DeviceSize size, vk::DeviceSize alignment, StagingRegion& region );
+
+    vk::Device _device;
+    MemoryAllocator* _allocator;
+    vk::DeviceSize _initialCapacity;
+    std::unique_ptr<Chunk> _current;
+    // Chunks replaced by a bigger one, freed when their uploads complete
+    std::vector<std::unique_ptr<Chunk>> _retired;
+    std::atomic<uint32_t> _growCount;
+    std::mutex _mutex;
+  };
+}
+
+#endif /* __LAVA_STAGING_RING__ */
@@ -180,10 +180,10 @@ namespace lava
     for ( size_t i = 0; i < numImages; ++i )
     {
       _images.push_back( std::make_shared<Image>( _device, images[ i ] ) );
-      _presentCompleteSemaphores.push_back( _device->createSemaphore( ) );
+      _presentCompleteSemaphores.push_back( _device->acquireSemaphore( ) );
     }
 
-    _freeSemaphore = _device->createSemaphore( );
+    _freeSemaphore = _device->acquireSemaphore( );
 
     _format = surfaceFormat.format;
   }
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "SyncPool.h"
+
+namespace lava
+{
+  FencePool::FencePool( vk::Device device )
+    : _device( device )
+    , _created( 0 )
+  {
+  }
+
+  FencePool::~FencePool( void )
+  {
+    for ( auto& fence : _free )
+    {
+      _device.destroyFence( fence );
+    }
+    for ( auto& fence : _pendingReset )
+    {
+      _device.destroyFence( fence );
+    }
+  }
+
+  vk::Fence FencePool::acquire( void )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    if ( _free.empty( ) && !_pendingReset.empty( ) )
+    {
+      _device.resetFences( _pendingReset );
+      _free.swap( _pendingReset );
+    }
+
+    if ( _free.empty( ) )
+    {
+      ++_created;
+      return _device.createFence( vk::FenceCreateInfo( ) );
+    }
+
+    vk::Fence fence = _free.back( );
+    _free.pop_back( );
+    return fence;
+  }
+
+  void FencePool::release( vk::Fence fence )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    _pendingReset.push_back( fence );
+  }
+
+  SemaphorePool::SemaphorePool( vk::Device device )
+    : _device( device )
+    , _created( 0 )
+  {
+  }
+
+  SemaphorePool::~SemaphorePool( void )
+  {
+    for ( auto& semaphore : _free )
+    {
+      _device.destroySemaphore( semaphore );
+    }
+  }
+
+  vk::Semaphore SemaphorePool::acquire( void )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    if ( _free.empty( ) )
+    {
+      ++_created;
+      return _device.createSemaphore( vk::SemaphoreCreateInfo( ) );
+    }
+
+    vk::Semaphore semaphore = _free.back( );
+    _free.pop_back( );
+    return semaphore;
+  }
+
+  void SemaphorePool::release( vk::Semaphore semaphore )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    _free.push_back( semaphore );
+  }
+}
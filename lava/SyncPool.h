@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_SYNC_POOL__
+#define __LAVA_SYNC_POOL__
+
+#include "includes.hpp"
+
+#include <lava/noncopyable.hpp>
+#include <mutex>
+#include <vector>
+
+#include <lava/api.h>
+
+namespace lava
+{
+  /**
+  * Recycles fence handles. Released fences are reset in a single
+  *   vkResetFences call the next time the free list runs out.
+  */
+  class FencePool : private NonCopyable<FencePool>
+  {
+  public:
+    LAVA_API
+    FencePool( vk::Device device );
+    LAVA_API
+    virtual ~FencePool( void );
+
+    // Returns an unsignaled fence
+    LAVA_API
+    vk::Fence acquire( void );
+    // The fence must not be used by a pending submission
+    LAVA_API
+    void release( vk::Fence fence );
+
+    // Number of fences created by the pool
+    LAVA_API
+    inline uint32_t created( void ) const
+    {
+      return _created;
+    }
+  protected:
+    vk::Device _device;
+    std::vector<vk::Fence> _free;
+    std::vector<vk::Fence> _pendingReset;
+    uint32_t _created;
+    std::mutex _mutex;
+  };
+
+  /**
+  * Recycles binary semaphore handles. Binary semaphores can't be reset,
+  *   so only semaphores with no pending signal (unsignaled or already
+  *   waited on) may be released.
+  */
+  class SemaphorePool : private NonCopyable<SemaphorePool>
+  {
+  public:
+    LAVA_API
+    SemaphorePool( vk::Device device );
+    LAVA_API
+    virtual ~SemaphorePool( void );
+
+    LAVA_API
+    vk::Semaphore acquire( void );
+    LAVA_API
+    void release( vk::Semaphore semaphore );
+
+    // Number of semaphores created by the pool
+    LAVA_API
+    inline uint32_t created( void ) const
+    {
+      return _created;
+    }
+  protected:
+    vk::Device _device;
+    std::vector<vk::Semaphore> _free;
+    uint32_t _created;
+    std::mutex _mutex;
+  };
+}
+
+#endif /* __LAVA_SYNC_POOL__ */
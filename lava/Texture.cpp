@@ -19,11 +19,17 @@
 
 #include "Texture.h"
 
+#include "CommandBuffer.h"
 #include "Image.h"
 #include "PhysicalDevice.h"
+#include "Queue.h"
+#include "StagingRing.h"
 
 #include "utils.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 namespace lava
 {
   Texture::Texture(  const std::shared_ptr<Device>& device )
@@ -45,4 +51,107 @@ namespace lava
     descriptor.imageView = view;
     descriptor.sampler = sampler;
   }
+  void Texture::uploadMipmapped( const unsigned char* pixels,
+    vk::ImageCreateFlags createFlags, vk::Format format,
+    vk::ImageUsageFlags usageFlags, vk::ImageLayout finalLayout,
+    const std::shared_ptr<CommandPool>& cmdPool,
+    const std::shared_ptr<Queue>& queue )
+  {
+    const vk::DeviceSize layerSize = vk::DeviceSize( width ) * height * 4;
+    mipLevels = utils::mipLevelCount( width, height );
+    imageLayout = finalLayout;
+
+    // Blits need a graphics queue
+    std::shared_ptr<PhysicalDevice> physicalDevice = _device->getPhysicalDevice( );
+    bool blit = mipLevels > 1 &&
+      utils::supportsLinearBlit( physicalDevice, format ) &&
+      ( physicalDevice->getQueueFamilyProperties( )[
+        queue->getQueueFamilyIndex( ) ].queueFlags & vk::QueueFlagBits::eGraphics );
+
+    const unsigned char* data = pixels;
+    vk::DeviceSize layerStride = layerSize;
+    std::vector<unsigned char> chain;
+    if ( !blit && mipLevels > 1 )
+    {
+      layerStride = 0;
+      for ( uint32_t level = 0; level < mipLevels; ++level )
+      {
+        layerStride += vk::DeviceSize( std::max( width >> level, 1u ) ) *
+          std::max( height >> level, 1u ) * 4;
+      }
+      chain.resize( static_cast< size_t >( layerStride * layerCount ) );
+
+      // Layers are independent, each one builds its chain in its own slot
+      utils::parallelFor( layerCount, [ & ] ( uint32_t layer )
+      {
+        std::vector<unsigned char> levels = utils::buildMipChainRGBA8(
+          pixels + layer * layerSize, width, height, mipLevels );
+        memcpy( chain.data( ) + layer * layerStride, levels.data( ),
+          levels.size( ) );
+      } );
+      data = chain.data( );
+    }
+
+    auto copyCmd = cmdPool->allocateCommandBuffer( );
+    copyCmd->begin( vk::CommandBufferUsageFlagBits::eOneTimeSubmit );
+
+    StagingRegion staging = _device->getStagingRing( )->write( *copyCmd,
+      data, layerStride * layerCount );
+
+    usageFlags |= vk::ImageUsageFlagBits::eTransferDst;
+    if ( blit )
+    {
+      usageFlags |= vk::ImageUsageFlagBits::eTransferSrc;
+    }
+    image = _device->createImage( createFlags, vk::ImageType::e2D, format,
+      vk::Extent3D( width, height, 1 ), mipLevels, layerCount,
+      vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, usageFlags,
+      vk::SharingMode::eExclusive, { }, vk::ImageLayout::eUndefined,
+      vk::MemoryPropertyFlagBits::eDeviceLocal );
+
+    vk::ImageSubresourceRange subresourceRange(
+      vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, layerCount );
+    utils::transitionImageLayout( copyCmd, image, vk::ImageLayout::eUndefined,
+      vk::ImageLayout::eTransferDstOptimal, subresourceRange );
+
+    // One region per layer and uploaded level
+    uint32_t uploadedLevels = blit ? 1 : mipLevels;
+    std::vector<vk::BufferImageCopy> regions;
+    regions.reserve( layerCount * uploadedLevels );
+    for ( uint32_t layer = 0; layer < layerCount; ++layer )
+    {
+      vk::DeviceSize offset = layer * layerStride;
+      for ( uint32_t level = 0; level < uploadedLevels; ++level )
+      {
+        uint32_t w = std::max( width >> level, 1u );
+        uint32_t h = std::max( height >> level, 1u );
+
+        vk::BufferImageCopy region;
+        region.bufferOffset = offset;
+        region.imageSubresource = vk::ImageSubresourceLayers(
+          vk::ImageAspectFlagBits::eColor, level, layer, 1 );
+        region.imageExtent = vk::Extent3D( w, h, 1 );
+        regions.push_back( region );
+
+        offset += vk::DeviceSize( w ) * h * 4;
+      }
+    }
+    copyCmd->copyBufferToImage( staging, image,
+      vk::ImageLayout::eTransferDstOptimal, regions );
+
+    if ( blit )
+    {
+      utils::generateMipmaps( copyCmd, image, vk::Extent3D( width, height, 1 ),
+        mipLevels, layerCount, imageLayout );
+    }
+    else
+    {
+      utils::transitionImageLayout( copyCmd, image,
+        vk::ImageLayout::eTransferDstOptimal, imageLayout, subresourceRange );
+    }
+
+    copyCmd->end( );
+
+    queue->submitAndWait( copyCmd );
+  }
 }
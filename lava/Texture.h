@@ -31,6 +31,9 @@
 
 namespace lava
 {
+  class CommandPool;
+  class Queue;
+
   class Texture: public VulkanResource
   {
   public:
@@ -60,6 +63,18 @@ namespace lava
     uint32_t mipLevels;
     uint32_t layerCount;
     DescriptorImageInfo descriptor;
+  protected:
+    /**
+    * Creates image with a full mip chain from layerCount RGBA8 layers of
+    *   width x height, packed in pixels, and waits for the upload on queue.
+    *   Levels are blitted on the GPU when the format and queue allow it and
+    *   built on the CPU otherwise. Leaves every level in finalLayout.
+    */
+    void uploadMipmapped( const unsigned char* pixels,
+      vk::ImageCreateFlags createFlags, vk::Format format,
+      vk::ImageUsageFlags usageFlags, vk::ImageLayout finalLayout,
+      const std::shared_ptr<CommandPool>& cmdPool,
+      const std::shared_ptr<Queue>& queue );
   };
 }
 
@@ -21,6 +21,7 @@
 
 #include <lava/Buffer.h>
 #include <lava/PhysicalDevice.h>
+#include <lava/StagingRing.h>
 
 #include "utils.hpp"
 
@@ -54,12 +55,12 @@ namespace lava
 
     if ( useStaging )
     {
-      // Create a host-visible staging buffer that contains the raw image data
-      std::shared_ptr<Buffer> stagingBuffer = _device->createBuffer( texSize,
-        vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive, {},
-        vk::MemoryPropertyFlagBits::eHostVisible | 
-        vk::MemoryPropertyFlagBits::eHostCoherent );
-      stagingBuffer->writeData( 0, texSize, pixels );
+      auto copyCmd = cmdPool->allocateCommandBuffer( );
+      copyCmd->begin( vk::CommandBufferUsageFlagBits::eOneTimeSubmit );
+
+      // Copy the raw image data into the device staging ring
+      StagingRegion staging = _device->getStagingRing( )->write( *copyCmd,
+        pixels, texSize );
 
       free( pixels );
 
@@ -81,9 +82,6 @@ namespace lava
         vk::SharingMode::eExclusive, { }, vk::ImageLayout::eUndefined,
         vk::MemoryPropertyFlagBits::eDeviceLocal );
 
-      auto copyCmd = cmdPool->allocateCommandBuffer( );
-      copyCmd->begin( vk::CommandBufferUsageFlagBits::eOneTimeSubmit );
-
       // The sub resource range describes the regions of the image we will be transition
       vk::ImageSubresourceRange subresourceRange;
       // Image only contains color data
@@ -123,7 +121,7 @@ namespace lava
         1
       );
 
-      copyCmd->copyBufferToImage( stagingBuffer, image,
+      copyCmd->copyBufferToImage( staging, image,
         vk::ImageLayout::eTransferDstOptimal, { region } );
 
       // Change texture image layout to shader read after all mip levels have been copied
@@ -142,9 +140,6 @@ namespace lava
       copyCmd->end( );
 
       queue->submitAndWait( copyCmd );
-
-      // Clean up staging resources
-      stagingBuffer.reset( );
     }
     else
     {
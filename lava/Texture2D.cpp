@@ -21,9 +21,13 @@
 
 #include <lava/Buffer.h>
 #include <lava/PhysicalDevice.h>
+#include <lava/StagingRing.h>
+#include <lava/UploadEngine.h>
 
 #include "utils.hpp"
 
+#include <algorithm>
+
 namespace lava
 {
   Texture2D::Texture2D( const std::shared_ptr<Device>& device_, 
@@ -54,6 +58,99 @@ namespace lava
     createTexture( data.data( ), width, height, channels, cmdPool, queue, format,
       imageUsageFlags_, imageLayout_, forceLinear );
   }
+  Texture2D::Texture2D( const std::shared_ptr<Device>& device_,
+    const std::string& filename, const std::shared_ptr<UploadEngine>& uploader,
+    vk::Format format, vk::ImageUsageFlags imageUsageFlags_,
+    vk::ImageLayout imageLayout_ )
+    : Texture( device_ )
+  {
+    unsigned int channels;
+    unsigned char* pixels = lava::utils::loadImageTexture(
+      filename, width, height, channels );
+
+    createTexture( pixels, 0, uploader, format, imageUsageFlags_, imageLayout_ );
+
+    free( pixels );
+  }
+  Texture2D::Texture2D( const std::shared_ptr<Device>& device_,
+    const void* pixels, uint32_t width_, uint32_t height_,
+    const std::shared_ptr<UploadEngine>& uploader, vk::Format format,
+    vk::ImageUsageFlags imageUsageFlags_, vk::ImageLayout imageLayout_,
+    uint32_t mipLevels_ )
+    : Texture( device_ )
+  {
+    width = width_;
+    height = height_;
+    createTexture( pixels, mipLevels_, uploader, format, imageUsageFlags_,
+      imageLayout_ );
+  }
+  void Texture2D::createTexture( const void* pixels, uint32_t packedLevels,
+    const std::shared_ptr<UploadEngine>& uploader, vk::Format format,
+    vk::ImageUsageFlags imageUsageFlags_, vk::ImageLayout imageLayout_ )
+  {
+    const uint32_t channels = 4; // TODO: HARCODED utils::channelsFromFormat( format );
+
+    // The upload queue may not blit, so missing levels are built on the CPU
+    std::vector<unsigned char> chain;
+    if ( packedLevels == 0 )
+    {
+      mipLevels = utils::mipLevelCount( width, height );
+      chain = utils::buildMipChainRGBA8(
+        static_cast< const unsigned char* >( pixels ), width, height, mipLevels );
+      pixels = chain.data( );
+    }
+    else
+    {
+      mipLevels = packedLevels;
+    }
+    layerCount = 1;
+    imageLayout = imageLayout_;
+
+    image = _device->createImage( { }, vk::ImageType::e2D, format,
+      vk::Extent3D( width, height, 1 ), mipLevels, 1,
+      vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+      imageUsageFlags_ | vk::ImageUsageFlagBits::eTransferDst,
+      vk::SharingMode::eExclusive, { }, vk::ImageLayout::eUndefined,
+      vk::MemoryPropertyFlagBits::eDeviceLocal );
+
+    vk::ImageSubresourceRange subresourceRange(
+      vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1 );
+
+    std::vector<vk::BufferImageCopy> regions;
+    vk::DeviceSize texSize = 0;
+    for ( uint32_t level = 0; level < mipLevels; ++level )
+    {
+      uint32_t w = std::max( width >> level, 1u );
+      uint32_t h = std::max( height >> level, 1u );
+
+      vk::BufferImageCopy region;
+      region.bufferOffset = texSize;
+      region.imageSubresource = vk::ImageSubresourceLayers(
+        vk::ImageAspectFlagBits::eColor, level, 0, 1 );
+      region.imageExtent = vk::Extent3D( w, h, 1 );
+      regions.push_back( region );
+
+      texSize += vk::DeviceSize( w ) * h * channels;
+    }
+
+    uploader->upload( image, pixels, texSize, regions, subresourceRange,
+      imageLayout );
+
+    sampler = _device->createSampler( vk::Filter::eLinear, vk::Filter::eLinear,
+      vk::SamplerMipmapMode::eLinear, vk::SamplerAddressMode::eRepeat,
+      vk::SamplerAddressMode::eRepeat, vk::SamplerAddressMode::eRepeat,
+      0.0f, true, 1.0f, false, vk::CompareOp::eNever, 0.0f,
+      static_cast< float >( mipLevels ), vk::BorderColor::eFloatOpaqueWhite,
+      false );
+
+    view = image->createImageView( vk::ImageViewType::e2D, format,
+      vk::ComponentMapping( vk::ComponentSwizzle::eR, vk::ComponentSwizzle::eG,
+        vk::ComponentSwizzle::eB, vk::ComponentSwizzle::eA ),
+      vk::ImageSubresourceRange( vk::ImageAspectFlagBits::eColor, 0,
+        mipLevels, 0, 1 ) );
+
+    updateDescriptor( );
+  }
   void Texture2D::createTexture( void* pixels, uint32_t width_,
     uint32_t height_, short channels, const std::shared_ptr<CommandPool>& cmdPool,
     const std::shared_ptr<Queue>& queue_, vk::Format format_, 
@@ -70,107 +167,16 @@ namespace lava
     // limited amount of formats and features (mip maps, cubemaps, arrays, etc.)
     VkBool32 useStaging = !forceLinear_;
 
-    vk::DeviceSize texSize = width_ * height_ * channels;
-
     vk::Device device = static_cast< vk::Device >( *_device );
 
+    layerCount = 1;
+
     if ( useStaging )
     {
-      // Create a host-visible staging buffer that contains the raw image data
-      std::shared_ptr<Buffer> stagingBuffer = _device->createBuffer( texSize,
-        vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive, { },
-        vk::MemoryPropertyFlagBits::eHostVisible |
-        vk::MemoryPropertyFlagBits::eHostCoherent );
-      stagingBuffer->writeData( 0, texSize, pixels );
+      uploadMipmapped( static_cast< unsigned char* >( pixels ), { }, format_,
+        imageUsageFlags_, imageLayout_, cmdPool, queue_ );
 
       free( pixels );
-
-      // TODO: Generate MipLevels
-      mipLevels = 1;
-
-      // Create Image
-      auto usageFlags = imageUsageFlags_;
-
-      // Ensure that the TRANSFER_DST bit is set for staging
-      if ( !( usageFlags & vk::ImageUsageFlagBits::eTransferDst ) )
-      {
-        usageFlags |= vk::ImageUsageFlagBits::eTransferDst;
-      }
-
-      const uint32_t arraySize = 1;
-      image = _device->createImage( { }, vk::ImageType::e2D, format_,
-        vk::Extent3D( width, height, 1 ), mipLevels, arraySize,
-        vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, usageFlags,
-        vk::SharingMode::eExclusive, { }, vk::ImageLayout::eUndefined,
-        vk::MemoryPropertyFlagBits::eDeviceLocal );
-
-      auto copyCmd = cmdPool->allocateCommandBuffer( );
-      copyCmd->begin( vk::CommandBufferUsageFlagBits::eOneTimeSubmit );
-
-      // The sub resource range describes the regions of the image we will be transition
-      vk::ImageSubresourceRange subresourceRange;
-      // Image only contains color data
-      subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-      // Start at first mip level
-      subresourceRange.baseMipLevel = 0;
-      // We will transition on all mip levels
-      subresourceRange.levelCount = mipLevels;
-      // The 2D texture only has one layer
-      subresourceRange.layerCount = 1;
-
-      // Image barrier for optimal image (target)
-      // Optimal image will be used as destination for the copy
-      // Transition image layout VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-      utils::transitionImageLayout(
-        copyCmd,
-        image,
-        vk::ImageLayout::eUndefined,          // Old layout is undefined
-        vk::ImageLayout::eTransferDstOptimal, // New layout
-        subresourceRange
-      );
-
-      // Copy buffer to image
-      std::vector<vk::BufferImageCopy> bufferCopyRegions;
-      uint32_t offset = 0;
-      for ( uint32_t i = 0; i < mipLevels; ++i )
-      {
-        vk::BufferImageCopy region = { };
-        region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-        region.imageSubresource.mipLevel = i;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = 1;
-        region.imageExtent = vk::Extent3D(
-          width,
-          height,
-          1
-        );
-        region.bufferOffset = offset;
-        bufferCopyRegions.push_back( region );
-        offset += texSize;
-      }
-
-      copyCmd->copyBufferToImage( stagingBuffer, image,
-        vk::ImageLayout::eTransferDstOptimal, bufferCopyRegions );
-
-      // Change texture image layout to shader read after all mip levels have been copied
-      this->imageLayout = imageLayout_;
-
-      // Transition image layout VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-      utils::transitionImageLayout(
-        copyCmd,
-        image,
-        vk::ImageLayout::eTransferDstOptimal, // Older layout
-        imageLayout,                          // New layout
-        subresourceRange
-      );
-
-      // Send command buffer
-      copyCmd->end( );
-
-      queue_->submitAndWait( copyCmd );
-
-      // Clean up staging resources
-      stagingBuffer.reset( );
     }
     else
     {
@@ -179,9 +185,11 @@ namespace lava
       // depending on implementation (e.g. no mip maps, only one layer, etc.)
       assert( formatProps.linearTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage );
 
+      mipLevels = 1;
+
       // Check if this support is supported for linear tiling
       vk::Image mappableImage;
-      vk::DeviceMemory mappableMemory;
+      MemoryAllocation mappableMemory;
 
       vk::ImageCreateInfo ici;
       ici.imageType = vk::ImageType::e2D;
@@ -199,7 +207,8 @@ namespace lava
 
       mappableImage = device.createImage( ici );
       mappableMemory = _device->allocateImageMemory( mappableImage,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent );  // Allocate + bind
+        vk::MemoryPropertyFlagBits::eHostVisible |
+        vk::MemoryPropertyFlagBits::eHostCoherent, true );  // Allocate + bind
 
       vk::ImageSubresource subRes;
       subRes.aspectMask = vk::ImageAspectFlagBits::eColor;
@@ -240,11 +249,16 @@ namespace lava
     sampler = _device->createSampler( vk::Filter::eLinear, vk::Filter::eLinear,
       vk::SamplerMipmapMode::eLinear, vk::SamplerAddressMode::eRepeat,
       vk::SamplerAddressMode::eRepeat, vk::SamplerAddressMode::eRepeat,
-      0.0f, true, 1.0f, false, vk::CompareOp::eNever, 0.0f, 0.0f,
-      vk::BorderColor::eFloatOpaqueWhite, false );
+      0.0f, true, 1.0f, false, vk::CompareOp::eNever, 0.0f,
+      static_cast< float >( mipLevels ), vk::BorderColor::eFloatOpaqueWhite,
+      false );
 
     // Create image view
-    view = image->createImageView( vk::ImageViewType::e2D, format_ );
+    view = image->createImageView( vk::ImageViewType::e2D, format_,
+      vk::ComponentMapping( vk::ComponentSwizzle::eR, vk::ComponentSwizzle::eG,
+        vk::ComponentSwizzle::eB, vk::ComponentSwizzle::eA ),
+      vk::ImageSubresourceRange( vk::ImageAspectFlagBits::eColor, 0,
+        mipLevels, 0, 1 ) );
 
     updateDescriptor( );
   }
@@ -30,6 +30,8 @@
 
 namespace lava
 {
+  class UploadEngine;
+
   class Texture2D: public Texture
   {
   public:
@@ -48,7 +50,31 @@ namespace lava
       vk::ImageUsageFlags imageUsageFlags = vk::ImageUsageFlagBits::eSampled,
       vk::ImageLayout imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
       bool forceLinear = false );
+    /**
+    * Records the upload on uploader without waiting. The texture can be
+    *   used once the token returned by the next uploader->flush( ) is done.
+    */
+    LAVA_API
+    Texture2D( const std::shared_ptr<Device>& device, const std::string& filename,
+      const std::shared_ptr<UploadEngine>& uploader, vk::Format format,
+      vk::ImageUsageFlags imageUsageFlags = vk::ImageUsageFlagBits::eSampled,
+      vk::ImageLayout imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal );
+    /**
+    * Same as above from RGBA8 pixels already decoded (copied, not kept).
+    *   pixels holds mipLevels levels packed one after another, or only
+    *   level 0 if mipLevels is 0 and the chain is built here.
+    */
+    LAVA_API
+    Texture2D( const std::shared_ptr<Device>& device, const void* pixels,
+      uint32_t width, uint32_t height,
+      const std::shared_ptr<UploadEngine>& uploader, vk::Format format,
+      vk::ImageUsageFlags imageUsageFlags = vk::ImageUsageFlagBits::eSampled,
+      vk::ImageLayout imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+      uint32_t mipLevels = 0 );
   private:
+    void createTexture( const void* pixels, uint32_t packedLevels,
+      const std::shared_ptr<UploadEngine>& uploader, vk::Format format,
+      vk::ImageUsageFlags imageUsageFlags, vk::ImageLayout imageLayout );
     void createTexture( void* data, uint32_t width, uint32_t height, 
       short nChannels, const std::shared_ptr<CommandPool>& cmdPool,
       const std::shared_ptr<Queue>& queue, vk::Format format,
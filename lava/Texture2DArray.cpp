@@ -21,6 +21,7 @@
 
 #include <lava/Buffer.h>
 #include <lava/PhysicalDevice.h>
+#include <lava/StagingRing.h>
 
 #include "utils.hpp"
 
@@ -34,51 +35,11 @@ namespace lava
     vk::ImageLayout imageLayout_, bool forceLinear )
     : Texture( device_ )
   {
-    uint32_t textureWidth = 0;
-    uint32_t textureHeight = 0;
-    uint32_t textureChannels = 0;
     layerCount = filePaths.size( );
 
-    struct Image_
-    {
-      unsigned char* pixels;
-      uint32_t width;
-      uint32_t height;
-      uint32_t textureChannels;
-      uint32_t size;
-    };
-
-    std::vector<Image_> images;
-    uint32_t totalSize = 0;
-    images.reserve( filePaths.size( ) );
-    for ( uint32_t i = 0; i < layerCount; ++i )
-    {
-      unsigned char* pixels = lava::utils::loadImageTexture(
-        filePaths[ i ].c_str( ), textureWidth, textureHeight, textureChannels );
-
-      // The load function returns the original channel count, 
-      // but it was forced to 4 because of the last parameter
-      textureChannels = 4;
-
-      uint32_t size = textureWidth * textureHeight * textureChannels * sizeof( unsigned char );
-      images.push_back( { pixels, textureWidth, textureHeight, textureChannels, size } );
-      totalSize += size;
-    }
-
-    unsigned char* pixels = ( unsigned char* ) malloc( totalSize );
-    unsigned char* pixelData = pixels;
-    for ( uint32_t i = 0, l = images.size( ); i < l; ++i )
-    {
-      memcpy( pixelData, images[ i ].pixels, images[ i ].size );
-      pixelData += ( images[ i ].size / sizeof( unsigned char ) );
-    }
-    for ( uint32_t i = 0, l = images.size( ); i < l; ++i )
-    {
-      free( images[ i ].pixels );
-    }
-
-    width = textureWidth;
-    height = textureHeight;
+    // Layers decode in parallel into one buffer, uploaded with one copy
+    unsigned char* pixels = lava::utils::loadImageTextures( filePaths,
+      width, height );
 
     vk::FormatProperties formatProps =
       _device->getPhysicalDevice( )->getFormatProperties( format );
@@ -94,101 +55,10 @@ namespace lava
 
     if ( useStaging )
     {
-
-      // Create a host-visible staging buffer that contains the raw image data
-      std::shared_ptr<Buffer> stagingBuffer = _device->createBuffer( totalSize,
-        vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive, { },
-        vk::MemoryPropertyFlagBits::eHostVisible |
-        vk::MemoryPropertyFlagBits::eHostCoherent );
-      stagingBuffer->writeData( 0, totalSize, pixels );
+      uploadMipmapped( pixels, { }, format, imageUsageFlags,
+        imageLayout_, cmdPool, queue );
 
       free( pixels );
-
-      // TODO: Generate MipLevels
-      mipLevels = 1;
-
-      // Create Image
-      auto usageFlags = imageUsageFlags;
-
-      // Ensure that the TRANSFER_DST bit is set for staging
-      if ( !( usageFlags & vk::ImageUsageFlagBits::eTransferDst ) )
-      {
-        usageFlags |= vk::ImageUsageFlagBits::eTransferDst;
-      }
-
-      image = _device->createImage( { }, vk::ImageType::e2D, format,
-        vk::Extent3D( width, height, 1 ), mipLevels, layerCount,
-        vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, usageFlags,
-        vk::SharingMode::eExclusive, { }, vk::ImageLayout::eUndefined,
-        vk::MemoryPropertyFlagBits::eDeviceLocal );
-
-      auto copyCmd = cmdPool->allocateCommandBuffer( );
-      copyCmd->begin( vk::CommandBufferUsageFlagBits::eOneTimeSubmit );
-
-      // Setup buffer copy regions for each face including all of it's miplevels
-      std::vector<vk::BufferImageCopy> bufferCopyRegions;
-      uint32_t offset = 0;
-      for ( uint32_t face = 0; face < layerCount; ++face )
-      {
-        for ( uint32_t mipLevel = 0; mipLevel < 1; ++mipLevel )
-        {
-          vk::BufferImageCopy bic;
-          bic.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-          bic.imageSubresource.mipLevel = mipLevel;
-          bic.imageSubresource.baseArrayLayer = face;
-          bic.imageSubresource.layerCount = 1;
-          bic.imageExtent = vk::Extent3D( textureWidth, textureHeight, 1 );
-          bic.bufferOffset = offset;
-
-          bufferCopyRegions.push_back( bic );
-          offset += images[ face ].size;
-        }
-      }
-
-      // The sub resource range describes the regions of the image we will be transition
-      vk::ImageSubresourceRange subresourceRange;
-      // Image only contains color data
-      subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-      // Start at first mip level
-      subresourceRange.baseMipLevel = 0;
-      // We will transition on all mip levels
-      subresourceRange.levelCount = mipLevels;
-      subresourceRange.layerCount = layerCount;
-
-      // Image barrier for optimal image (target)
-      // Optimal image will be used as destination for the copy
-      // Transition image layout VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-      utils::transitionImageLayout(
-        copyCmd,
-        image,
-        vk::ImageLayout::eUndefined,          // Old layout is undefined
-        vk::ImageLayout::eTransferDstOptimal, // New layout
-        subresourceRange
-      );
-
-      // Copy the cube map faces from the staging buffer to the optimal tiled image
-      copyCmd->copyBufferToImage( stagingBuffer, image,
-        vk::ImageLayout::eTransferDstOptimal, { bufferCopyRegions } );
-
-      // Change texture image layout to shader read after all mip levels have been copied
-      this->imageLayout = imageLayout_;
-
-      // Transition image layout VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-      utils::transitionImageLayout(
-        copyCmd,
-        image,
-        vk::ImageLayout::eTransferDstOptimal, // Older layout
-        imageLayout,                          // New layout
-        subresourceRange
-      );
-
-      // Send command buffer
-      copyCmd->end( );
-
-      queue->submitAndWait( copyCmd );
-
-      // Clean up staging resources
-      stagingBuffer.reset( );
     }
     else
     {
@@ -197,9 +67,11 @@ namespace lava
       // depending on implementation (e.g. no mip maps, only one layer, etc.)
       assert( formatProps.linearTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage );
 
+      mipLevels = 1;
+
       // Check if this support is supported for linear tiling
       vk::Image mappableImage;
-      vk::DeviceMemory mappableMemory;
+      MemoryAllocation mappableMemory;
 
       vk::ImageCreateInfo ici;
       ici.imageType = vk::ImageType::e2D;
@@ -217,7 +89,8 @@ namespace lava
 
       mappableImage = device.createImage( ici );
       mappableMemory = _device->allocateImageMemory( mappableImage,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent );  // Allocate + bind
+        vk::MemoryPropertyFlagBits::eHostVisible |
+        vk::MemoryPropertyFlagBits::eHostCoherent, true );  // Allocate + bind
 
       vk::ImageSubresource subRes;
       subRes.aspectMask = vk::ImageAspectFlagBits::eColor;
@@ -258,11 +131,19 @@ namespace lava
     sampler = _device->createSampler( vk::Filter::eLinear, vk::Filter::eLinear,
       vk::SamplerMipmapMode::eLinear, vk::SamplerAddressMode::eClampToEdge,
       vk::SamplerAddressMode::eClampToEdge, vk::SamplerAddressMode::eClampToEdge,
-      0.0f, true, 1.0f, false, vk::CompareOp::eNever, 0.0f, 0.0f,
-      vk::BorderColor::eFloatOpaqueWhite, false );
+      0.0f, true, 1.0f, false, vk::CompareOp::eNever, 0.0f,
+      static_cast< float >( mipLevels ), vk::BorderColor::eFloatOpaqueWhite,
+      false );
 
     // Create image view
-    view = image->createImageView( vk::ImageViewType::e2DArray, format );
+    view = image->createImageView( vk::ImageViewType::e2DArray, format,
+      vk::ComponentMapping(
+        vk::ComponentSwizzle::eR, vk::ComponentSwizzle::eG,
+        vk::ComponentSwizzle::eB, vk::ComponentSwizzle::eA ),
+      vk::ImageSubresourceRange(
+        vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, layerCount
+      )
+    );
 
     updateDescriptor( );
   }
@@ -21,6 +21,7 @@
 
 #include <lava/Buffer.h>
 #include <lava/PhysicalDevice.h>
+#include <lava/StagingRing.h>
 
 #include "utils.hpp"
 
@@ -34,65 +35,24 @@ namespace lava
       vk::ImageLayout imageLayout_, bool forceLinear )
     : Texture( device_ )
   {
-    uint32_t textureWidth = 0;
-    uint32_t textureHeight = 0;
-    uint32_t channels = 0;
-
-    struct Image_
-    {
-      unsigned char* pixels;
-      uint32_t width;
-      uint32_t height;
-      uint32_t channels;
-      uint32_t size;
-    };
-
-    std::vector<Image_> images;
-    uint32_t totalSize = 0;
-    images.reserve( filePaths.size( ) );
-    for ( uint32_t i = 0, l = filePaths.size( ); i < l; ++i )
-    {
-      unsigned char* pixels = lava::utils::loadImageTexture(
-        filePaths[ i ].c_str( ), textureWidth, textureHeight, channels);
-
-      // The load function returns the original channel count, 
-      // but it was forced to 4 because of the last parameter
-      channels = 4;
-
-      uint32_t size = textureWidth * textureHeight * channels 
-        * sizeof( unsigned char );
-      images.push_back( { pixels, textureWidth, textureHeight, channels, size } );
-      totalSize += size;
-
-      auto deviceProps = _device->getPhysicalDevice( )->getDeviceProperties( );
-      if ( static_cast< uint32_t >( deviceProps.limits.maxImageDimensionCube ) < textureWidth ||
-        static_cast< uint32_t >( deviceProps.limits.maxImageDimensionCube ) < textureHeight )
-      {
-        printf( "%s is too big (%dx%d), max supported size is %dx%d.\n", 
-          filePaths[ i ].c_str( ), textureWidth, textureHeight,
-          deviceProps.limits.maxImageDimensionCube, 
-          deviceProps.limits.maxImageDimensionCube
-        );
-        textureWidth = deviceProps.limits.maxImageDimensionCube;
-        textureHeight = deviceProps.limits.maxImageDimensionCube;
-      }
-    }
-
-    unsigned char* pixels = ( unsigned char* ) malloc( totalSize );
-    unsigned char* pixelData = pixels;
-    for ( uint32_t i = 0, l = images.size( ); i < l; ++i )
+    // Faces decode in parallel into one buffer, uploaded with one copy
+    unsigned char* pixels = lava::utils::loadImageTextures(
+      std::vector<std::string>( filePaths.begin( ), filePaths.end( ) ),
+      width, height );
+
+    auto deviceProps = _device->getPhysicalDevice( )->getDeviceProperties( );
+    if ( static_cast< uint32_t >( deviceProps.limits.maxImageDimensionCube ) < width ||
+      static_cast< uint32_t >( deviceProps.limits.maxImageDimensionCube ) < height )
     {
-      memcpy( pixelData, images[ i ].pixels, images[ i ].size );
-      pixelData += ( images[ i ].size / sizeof( unsigned char ) );
-    }
-    for ( uint32_t i = 0, l = images.size( ); i < l; ++i )
-    {
-      free( images[ i ].pixels );
+      printf( "%s is too big (%dx%d), max supported size is %dx%d.\n", 
+        filePaths[ 0 ].c_str( ), width, height,
+        deviceProps.limits.maxImageDimensionCube, 
+        deviceProps.limits.maxImageDimensionCube
+      );
+      width = deviceProps.limits.maxImageDimensionCube;
+      height = deviceProps.limits.maxImageDimensionCube;
     }
 
-    width = textureWidth;
-    height = textureHeight;
-
     vk::FormatProperties formatProps =
       _device->getPhysicalDevice( )->getFormatProperties( format );
 
@@ -105,110 +65,13 @@ namespace lava
 
     if ( useStaging )
     {
-      // Create a host-visible staging buffer that contains the raw image data
-      std::shared_ptr<Buffer> stagingBuffer = _device->createBuffer( totalSize,
-        vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive, { },
-        vk::MemoryPropertyFlagBits::eHostVisible |
-        vk::MemoryPropertyFlagBits::eHostCoherent );
-      stagingBuffer->writeData( 0, totalSize, pixels );
+      // Cube faces count as array layers in Vulkan
+      layerCount = 6;
+      // This flag is required for cube map images
+      uploadMipmapped( pixels, vk::ImageCreateFlagBits::eCubeCompatible,
+        format, imageUsageFlags, imageLayout_, cmdPool, queue );
 
       free( pixels );
-
-      // TODO: Generate MipLevels
-      mipLevels = 1;
-
-      // Create Image
-      auto usageFlags = imageUsageFlags;
-
-      // Ensure that the TRANSFER_DST bit is set for staging
-      if ( !( usageFlags & vk::ImageUsageFlagBits::eTransferDst ) )
-      {
-        usageFlags |= vk::ImageUsageFlagBits::eTransferDst;
-      }
-
-      image = _device->createImage(
-        // This flag is required for cube map images
-        vk::ImageCreateFlagBits::eCubeCompatible,
-        vk::ImageType::e2D, format,
-        vk::Extent3D( textureWidth, textureHeight, 1 ), mipLevels, 
-        // Cube faces count as array layers in Vulkan
-        6,
-        vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, usageFlags,
-        vk::SharingMode::eExclusive, { }, vk::ImageLayout::eUndefined,
-        vk::MemoryPropertyFlagBits::eDeviceLocal );
-
-      auto copyCmd = cmdPool->allocateCommandBuffer( );
-      copyCmd->begin( vk::CommandBufferUsageFlagBits::eOneTimeSubmit );
-
-      // Setup buffer copy regions for each face including all of it's miplevels
-      std::vector<vk::BufferImageCopy> bufferCopyRegions;
-      uint32_t offset = 0;
-      for ( uint32_t face = 0; face < 6; ++face )
-      {
-        for ( uint32_t mipLevel = 0; mipLevel < 1; ++mipLevel )
-        {
-          vk::BufferImageCopy bic;
-          bic.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-          bic.imageSubresource.mipLevel = mipLevel;
-          bic.imageSubresource.baseArrayLayer = face;
-          bic.imageSubresource.layerCount = 1;
-          bic.imageExtent.width = textureWidth;
-          bic.imageExtent.height = textureHeight;
-          bic.imageExtent.depth = 1;
-          bic.bufferOffset = offset;
-          
-          bufferCopyRegions.push_back( bic );
-          offset += images[ face ].size;
-        }
-      }
-
-      // The sub resource range describes the regions of the image we will be transition
-      vk::ImageSubresourceRange subresourceRange;
-      // Image only contains color data
-      subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-      // Start at first mip level
-      subresourceRange.baseMipLevel = 0;
-      // We will transition on all mip levels
-      subresourceRange.levelCount = 1;// TODO: mipLevels;
-                                      // The cubemap texture has six layers
-      subresourceRange.layerCount = 6;
-
-      // Image barrier for optimal image (target)
-      // Optimal image will be used as destination for the copy
-      // Transition image layout VK_IMAGE_LAYOUT_UNDEFINED 
-      //    to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-      utils::transitionImageLayout(
-        copyCmd,
-        image,
-        vk::ImageLayout::eUndefined,          // Old layout is undefined
-        vk::ImageLayout::eTransferDstOptimal, // New layout
-        subresourceRange
-      );
-
-      // Copy the cube map faces from the staging buffer to the optimal tiled image
-      copyCmd->copyBufferToImage( stagingBuffer, image,
-        vk::ImageLayout::eTransferDstOptimal, bufferCopyRegions );
-
-      // Change texture image layout to shader read after all mip levels have been copied
-      this->imageLayout = imageLayout_;
-
-      // Transition image layout VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-      //    to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-      utils::transitionImageLayout(
-        copyCmd,
-        image,
-        vk::ImageLayout::eTransferDstOptimal, // Older layout
-        imageLayout,                          // New layout
-        subresourceRange
-      );
-
-      // Send command buffer
-      copyCmd->end( );
-
-      queue->submitAndWait( copyCmd );
-
-      // Clean up staging resources
-      stagingBuffer.reset( );
     }
     else
     {
@@ -218,9 +81,11 @@ namespace lava
       assert( formatProps.linearTilingFeatures & 
         vk::FormatFeatureFlagBits::eSampledImage );
 
+      mipLevels = 1;
+
       // Check if this support is supported for linear tiling
       vk::Image mappableImage;
-      vk::DeviceMemory mappableMemory;
+      MemoryAllocation mappableMemory;
 
       vk::ImageCreateInfo ici;
       ici.imageType = vk::ImageType::e2D;
@@ -242,15 +107,14 @@ namespace lava
       /*TODOmappableImage = device.createImage( ici );
       mappableMemory = _device->allocateImageMemory( mappableImage,
         vk::MemoryPropertyFlagBits::eHostVisible | 
-        vk::MemoryPropertyFlagBits::eHostCoherent );  // Allocate + bind
+        vk::MemoryPropertyFlagBits::eHostCoherent, true );  // Allocate + bind
 
       vk::ImageSubresource subRes;
       subRes.aspectMask = vk::ImageAspectFlagBits::eColor;
       subRes.mipLevel = 0;
 
-      void* data = device.mapMemory( mappableMemory, 0, totalSize );
+      void* data = mappableMemory.mapped;
       memcpy( data, pixels, totalSize );
-      device.unmapMemory( mappableMemory );
 
       // Linear tiled images don't need to be staged
       // and can be directly used as textures
@@ -280,8 +144,9 @@ namespace lava
     sampler = _device->createSampler( vk::Filter::eLinear, vk::Filter::eLinear,
       vk::SamplerMipmapMode::eLinear, vk::SamplerAddressMode::eClampToEdge,
       vk::SamplerAddressMode::eClampToEdge, vk::SamplerAddressMode::eClampToEdge,
-      0.0f, true, 1.0f, false, vk::CompareOp::eNever, 0.0f, 0.0f,
-      vk::BorderColor::eFloatOpaqueWhite, false );
+      0.0f, true, 1.0f, false, vk::CompareOp::eNever, 0.0f,
+      static_cast< float >( mipLevels ), vk::BorderColor::eFloatOpaqueWhite,
+      false );
 
     // Create image view
     view = image->createImageView( vk::ImageViewType::eCube, format,
@@ -290,7 +155,7 @@ namespace lava
         vk::ComponentSwizzle::eB, vk::ComponentSwizzle::eA ),
       vk::ImageSubresourceRange(
         // 6 array layers (faces)
-        vk::ImageAspectFlagBits::eColor, 0, 1, 0, 6
+        vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 6
       )
     );
 
@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "UniformArena.h"
+
+#include <lava/Buffer.h>
+#include <lava/Descriptor.h>
+#include <lava/PhysicalDevice.h>
+
+#include <algorithm>
+
+namespace lava
+{
+  UniformArena::UniformArena( const std::shared_ptr<Device>& device,
+    vk::DeviceSize frameSize, uint32_t framesInFlight,
+    vk::DeviceSize maxRange, vk::ShaderStageFlags stages, uint32_t binding )
+    : VulkanResource( device )
+    , _frameSize( frameSize )
+    , _maxRange( maxRange )
+    , _head( 0 )
+    , _currentFrame( 0 )
+  {
+    const vk::PhysicalDeviceLimits& limits =
+      _device->getPhysicalDevice( )->getDeviceProperties( ).limits;
+    _alignment = std::max< vk::DeviceSize >( 1,
+      limits.minUniformBufferOffsetAlignment );
+    assert( _maxRange <= limits.maxUniformBufferRange );
+
+    _descriptorSetLayout = _device->createDescriptorSetLayout( {
+      DescriptorSetLayoutBinding( binding,
+        vk::DescriptorType::eUniformBufferDynamic, stages )
+    } );
+    _descriptorPool = _device->createDescriptorPool( framesInFlight, {
+      vk::DescriptorPoolSize( vk::DescriptorType::eUniformBufferDynamic,
+        framesInFlight )
+    } );
+
+    _frames.resize( framesInFlight );
+    for ( auto& frame : _frames )
+    {
+      // Extra maxRange so the bound range never goes past the buffer end
+      frame.buffer = _device->createBuffer( _frameSize + _maxRange,
+        vk::BufferUsageFlagBits::eUniformBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible |
+        vk::MemoryPropertyFlagBits::eHostCoherent );
+      frame.descriptorSet = _device->allocateDescriptorSet( _descriptorPool,
+        _descriptorSetLayout );
+
+      std::vector<WriteDescriptorSet> wdss;
+      DescriptorBufferInfo bufferInfo( frame.buffer, 0, _maxRange );
+      wdss.push_back( WriteDescriptorSet( frame.descriptorSet, binding, 0,
+        vk::DescriptorType::eUniformBufferDynamic, 1, nullptr, bufferInfo ) );
+      _device->updateDescriptorSets( wdss, { } );
+    }
+  }
+
+  UniformArena::~UniformArena( void )
+  {
+    _frames.clear( );
+  }
+
+  void UniformArena::beginFrame( uint32_t frameIndex )
+  {
+    assert( frameIndex < _frames.size( ) );
+    _currentFrame = frameIndex;
+    _head = 0;
+  }
+
+  UniformAllocation UniformArena::allocate( vk::DeviceSize size )
+  {
+    assert( size <= _maxRange );
+
+    vk::DeviceSize offset = ( _head + _alignment - 1 ) / _alignment * _alignment;
+    if ( offset + size > _frameSize )
+    {
+      throw std::runtime_error( "UniformArena: frame size exceeded" );
+    }
+    _head = offset + size;
+
+    const Frame& frame = _frames[ _currentFrame ];
+
+    UniformAllocation alloc;
+    alloc.descriptorSet = frame.descriptorSet;
+    alloc.dynamicOffset = static_cast< uint32_t >( offset );
+    alloc.data = static_cast< uint8_t* >( frame.buffer->data( ) ) + offset;
+    return alloc;
+  }
+}
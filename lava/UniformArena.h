@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_UNIFORM_ARENA__
+#define __LAVA_UNIFORM_ARENA__
+
+#include "includes.hpp"
+
+#include "VulkanResource.h"
+#include "noncopyable.hpp"
+
+#include <lava/api.h>
+
+#include <cstring>
+#include <vector>
+
+namespace lava
+{
+  class Buffer;
+  class DescriptorPool;
+  class DescriptorSet;
+  class DescriptorSetLayout;
+
+  // Slice of the arena. Valid until the arena begins the same frame again.
+  struct UniformAllocation
+  {
+    std::shared_ptr<DescriptorSet> descriptorSet;
+    uint32_t dynamicOffset;
+    void* data;
+  };
+
+  /**
+  * Frame-scoped linear allocator for uniform data. Every frame in flight
+  *   owns a persistently mapped buffer and a descriptor set with a single
+  *   eUniformBufferDynamic binding; allocations are aligned bumps on that
+  *   buffer, so drawing N objects needs one descriptor set and N dynamic
+  *   offsets instead of N buffers and N descriptor writes.
+  */
+  class UniformArena : public VulkanResource, private NonCopyable<UniformArena>
+  {
+  public:
+    /**
+    * frameSize: bytes available per frame.
+    * maxRange: biggest struct that will be allocated (descriptor range).
+    */
+    LAVA_API
+    UniformArena( const std::shared_ptr<Device>& device,
+      vk::DeviceSize frameSize, uint32_t framesInFlight,
+      vk::DeviceSize maxRange, vk::ShaderStageFlags stages,
+      uint32_t binding = 0 );
+    LAVA_API
+    virtual ~UniformArena( void );
+
+    // Layout to use in the pipeline layout for the arena set
+    LAVA_API
+    inline const std::shared_ptr<DescriptorSetLayout>&
+      getDescriptorSetLayout( void ) const
+    {
+      return _descriptorSetLayout;
+    }
+
+    /**
+    * Starts writing on the slot of frameIndex. The caller must ensure the
+    *   GPU work that used this slot the last time has finished.
+    */
+    LAVA_API
+    void beginFrame( uint32_t frameIndex );
+
+    LAVA_API
+    UniformAllocation allocate( vk::DeviceSize size );
+
+    template <typename T>
+    UniformAllocation push( const T& value )
+    {
+      UniformAllocation alloc = allocate( sizeof( T ) );
+      memcpy( alloc.data, &value, sizeof( T ) );
+      return alloc;
+    }
+
+    LAVA_API
+    inline vk::DeviceSize used( void ) const
+    {
+      return _head;
+    }
+    LAVA_API
+    inline uint32_t framesInFlight( void ) const
+    {
+      return static_cast< uint32_t >( _frames.size( ) );
+    }
+  protected:
+    struct Frame
+    {
+      std::shared_ptr<Buffer> buffer;
+      std::shared_ptr<DescriptorSet> descriptorSet;
+    };
+
+    std::shared_ptr<DescriptorSetLayout> _descriptorSetLayout;
+    std::shared_ptr<DescriptorPool> _descriptorPool;
+    std::vector<Frame> _frames;
+    vk::DeviceSize _frameSize;
+    vk::DeviceSize _maxRange;
+    vk::DeviceSize _alignment;
+    vk::DeviceSize _head;
+    uint32_t _currentFrame;
+  };
+}
+
+#endif /* __LAVA_UNIFORM_ARENA__ */
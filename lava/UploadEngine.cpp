@@ -0,0 +1,211 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "UploadEngine.h"
+
+#include <lava/Buffer.h>
+#include <lava/Fence.h>
+#include <lava/Image.h>
+#include <lava/Queue.h>
+#include <lava/RetirementQueue.h>
+#include <lava/Semaphore.h>
+#include <lava/StagingRing.h>
+
+namespace lava
+{
+  bool UploadToken::isComplete( void ) const
+  {
+    return !fence || fence->isSignaled( );
+  }
+
+  void UploadToken::wait( void ) const
+  {
+    if ( fence )
+    {
+      fence->wait( );
+    }
+  }
+
+  UploadEngine::UploadEngine( const std::shared_ptr<Device>& device,
+    const std::shared_ptr<Queue>& transferQueue, uint32_t dstFamilyIndex )
+    : VulkanResource( device )
+    , _queue( transferQueue )
+    , _srcFamilyIndex( transferQueue->getQueueFamilyIndex( ) )
+    , _dstFamilyIndex( dstFamilyIndex )
+  {
+    _commandPool = _device->createCommandPool(
+      vk::CommandPoolCreateFlagBits::eTransient |
+      vk::CommandPoolCreateFlagBits::eResetCommandBuffer, _srcFamilyIndex );
+  }
+
+  UploadEngine::~UploadEngine( void )
+  {
+    // Pending uploads are submitted so the staging space gets reclaimed
+    flush( );
+  }
+
+  void UploadEngine::beginRecording( void )
+  {
+    if ( !_cmd )
+    {
+      if ( !_inFlight.empty( ) && _inFlight.front( ).second->isSignaled( ) )
+      {
+        _cmd = _inFlight.front( ).first;
+        _inFlight.pop_front( );
+        _cmd->reset( );
+      }
+      else
+      {
+        _cmd = _commandPool->allocateCommandBuffer( );
+      }
+      _cmd->begin( vk::CommandBufferUsageFlagBits::eOneTimeSubmit );
+      _releaseStage = vk::PipelineStageFlags( );
+      _token = UploadToken( );
+    }
+  }
+
+  void UploadEngine::upload( const std::shared_ptr<Buffer>& dstBuffer,
+    const void* data, vk::DeviceSize size, vk::DeviceSize dstOffset,
+    vk::AccessFlags dstAccess, vk::PipelineStageFlags dstStage )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    beginRecording( );
+
+    StagingRegion staging = _device->getStagingRing( )->write( *_cmd, data,
+      size );
+    _cmd->copyBuffer( staging, dstBuffer, dstOffset );
+
+    vk::BufferMemoryBarrier release( vk::AccessFlagBits::eTransferWrite,
+      dstAccess, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+      *dstBuffer, dstOffset, size );
+    if ( transfersOwnership( ) )
+    {
+      release.srcQueueFamilyIndex = _srcFamilyIndex;
+      release.dstQueueFamilyIndex = _dstFamilyIndex;
+
+      vk::BufferMemoryBarrier acquire = release;
+      acquire.srcAccessMask = vk::AccessFlags( );
+      release.dstAccessMask = vk::AccessFlags( );
+      _token.bufferBarriers.push_back( acquire );
+    }
+    _bufferReleases.push_back( release );
+    _releaseStage |= dstStage;
+    _token.waitStage |= dstStage;
+    _resources.push_back( dstBuffer );
+  }
+
+  void UploadEngine::upload( const std::shared_ptr<Image>& dstImage,
+    const void* data, vk::DeviceSize size,
+    vk::ArrayProxy<const vk::BufferImageCopy> regions,
+    const vk::ImageSubresourceRange& range, vk::ImageLayout finalLayout,
+    vk::PipelineStageFlags dstStage )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    beginRecording( );
+
+    StagingRegion staging = _device->getStagingRing( )->write( *_cmd, data,
+      size );
+
+    ImageMemoryBarrier toTransfer( vk::AccessFlags( ),
+      vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eUndefined,
+      vk::ImageLayout::eTransferDstOptimal, VK_QUEUE_FAMILY_IGNORED,
+      VK_QUEUE_FAMILY_IGNORED, dstImage, range );
+    _cmd->pipelineBarrier( vk::PipelineStageFlagBits::eTopOfPipe,
+      vk::PipelineStageFlagBits::eTransfer, { }, { }, { }, toTransfer );
+
+    _cmd->copyBufferToImage( staging, dstImage,
+      vk::ImageLayout::eTransferDstOptimal, regions );
+
+    vk::AccessFlags dstAccess = vk::AccessFlagBits::eShaderRead;
+    if ( transfersOwnership( ) )
+    {
+      // Layout transition happens once, as part of the ownership transfer
+      _imageReleases.push_back( ImageMemoryBarrier(
+        vk::AccessFlagBits::eTransferWrite, vk::AccessFlags( ),
+        vk::ImageLayout::eTransferDstOptimal, finalLayout,
+        _srcFamilyIndex, _dstFamilyIndex, dstImage, range ) );
+      _token.imageBarriers.push_back( ImageMemoryBarrier(
+        vk::AccessFlags( ), dstAccess,
+        vk::ImageLayout::eTransferDstOptimal, finalLayout,
+        _srcFamilyIndex, _dstFamilyIndex, dstImage, range ) );
+    }
+    else
+    {
+      _imageReleases.push_back( ImageMemoryBarrier(
+        vk::AccessFlagBits::eTransferWrite, dstAccess,
+        vk::ImageLayout::eTransferDstOptimal, finalLayout,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, dstImage, range ) );
+    }
+    _releaseStage |= dstStage;
+    _token.waitStage |= dstStage;
+    _resources.push_back( dstImage );
+  }
+
+  UploadToken UploadEngine::flush( void )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    if ( !_cmd )
+    {
+      return UploadToken( );
+    }
+
+    // On a transfer only queue the release can't name graphics stages
+    vk::PipelineStageFlags releaseStage = transfersOwnership( ) ?
+      vk::PipelineStageFlagBits::eBottomOfPipe : _releaseStage;
+    _cmd->pipelineBarrier( vk::PipelineStageFlagBits::eTransfer, releaseStage,
+      { }, { }, _bufferReleases, _imageReleases );
+    _cmd->end( );
+
+    UploadToken token = std::move( _token );
+    token.fence = _device->acquireFence( );
+    // Not pooled: the consumer may never wait on it, and a binary semaphore
+    //    with a pending signal can't be recycled
+    token.semaphore = _device->createSemaphore( );
+    if ( !token.waitStage )
+    {
+      token.waitStage = vk::PipelineStageFlagBits::eTopOfPipe;
+    }
+
+    _queue->submit( SubmitInfo( nullptr, nullptr, _cmd, token.semaphore ),
+      token.fence );
+    _device->getRetirementQueue( )->retire( token.fence,
+      std::make_shared<std::vector<std::shared_ptr<void>>>(
+        std::move( _resources ) ) );
+
+    _inFlight.push_back( std::make_pair( _cmd, token.fence ) );
+    _cmd.reset( );
+    _resources.clear( );
+    _bufferReleases.clear( );
+    _imageReleases.clear( );
+    _token = UploadToken( );
+
+    return token;
+  }
+
+  void UploadEngine::acquire( const std::shared_ptr<CommandBuffer>& cmd,
+    const UploadToken& token ) const
+  {
+    if ( token.bufferBarriers.empty( ) && token.imageBarriers.empty( ) )
+    {
+      return;
+    }
+    cmd->pipelineBarrier( vk::PipelineStageFlagBits::eTopOfPipe,
+      token.waitStage, { }, { }, token.bufferBarriers, token.imageBarriers );
+  }
+}
@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_UPLOAD_ENGINE__
+#define __LAVA_UPLOAD_ENGINE__
+
+#include "includes.hpp"
+
+#include "CommandBuffer.h"
+#include "VulkanResource.h"
+#include "noncopyable.hpp"
+
+#include <lava/api.h>
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace lava
+{
+  class Buffer;
+  class Fence;
+  class Image;
+  class Queue;
+  class Semaphore;
+
+  /**
+  * Returned by UploadEngine::flush. The submission that uses the uploaded
+  *   resources must wait on semaphore at waitStage and record the acquire
+  *   barriers first (UploadEngine::acquire), or the caller can block on
+  *   wait( ) instead.
+  */
+  struct UploadToken
+  {
+    std::shared_ptr<Semaphore> semaphore;
+    std::shared_ptr<Fence> fence;
+    vk::PipelineStageFlags waitStage;
+    // Acquire half of the queue family ownership transfer
+    std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+    std::vector<ImageMemoryBarrier> imageBarriers;
+
+    LAVA_API
+    inline explicit operator bool( void ) const
+    {
+      return static_cast< bool >( fence );
+    }
+    LAVA_API
+    bool isComplete( void ) const;
+    LAVA_API
+    void wait( void ) const;
+  };
+
+  /**
+  * Records uploads on a transfer queue (a dedicated transfer family when
+  *   the device exposes one) and submits them in a single command buffer
+  *   per flush, so graphics work keeps running while assets upload.
+  *   Resources must be created with eExclusive sharing; ownership is
+  *   released to dstFamilyIndex on the transfer side.
+  */
+  class UploadEngine : public VulkanResource, private NonCopyable<UploadEngine>
+  {
+  public:
+    LAVA_API
+    UploadEngine( const std::shared_ptr<Device>& device,
+      const std::shared_ptr<Queue>& transferQueue, uint32_t dstFamilyIndex );
+    LAVA_API
+    virtual ~UploadEngine( void );
+
+    LAVA_API
+    void upload( const std::shared_ptr<Buffer>& dstBuffer, const void* data,
+      vk::DeviceSize size, vk::DeviceSize dstOffset = 0,
+      vk::AccessFlags dstAccess = vk::AccessFlagBits::eVertexAttributeRead |
+        vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eUniformRead,
+      vk::PipelineStageFlags dstStage = vk::PipelineStageFlagBits::eVertexInput |
+        vk::PipelineStageFlagBits::eVertexShader |
+        vk::PipelineStageFlagBits::eFragmentShader );
+
+    /**
+    * Copies data into the image (region bufferOffsets are relative to data)
+    *   and leaves range in finalLayout. The image contents are discarded.
+    */
+    LAVA_API
+    void upload( const std::shared_ptr<Image>& dstImage, const void* data,
+      vk::DeviceSize size, vk::ArrayProxy<const vk::BufferImageCopy> regions,
+      const vk::ImageSubresourceRange& range,
+      vk::ImageLayout finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+      vk::PipelineStageFlags dstStage =
+        vk::PipelineStageFlagBits::eFragmentShader );
+
+    // Submits the pending uploads. Returns an empty token if there were none.
+    LAVA_API
+    UploadToken flush( void );
+
+    // Records the acquire barriers of token on the consumer command buffer
+    LAVA_API
+    void acquire( const std::shared_ptr<CommandBuffer>& cmd,
+      const UploadToken& token ) const;
+
+    LAVA_API
+    inline bool transfersOwnership( void ) const
+    {
+      return _srcFamilyIndex != _dstFamilyIndex;
+    }
+  protected:
+    void beginRecording( void );
+
+    std::shared_ptr<Queue> _queue;
+    std::shared_ptr<CommandPool> _commandPool;
+    uint32_t _srcFamilyIndex;
+    uint32_t _dstFamilyIndex;
+
+    // Pending batch
+    std::shared_ptr<CommandBuffer> _cmd;
+    // Submitted command buffers, recycled once their fence signals
+    std::deque<std::pair<std::shared_ptr<CommandBuffer>,
+      std::shared_ptr<Fence>>> _inFlight;
+    std::vector<vk::BufferMemoryBarrier> _bufferReleases;
+    std::vector<ImageMemoryBarrier> _imageReleases;
+    std::vector<std::shared_ptr<void>> _resources;
+    UploadToken _token;
+    vk::PipelineStageFlags _releaseStage;
+    std::mutex _mutex;
+  };
+}
+
+#endif /* __LAVA_UPLOAD_ENGINE__ */
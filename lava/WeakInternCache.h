@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVA_WEAK_INTERN_CACHE__
+#define __LAVA_WEAK_INTERN_CACHE__
+
+#include <lava/noncopyable.hpp>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace lava
+{
+  /**
+  * Thread-safe map from Key to the live object built for it. Entries are
+  *   weak, so nothing is kept alive by the cache, and may list dependencies
+  *   (objects the key names by address): an entry goes stale when the
+  *   object or any dependency is destroyed. Stale entries are swept when
+  *   the map doubles. Backs the pipeline, layout and shader module caches.
+  */
+  template <typename Key, typename T, typename Hash = std::hash<Key>>
+  class WeakInternCache : private NonCopyable<WeakInternCache<Key, T, Hash>>
+  {
+  public:
+    typedef std::vector<std::weak_ptr<void>> Dependencies;
+
+    WeakInternCache( void )
+      : _sweepThreshold( 64 )
+      , _hits( 0 )
+      , _misses( 0 )
+    {
+    }
+
+    /**
+    * Returns the live object stored under key or calls create and stores
+    *   the result. create runs without the lock held; if another thread
+    *   stored the same key meanwhile, its object wins.
+    */
+    std::shared_ptr<T> getOrCreate( const Key& key,
+      const std::function<std::shared_ptr<T>( )>& create,
+      const Dependencies& dependencies = Dependencies( ) );
+
+    inline uint64_t hits( void ) const
+    {
+      return _hits.load( );
+    }
+    inline uint64_t misses( void ) const
+    {
+      return _misses.load( );
+    }
+    void resetCounters( void )
+    {
+      _hits = 0;
+      _misses = 0;
+    }
+    // Entries stored, including stale ones not swept yet
+    size_t size( void ) const
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      return _entries.size( );
+    }
+    void clear( void )
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _entries.clear( );
+      _sweepThreshold = 64;
+    }
+  protected:
+    struct Entry
+    {
+      std::weak_ptr<T> object;
+      Dependencies dependencies;
+    };
+    static bool isAlive( const Entry& entry );
+    void sweep( void );
+
+    std::unordered_map<Key, Entry, Hash> _entries;
+    size_t _sweepThreshold;
+    std::atomic<uint64_t> _hits;
+    std::atomic<uint64_t> _misses;
+    mutable std::mutex _mutex;
+  };
+
+  template <typename Key, typename T, typename Hash>
+  std::shared_ptr<T> WeakInternCache<Key, T, Hash>::getOrCreate(
+    const Key& key, const std::function<std::shared_ptr<T>( )>& create,
+    const Dependencies& dependencies )
+  {
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto it = _entries.find( key );
+      if ( it != _entries.end( ) && isAlive( it->second ) )
+      {
+        std::shared_ptr<T> object = it->second.object.lock( );
+        if ( object )
+        {
+          ++_hits;
+          return object;
+        }
+      }
+    }
+
+    ++_misses;
+    std::shared_ptr<T> object = create( );
+
+    std::shared_ptr<T> existing;
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      Entry& entry = _entries[ key ];
+      if ( isAlive( entry ) )
+      {
+        existing = entry.object.lock( );
+      }
+      if ( !existing )
+      {
+        entry.object = object;
+        entry.dependencies = dependencies;
+        if ( _entries.size( ) >= _sweepThreshold )
+        {
+          sweep( );
+        }
+      }
+    }
+    // The duplicate, if any, is destroyed outside the lock
+    return existing ? existing : object;
+  }
+
+  template <typename Key, typename T, typename Hash>
+  bool WeakInternCache<Key, T, Hash>::isAlive( const Entry& entry )
+  {
+    if ( entry.object.expired( ) )
+    {
+      return false;
+    }
+    // A destroyed object may have its address reused by a different one
+    for ( const auto& dependency : entry.dependencies )
+    {
+      if ( dependency.expired( ) )
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <typename Key, typename T, typename Hash>
+  void WeakInternCache<Key, T, Hash>::sweep( void )
+  {
+    for ( auto it = _entries.begin( ); it != _entries.end( ); )
+    {
+      if ( isAlive( it->second ) )
+      {
+        ++it;
+      }
+      else
+      {
+        it = _entries.erase( it );
+      }
+    }
+    _sweepThreshold = std::max< size_t >( 64, _entries.size( ) * 2 );
+  }
+}
+
+#endif /* __LAVA_WEAK_INTERN_CACHE__ */
@@ -19,8 +19,24 @@
 
 #include "utils.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <future>
 #include <sstream>
 #include <fstream>
+#include <thread>
+
+#ifdef _WIN32
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stbi/stb_image.h>
@@ -277,9 +293,8 @@ namespace lava
       static_cast< vk::Image >( *dstImage ), &isr, &subResourceLayout
     );
 
-    // Map image memory so we can start copying from it
-    const char* data = ( const char* ) dev.mapMemory( dstImage->imageMemory, 0, 
-      VK_WHOLE_SIZE, {} );
+    // Host visible image memory is already mapped by the allocator
+    const char* data = ( const char* ) dstImage->imageMemory.mapped;
     data += subResourceLayout.offset;
 
     std::ofstream file( filename, std::ios::out | std::ios::binary );
@@ -349,6 +364,124 @@ namespace lava
 
     return pixels;
   }
+
+  unsigned char* utils::loadImageTextures(
+    const std::vector<std::string>& fileNames, uint32_t& width,
+    uint32_t& height )
+  {
+    struct Layer
+    {
+      unsigned char* pixels;
+      uint32_t width;
+      uint32_t height;
+    };
+    std::vector<Layer> layers( fileNames.size( ), Layer{ nullptr, 0, 0 } );
+
+    auto release = [ &layers ] ( void )
+    {
+      for ( auto& layer : layers )
+      {
+        free( layer.pixels );
+      }
+    };
+
+    try
+    {
+      parallelFor( static_cast< uint32_t >( layers.size( ) ),
+        [ & ] ( uint32_t i )
+      {
+        uint32_t channels;
+        layers[ i ].pixels = loadImageTexture( fileNames[ i ],
+          layers[ i ].width, layers[ i ].height, channels );
+      } );
+    }
+    catch ( ... )
+    {
+      release( );
+      throw;
+    }
+
+    width = layers.empty( ) ? 0 : layers[ 0 ].width;
+    height = layers.empty( ) ? 0 : layers[ 0 ].height;
+    for ( const auto& layer : layers )
+    {
+      if ( layer.width != width || layer.height != height )
+      {
+        release( );
+        throw std::runtime_error( "texture layers have different sizes!" );
+      }
+    }
+
+    const size_t layerSize = size_t( width ) * height * 4;
+    unsigned char* pixels = ( unsigned char* ) malloc( layerSize * layers.size( ) );
+    for ( size_t i = 0; i < layers.size( ); ++i )
+    {
+      memcpy( pixels + i * layerSize, layers[ i ].pixels, layerSize );
+    }
+    release( );
+
+    return pixels;
+  }
+
+  void utils::parallelFor( uint32_t count,
+    const std::function<void( uint32_t )>& fn )
+  {
+    uint32_t threadCount = std::min( count,
+      std::max( std::thread::hardware_concurrency( ), 1u ) );
+    if ( threadCount <= 1 )
+    {
+      for ( uint32_t i = 0; i < count; ++i )
+      {
+        fn( i );
+      }
+      return;
+    }
+
+    // Threads pull indices until none are left
+    std::atomic<uint32_t> next( 0 );
+    auto worker = [ & ] ( void )
+    {
+      for ( uint32_t i = next++; i < count; i = next++ )
+      {
+        fn( i );
+      }
+    };
+
+    std::vector<std::future<void>> workers;
+    workers.reserve( threadCount - 1 );
+    for ( uint32_t t = 1; t < threadCount; ++t )
+    {
+      workers.push_back( std::async( std::launch::async, worker ) );
+    }
+
+    std::exception_ptr error;
+    try
+    {
+      worker( );
+    }
+    catch ( ... )
+    {
+      error = std::current_exception( );
+    }
+    for ( auto& w : workers )
+    {
+      try
+      {
+        w.get( );
+      }
+      catch ( ... )
+      {
+        if ( !error )
+        {
+          error = std::current_exception( );
+        }
+      }
+    }
+    if ( error )
+    {
+      std::rethrow_exception( error );
+    }
+  }
   
   std::vector<char> utils::readBinaryile( const std::string& fileName )
   {
@@ -369,6 +502,42 @@ namespace lava
 
     return buffer;
   }
+
+  bool utils::writeFileAtomic( const std::string& filePath,
+    const std::vector<std::pair<const void*, size_t>>& chunks )
+  {
+    // Threads writing the same file use different temporaries
+    std::stringstream tmpStream;
+    tmpStream << filePath << "." << std::hash<std::thread::id>( )(
+      std::this_thread::get_id( ) ) << ".tmp";
+    const std::string tmpPath = tmpStream.str( );
+
+    std::ofstream file( tmpPath, std::ios::binary | std::ios::trunc );
+    for ( auto const& chunk : chunks )
+    {
+      file.write( static_cast< const char* >( chunk.first ), chunk.second );
+    }
+    // Buffered data only reaches the file (or fails) on close
+    file.close( );
+    if ( file.fail( ) )
+    {
+      std::remove( tmpPath.c_str( ) );
+      return false;
+    }
+
+#ifdef _WIN32
+    // rename does not replace existing files on Windows
+    bool renamed = MoveFileExA( tmpPath.c_str( ), filePath.c_str( ),
+      MOVEFILE_REPLACE_EXISTING ) != 0;
+#else
+    bool renamed = std::rename( tmpPath.c_str( ), filePath.c_str( ) ) == 0;
+#endif
+    if ( !renamed )
+    {
+      std::remove( tmpPath.c_str( ) );
+    }
+    return renamed;
+  }
 	
   const std::string utils::translateVulkanResult( vk::Result res )
 	{
@@ -603,4 +772,137 @@ namespace lava
       imageMemoryBarrier
     );
   }
+  uint32_t utils::mipLevelCount( uint32_t width, uint32_t height,
+    uint32_t depth )
+  {
+    uint32_t size = std::max( std::max( width, height ), depth );
+    uint32_t levels = 1;
+    while ( size > 1 )
+    {
+      size >>= 1;
+      ++levels;
+    }
+    return levels;
+  }
+
+  bool utils::supportsLinearBlit(
+    const std::shared_ptr<PhysicalDevice>& physicalDevice, vk::Format format )
+  {
+    const vk::FormatFeatureFlags required = 
+      vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst |
+      vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+    return ( physicalDevice->getFormatProperties( format )
+      .optimalTilingFeatures & required ) == required;
+  }
+
+  void utils::generateMipmaps( const std::shared_ptr<CommandBuffer>& cmd,
+    const std::shared_ptr<Image>& image, const vk::Extent3D& extent,
+    uint32_t mipLevels, uint32_t layerCount, vk::ImageLayout finalLayout,
+    vk::PipelineStageFlags dstStage )
+  {
+    int32_t w = static_cast< int32_t >( extent.width );
+    int32_t h = static_cast< int32_t >( extent.height );
+    int32_t d = static_cast< int32_t >( extent.depth );
+
+    for ( uint32_t level = 1; level < mipLevels; ++level )
+    {
+      vk::ImageSubresourceRange src( vk::ImageAspectFlagBits::eColor,
+        level - 1, 1, 0, layerCount );
+
+      // Wait for the copy (or previous blit) into the source level
+      cmd->pipelineBarrier( vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eTransfer, { }, { }, { },
+        ImageMemoryBarrier( vk::AccessFlagBits::eTransferWrite,
+          vk::AccessFlagBits::eTransferRead, vk::ImageLayout::eTransferDstOptimal,
+          vk::ImageLayout::eTransferSrcOptimal, VK_QUEUE_FAMILY_IGNORED,
+          VK_QUEUE_FAMILY_IGNORED, image, src ) );
+
+      int32_t nw = std::max( w / 2, 1 );
+      int32_t nh = std::max( h / 2, 1 );
+      int32_t nd = std::max( d / 2, 1 );
+
+      vk::ImageBlit blit;
+      blit.srcSubresource = vk::ImageSubresourceLayers(
+        vk::ImageAspectFlagBits::eColor, level - 1, 0, layerCount );
+      blit.srcOffsets[ 1 ] = vk::Offset3D( w, h, d );
+      blit.dstSubresource = vk::ImageSubresourceLayers(
+        vk::ImageAspectFlagBits::eColor, level, 0, layerCount );
+      blit.dstOffsets[ 1 ] = vk::Offset3D( nw, nh, nd );
+      cmd->blitImage( image, vk::ImageLayout::eTransferSrcOptimal, image,
+        vk::ImageLayout::eTransferDstOptimal, blit, vk::Filter::eLinear );
+
+      // The source level is done
+      cmd->pipelineBarrier( vk::PipelineStageFlagBits::eTransfer, dstStage,
+        { }, { }, { },
+        ImageMemoryBarrier( vk::AccessFlagBits::eTransferRead,
+          vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eTransferSrcOptimal,
+          finalLayout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+          image, src ) );
+
+      w = nw;
+      h = nh;
+      d = nd;
+    }
+
+    // Last level was only written
+    cmd->pipelineBarrier( vk::PipelineStageFlagBits::eTransfer, dstStage,
+      { }, { }, { },
+      ImageMemoryBarrier( vk::AccessFlagBits::eTransferWrite,
+        vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eTransferDstOptimal,
+        finalLayout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image,
+        vk::ImageSubresourceRange( vk::ImageAspectFlagBits::eColor,
+          mipLevels - 1, 1, 0, layerCount ) ) );
+  }
+
+  std::vector<unsigned char> utils::buildMipChainRGBA8(
+    const unsigned char* pixels, uint32_t width, uint32_t height,
+    uint32_t mipLevels )
+  {
+    vk::DeviceSize total = 0;
+    for ( uint32_t level = 0; level < mipLevels; ++level )
+    {
+      total += vk::DeviceSize( std::max( width >> level, 1u ) ) *
+        std::max( height >> level, 1u ) * 4;
+    }
+
+    std::vector<unsigned char> chain( static_cast< size_t >( total ) );
+    memcpy( chain.data( ), pixels, size_t( width ) * height * 4 );
+
+    size_t srcOffset = 0;
+    size_t dstOffset = size_t( width ) * height * 4;
+    uint32_t sw = width;
+    uint32_t sh = height;
+    for ( uint32_t level = 1; level < mipLevels; ++level )
+    {
+      uint32_t dw = std::max( sw / 2, 1u );
+      uint32_t dh = std::max( sh / 2, 1u );
+      const unsigned char* src = chain.data( ) + srcOffset;
+      unsigned char* dst = chain.data( ) + dstOffset;
+      for ( uint32_t y = 0; y < dh; ++y )
+      {
+        // Odd sizes repeat the last row / column
+        uint32_t y0 = std::min( y * 2, sh - 1 );
+        uint32_t y1 = std::min( y * 2 + 1, sh - 1 );
+        for ( uint32_t x = 0; x < dw; ++x )
+        {
+          uint32_t x0 = std::min( x * 2, sw - 1 );
+          uint32_t x1 = std::min( x * 2 + 1, sw - 1 );
+          for ( uint32_t c = 0; c < 4; ++c )
+          {
+            uint32_t sum = src[ ( y0 * sw + x0 ) * 4 + c ] +
+              src[ ( y0 * sw + x1 ) * 4 + c ] +
+              src[ ( y1 * sw + x0 ) * 4 + c ] +
+              src[ ( y1 * sw + x1 ) * 4 + c ];
+            dst[ ( y * dw + x ) * 4 + c ] =
+              static_cast< unsigned char >( ( sum + 2 ) / 4 );
+          }
+        }
+      }
+      srcOffset = dstOffset;
+      dstOffset += size_t( dw ) * dh * 4;
+      sw = dw;
+      sh = dh;
+    }
+    return chain;
+  }
 }
\ No newline at end of file
@@ -28,7 +28,9 @@
 #include "Queue.h"
 
 #include <lava/Image.h>
+#include <functional>
 #include <mutex>
+#include <utility>
 
 namespace lava
 {
@@ -113,7 +115,31 @@ namespace lava
 
     static unsigned char* loadImageTexture( const std::string& fileName,
       uint32_t& width, uint32_t& height, uint32_t& numChannels );
+    /**
+    * Loads every file as RGBA8, in parallel, and packs the layers one after
+    *   another in a single buffer (release it with free). All files must
+    *   have the same width x height.
+    */
+    LAVA_API
+    static unsigned char* loadImageTextures(
+      const std::vector<std::string>& fileNames, uint32_t& width,
+      uint32_t& height );
+    /**
+    * Runs fn( 0 ) .. fn( count - 1 ) on up to hardware_concurrency threads
+    *   and returns when all are done. Rethrows the first exception thrown.
+    */
+    LAVA_API
+    static void parallelFor( uint32_t count,
+      const std::function<void( uint32_t )>& fn );
     static std::vector<char> readBinaryile( const std::string& fileName );
+    /**
+    * Writes the chunks one after another to a temporary file next to
+    *   filePath and renames it over filePath, so readers never see a
+    *   partial file. Returns false, leaving filePath untouched, on error.
+    */
+    LAVA_API
+    static bool writeFileAtomic( const std::string& filePath,
+      const std::vector<std::pair<const void*, size_t>>& chunks );
 		static const std::string translateVulkanResult( vk::Result res );
 
     // Put an image memory barrier for setting an image layout on the 
@@ -151,6 +177,35 @@ namespace lava
       vk::PipelineStageFlags srcStageMask, vk::PipelineStageFlags dstStageMask,
       vk::ImageSubresourceRange subresourceRange
      );
+
+    // Levels of a full mip chain down to 1x1x1
+    LAVA_API
+    static uint32_t mipLevelCount( uint32_t width, uint32_t height,
+      uint32_t depth = 1 );
+    // True if optimal images of format can be downsampled with linear blits
+    LAVA_API
+    static bool supportsLinearBlit(
+      const std::shared_ptr<PhysicalDevice>& physicalDevice, vk::Format format );
+    /**
+    * Records the mip chain of every layer as a sequence of linear blits,
+    *   each level from the previous one. All levels must be in
+    *   eTransferDstOptimal with level 0 written; they end in finalLayout,
+    *   visible to dstStage. cmd must belong to a graphics queue.
+    */
+    LAVA_API
+    static void generateMipmaps( const std::shared_ptr<CommandBuffer>& cmd,
+      const std::shared_ptr<Image>& image, const vk::Extent3D& extent,
+      uint32_t mipLevels, uint32_t layerCount, vk::ImageLayout finalLayout,
+      vk::PipelineStageFlags dstStage = 
+        vk::PipelineStageFlagBits::eFragmentShader );
+    /**
+    * CPU fallback for generateMipmaps: box filters RGBA8 pixels into
+    *   mipLevels levels, packed one after another starting with level 0.
+    */
+    LAVA_API
+    static std::vector<unsigned char> buildMipChainRGBA8(
+      const unsigned char* pixels, uint32_t width, uint32_t height,
+      uint32_t mipLevels );
 	};
 }
 
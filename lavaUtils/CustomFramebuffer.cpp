@@ -29,7 +29,7 @@ namespace lava
       , _width( w )
       , _height( h )
     {
-      semaphore = _device->createSemaphore( );
+      semaphore = _device->acquireSemaphore( );
     }
     CustomFramebuffer::~CustomFramebuffer( void )
     {
@@ -18,41 +18,76 @@
  **/
 
 #include "Geometry.h"
+#include "MeshCache.h"
 #include "ModelImporter.h"
 
 namespace lava
 {
   namespace utility
   {
+    namespace
+    {
+      // First mesh of a model, read from the mapped MeshCache when possible
+      struct MeshData
+      {
+        std::shared_ptr<MeshCache> cache;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        const Vertex* vertexData;
+        const uint32_t* indexData;
+        uint32_t numVertices;
+        uint32_t numIndices;
+      };
+
+      MeshData loadFirstMesh( const std::string& path )
+      {
+        MeshData data;
+        data.cache = MeshCache::open( path );
+        if ( data.cache && data.cache->header( ).submeshCount > 0 )
+        {
+          const MeshCache::Submesh& submesh = data.cache->submesh( 0 );
+          data.vertexData = static_cast< const Vertex* >(
+            data.cache->vertices( ) ) + submesh.firstVertex;
+          data.indexData = data.cache->indices( ) + submesh.firstIndex;
+          data.numVertices = submesh.vertexCount;
+          data.numIndices = submesh.indexCount;
+          return data;
+        }
+
+        // Imports once: the cache is written for the next run and this one
+        //    keeps the imported copy
+        lava::utility::ModelImporter mi( path );
+        lava::utility::Mesh& mesh = mi._meshes[ 0 ];
+        data.vertices.swap( mesh.vertices );
+        data.indices.swap( mesh.indices );
+        data.vertexData = data.vertices.data( );
+        data.indexData = data.indices.data( );
+        data.numVertices = mesh.numVertices;
+        data.numIndices = mesh.numIndices;
+        return data;
+      }
+    }
+
     Geometry::Geometry( const std::shared_ptr<Device>& device, 
       const std::string& path )
       : VulkanResource( device )
     {
-      lava::utility::ModelImporter mi( path );
-      lava::utility::Mesh mesh = mi._meshes[ 0 ];
+      MeshData mesh = loadFirstMesh( path );
 
       _numIndices = mesh.numIndices;
 
-      /*for ( const auto& v: mesh.vertices )
-      {
-        std::cout << "POSITION: " << v.position.x << ", " << v.position.y << "," << v.position.z << std::endl;
-        std::cout << "NORMAL: " << v.normal.x << ", " << v.normal.y << "," << v.normal.z << std::endl;
-        std::cout << "TEXCOORD: " << v.texCoord.x << ", " << v.texCoord.y << std::endl;
-        std::cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~ " << std::endl;
-      }*/
-
       // Vertex buffer
       {
         uint32_t vertexBufferSize = mesh.numVertices * sizeof( Vertex );
         _vbo = _device->createVertexBuffer( vertexBufferSize );
-        _vbo->writeData( 0, vertexBufferSize, mesh.vertices.data( ) );
+        _vbo->writeData( 0, vertexBufferSize, mesh.vertexData );
       }
 
       // Index buffer
       {
         uint32_t indexBufferSize = _numIndices * sizeof( uint32_t );
         _ibo = device->createIndexBuffer( vk::IndexType::eUint32, _numIndices );
-        _ibo->writeData( 0, indexBufferSize, mesh.indices.data( ) );
+        _ibo->writeData( 0, indexBufferSize, mesh.indexData );
       }
     }
     Geometry::Geometry( const std::shared_ptr<Device>& device, 
@@ -60,8 +95,8 @@ namespace lava
       const std::shared_ptr<Queue> queue, const std::string & path )
       : VulkanResource( device )
     {
-      lava::utility::ModelImporter mi( path );
-      lava::utility::Mesh mesh = mi._meshes[ 0 ];
+      // With a cache, vertices go from the mapped file to the staging ring
+      MeshData mesh = loadFirstMesh( path );
 
       _numIndices = mesh.numIndices;
       
@@ -75,8 +110,7 @@ namespace lava
           vk::BufferUsageFlagBits::eVertexBuffer |
           vk::BufferUsageFlagBits::eTransferDst,
           vk::MemoryPropertyFlagBits::eDeviceLocal );
-        _vbo->update<Vertex>( cmd, 0, { uint32_t( mesh.vertices.size( ) ),
-          mesh.vertices.data( ) } );
+        _vbo->update<Vertex>( cmd, 0, { mesh.numVertices, mesh.vertexData } );
       }
       // Index buffer
       {
@@ -86,8 +120,7 @@ namespace lava
           vk::BufferUsageFlagBits::eIndexBuffer |
           vk::BufferUsageFlagBits::eTransferDst,
           vk::MemoryPropertyFlagBits::eDeviceLocal );
-        _ibo->update<uint32_t>( cmd, 0, { uint32_t( mesh.indices.size( ) ),
-          mesh.indices.data( ) } );
+        _ibo->update<uint32_t>( cmd, 0, { mesh.numIndices, mesh.indexData } );
       }
       cmd->end( );
       queue->submitAndWait( cmd );
@@ -19,14 +19,24 @@
 
 #include "Glsl2SPV.h"
 
+#include <cstring>
+#include <iostream>
+#include <map>
+
 namespace lava
 {
   namespace utility
   {
+    // Bump when compile options change, so cached SPIR-V is not reused
+    static const uint32_t COMPILER_REVISION = 1;
+
     GLSLToSPIRVCompiler::GLSLToSPIRVCompiler( void )
     {
       glslang::InitializeProcess( );
 
+      // Padding too, the struct is hashed into the cache key
+      memset( &_resource, 0, sizeof( _resource ) );
+
       _resource.maxLights = 32;
       _resource.maxClipPlanes = 6;
       _resource.maxTextureUnits = 32;
@@ -119,6 +129,12 @@ namespace lava
       _resource.limits.generalSamplerIndexing = 1;
       _resource.limits.generalVariableIndexing = 1;
       _resource.limits.generalConstantMatrixVectorIndexing = 1;
+
+      _versionKey = ShaderCache::hash( glslang::GetGlslVersionString( ) );
+      _versionKey = ShaderCache::hash( &COMPILER_REVISION,
+        sizeof( COMPILER_REVISION ), _versionKey );
+      _versionKey = ShaderCache::hash( &_resource, sizeof( _resource ),
+        _versionKey );
     }
     
     GLSLToSPIRVCompiler::~GLSLToSPIRVCompiler( void )
@@ -126,8 +142,50 @@ namespace lava
       glslang::FinalizeProcess( );
     }
 
+    std::vector<uint32_t> GLSLToSPIRVCompiler::compile( ShaderCache& cache,
+      vk::ShaderStageFlagBits stage, const std::string& source,
+      const std::vector<std::string>& defines ) const
+    {
+      uint64_t key = cacheKey( stage, source, defines );
+      ShaderCache::Code cached = cache.findCompiled( key );
+      if ( cached )
+      {
+        return *cached;
+      }
+      std::vector<uint32_t> code = compile( stage, source, defines );
+      cache.storeCompiled( key, code );
+      return code;
+    }
+
+    uint64_t GLSLToSPIRVCompiler::cacheKey( vk::ShaderStageFlagBits stage,
+      const std::string& source, const std::vector<std::string>& defines ) const
+    {
+      uint64_t key = ShaderCache::hash( &stage, sizeof( stage ), _versionKey );
+      for ( auto const& define : defines )
+      {
+        // Separators keep { "AB" } and { "A", "B" } apart
+        key = ShaderCache::hash( define.c_str( ), define.size( ) + 1, key );
+      }
+      return ShaderCache::hash( source, key );
+    }
+
     std::vector<uint32_t> GLSLToSPIRVCompiler::compile( 
-      vk::ShaderStageFlagBits stage, const std::string& source ) const
+      vk::ShaderStageFlagBits stage, const std::string& source,
+      const std::vector<std::string>& defines ) const
+    {
+      std::vector<uint32_t> code;
+      std::string diagnostics;
+      if ( !compile( stage, source, defines, code, diagnostics ) )
+      {
+        std::cerr << diagnostics << std::endl;
+        assert( false );
+      }
+      return code;
+    }
+
+    bool GLSLToSPIRVCompiler::compile( vk::ShaderStageFlagBits stage,
+      const std::string& source, const std::vector<std::string>& defines,
+      std::vector<uint32_t>& code, std::string& diagnostics ) const
     {
       static const std::map<vk::ShaderStageFlagBits, EShLanguage> stageToLanguageMap
       {
@@ -147,14 +205,23 @@ namespace lava
       shaderStrings[ 0 ] = source.c_str( );
       shader.setStrings( shaderStrings, 1 );
 
+      std::string preamble;
+      for ( auto const& define : defines )
+      {
+        std::string::size_type eq = define.find( '=' );
+        preamble += "#define " + ( eq == std::string::npos ? define :
+          define.substr( 0, eq ) + " " + define.substr( eq + 1 ) ) + "\n";
+      }
+      shader.setPreamble( preamble.c_str( ) );
+
       // Enable SPIR-V and Vulkan rules when parsing GLSL
       EShMessages messages = ( EShMessages ) ( EShMsgSpvRules | EShMsgVulkanRules );
 
       if ( !shader.parse( &_resource, 100, false, messages ) )
       {
-        std::string infoLog = shader.getInfoLog( );
-        std::string infoDebugLog = shader.getInfoDebugLog( );
-        assert( false );
+        diagnostics = std::string( shader.getInfoLog( ) ) +
+          shader.getInfoDebugLog( );
+        return false;
       }
 
       glslang::TProgram program;
@@ -162,23 +229,74 @@ namespace lava
 
       if ( !program.link( messages ) )
       {
-        std::string infoLog = program.getInfoLog( );
-        std::string infoDebugLog = program.getInfoDebugLog( );
-        assert( false );
+        diagnostics = std::string( program.getInfoLog( ) ) +
+          program.getInfoDebugLog( );
+        return false;
       }
 
-      std::vector<uint32_t> code;
+      // Warnings of a successful compile
+      diagnostics = shader.getInfoLog( );
+      code.clear( );
       glslang::GlslangToSpv( *program.getIntermediate( stageIt->second ), code );
 
-      return code;
+      return true;
+    }
+
+    std::vector<GLSLToSPIRVCompiler::Result> GLSLToSPIRVCompiler::compileBatch(
+      const std::vector<Source>& sources, JobSystem& jobSystem,
+      ShaderCache* cache ) const
+    {
+      std::vector<Result> results( sources.size( ) );
+
+      // Every job owns its TShader and TProgram; glslang keeps its pool
+      //    allocator per thread, so only the resource limits are shared
+      JobCounter counter;
+      jobSystem.parallelFor( sources.size( ), 1, [ this, &sources, &results,
+        cache ]( size_t i )
+      {
+        const Source& src = sources[ i ];
+        Result& result = results[ i ];
+        uint64_t key = 0;
+        if ( cache )
+        {
+          key = cacheKey( src.stage, src.source, src.defines );
+          ShaderCache::Code cached = cache->findCompiled( key );
+          if ( cached )
+          {
+            result.code = *cached;
+            result.success = true;
+            return;
+          }
+        }
+        result.success = compile( src.stage, src.source, src.defines,
+          result.code, result.diagnostics );
+        if ( cache && result.success )
+        {
+          cache->storeCompiled( key, result.code );
+        }
+      }, counter );
+      jobSystem.wait( counter );
+
+      return results;
+    }
+
+    static const GLSLToSPIRVCompiler& sharedCompiler( void )
+    {
+      static GLSLToSPIRVCompiler compiler;
+      return compiler;
     }
 
     std::vector<uint32_t> compileGLSLToSPIRV( vk::ShaderStageFlagBits stage, 
-      const std::string & source )
+      const std::string & source, const std::vector<std::string>& defines )
+    {
+      return sharedCompiler( ).compile( stage, source, defines );
+    }
+
+    std::vector<GLSLToSPIRVCompiler::Result> compileGLSLToSPIRV(
+      const std::vector<GLSLToSPIRVCompiler::Source>& sources,
+      JobSystem& jobSystem, ShaderCache* cache )
     {
-      //static GLSLToSPIRVCompiler compiler;
-      //return compiler.compile( stage, source );
-      return std::vector<uint32_t>( );
+      return sharedCompiler( ).compileBatch( sources, jobSystem, cache );
     }
   }
 }
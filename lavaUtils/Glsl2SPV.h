@@ -21,29 +21,99 @@
 #define __LAVA_UTILS_GLSL2SPV__
 
 #include <lava/lava.h>
+#include <lava/ShaderCache.h>
 #include <lavaUtils/api.h>
+#include <lavaUtils/JobSystem.h>
+#include <string>
 #include <vector>
 
+#include <glslang/Public/ShaderLang.h>
 #include <glslang/SPIRV/GlslangToSpv.h>
 
 namespace lava
 {
 	namespace utility
 	{
+    // Runtime GLSL compiler, only built when glslang is found
     class GLSLToSPIRVCompiler
     {
     public:
+      struct Source
+      {
+        Source( vk::ShaderStageFlagBits stage_, const std::string& source_,
+          const std::vector<std::string>& defines_ = { } )
+          : stage( stage_ )
+          , source( source_ )
+          , defines( defines_ )
+        {
+        }
+
+        vk::ShaderStageFlagBits stage;
+        std::string source;
+        std::vector<std::string> defines;
+      };
+      struct Result
+      {
+        std::vector<uint32_t> code;
+        // Errors on failure, warnings otherwise
+        std::string diagnostics;
+        bool success = false;
+      };
+
+      LAVAUTILS_API
       GLSLToSPIRVCompiler( void );
+      LAVAUTILS_API
       ~GLSLToSPIRVCompiler( void );
 
+      // defines: "NAME" or "NAME=VALUE", added before the source
+      LAVAUTILS_API
       std::vector<uint32_t> compile( vk::ShaderStageFlagBits stage,
-        const std::string& source ) const;
+        const std::string& source,
+        const std::vector<std::string>& defines = { } ) const;
+      /**
+      * Same as compile, but looks up the SPIR-V in cache first (memory and
+      *   disk) and stores it after compiling. The key covers source, stage,
+      *   defines, glslang version and resource limits.
+      */
+      LAVAUTILS_API
+      std::vector<uint32_t> compile( ShaderCache& cache,
+        vk::ShaderStageFlagBits stage, const std::string& source,
+        const std::vector<std::string>& defines = { } ) const;
+
+      // Returns false and the error log in diagnostics on failure
+      LAVAUTILS_API
+      bool compile( vk::ShaderStageFlagBits stage, const std::string& source,
+        const std::vector<std::string>& defines, std::vector<uint32_t>& code,
+        std::string& diagnostics ) const;
+      /**
+      * Compiles every source concurrently on jobSystem, one job per shader.
+      *   Results keep the order of sources; failures do not stop the batch.
+      *   With a cache, hits skip glslang and new SPIR-V is stored.
+      */
+      LAVAUTILS_API
+      std::vector<Result> compileBatch( const std::vector<Source>& sources,
+        JobSystem& jobSystem = JobSystem::global( ),
+        ShaderCache* cache = nullptr ) const;
+
+      LAVAUTILS_API
+      uint64_t cacheKey( vk::ShaderStageFlagBits stage,
+        const std::string& source, const std::vector<std::string>& defines ) const;
 
     private:
       TBuiltInResource  _resource;
+      // Hash of everything in the compiler that changes its output
+      uint64_t _versionKey;
     };
+    // Both use one compiler shared by the whole process
+    LAVAUTILS_API
   	std::vector< uint32_t > compileGLSLToSPIRV( 
-  		vk::ShaderStageFlagBits stage, const std::string& source );
+  		vk::ShaderStageFlagBits stage, const std::string& source,
+      const std::vector<std::string>& defines = { } );
+    LAVAUTILS_API
+    std::vector<GLSLToSPIRVCompiler::Result> compileGLSLToSPIRV(
+      const std::vector<GLSLToSPIRVCompiler::Source>& sources,
+      JobSystem& jobSystem = JobSystem::global( ),
+      ShaderCache* cache = nullptr );
 	}
 }
 
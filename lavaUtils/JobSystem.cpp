@@ -0,0 +1,370 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "JobSystem.h"
+
+#include <chrono>
+
+#ifdef _WIN32
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+#elif defined( __linux__ )
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+namespace lava
+{
+  namespace utility
+  {
+    namespace
+    {
+      struct ThreadContext
+      {
+        const JobSystem* system;
+        uint32_t index;
+      };
+      thread_local ThreadContext tlsContext = { nullptr, 0 };
+
+      const uint32_t SPIN_COUNT = 64;
+
+      void pinThread( std::thread& thread, uint32_t core )
+      {
+#ifdef _WIN32
+        SetThreadAffinityMask( thread.native_handle( ),
+          DWORD_PTR( 1 ) << ( core % ( sizeof( DWORD_PTR ) * 8 ) ) );
+#elif defined( __linux__ )
+        cpu_set_t cpus;
+        CPU_ZERO( &cpus );
+        CPU_SET( core % CPU_SETSIZE, &cpus );
+        pthread_setaffinity_np( thread.native_handle( ), sizeof( cpus ), &cpus );
+#else
+        // Affinity is only a hint, ignore it where it is not supported
+        ( void ) thread;
+        ( void ) core;
+#endif
+      }
+    }
+
+    /**
+    * Chase-Lev deque with a fixed capacity. Only the owner pushes and pops
+    *   (bottom), any thread can steal (top). A worker never has more than
+    *   JOB_CAPACITY jobs alive, so the buffer never grows.
+    */
+    class WorkStealingQueue
+    {
+    public:
+      WorkStealingQueue( uint32_t capacity )
+        : _top( 0 )
+        , _bottom( 0 )
+        , _mask( capacity - 1 )
+        , _buffer( new std::atomic<void*>[ capacity ] )
+      {
+        for ( uint32_t i = 0; i < capacity; ++i )
+        {
+          _buffer[ i ].store( nullptr, std::memory_order_relaxed );
+        }
+      }
+
+      void push( void* item )
+      {
+        int64_t b = _bottom.load( std::memory_order_relaxed );
+        _buffer[ b & _mask ].store( item, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+        _bottom.store( b + 1, std::memory_order_relaxed );
+      }
+
+      void* pop( void )
+      {
+        int64_t b = _bottom.load( std::memory_order_relaxed ) - 1;
+        _bottom.store( b, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        int64_t t = _top.load( std::memory_order_relaxed );
+
+        if ( t > b )
+        {
+          // Empty
+          _bottom.store( b + 1, std::memory_order_relaxed );
+          return nullptr;
+        }
+        void* item = _buffer[ b & _mask ].load( std::memory_order_relaxed );
+        if ( t == b )
+        {
+          // Last item, race against the thieves for it
+          if ( !_top.compare_exchange_strong( t, t + 1,
+            std::memory_order_seq_cst, std::memory_order_relaxed ) )
+          {
+            item = nullptr;
+          }
+          _bottom.store( b + 1, std::memory_order_relaxed );
+        }
+        return item;
+      }
+
+      void* steal( void )
+      {
+        int64_t t = _top.load( std::memory_order_acquire );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        int64_t b = _bottom.load( std::memory_order_acquire );
+
+        if ( t >= b )
+        {
+          return nullptr;
+        }
+        void* item = _buffer[ t & _mask ].load( std::memory_order_relaxed );
+        if ( !_top.compare_exchange_strong( t, t + 1,
+          std::memory_order_seq_cst, std::memory_order_relaxed ) )
+        {
+          return nullptr;
+        }
+        return item;
+      }
+    private:
+      std::atomic<int64_t> _top;
+      std::atomic<int64_t> _bottom;
+      const int64_t _mask;
+      std::unique_ptr<std::atomic<void*>[ ]> _buffer;
+    };
+
+    struct JobSystem::Worker
+    {
+      Worker( void )
+        : jobs( new Job[ JOB_CAPACITY ] )
+        , allocated( 0 )
+        , queue( JOB_CAPACITY )
+      {
+      }
+
+      std::unique_ptr<Job[ ]> jobs;
+      // Only touched by the owner thread
+      uint32_t allocated;
+      WorkStealingQueue queue;
+      std::thread thread;
+    };
+
+    static_assert( ( JobSystem::JOB_CAPACITY &
+      ( JobSystem::JOB_CAPACITY - 1 ) ) == 0,
+      "JOB_CAPACITY must be a power of two" );
+
+    JobSystem::JobSystem( uint32_t workerCount, bool pinWorkers )
+      : _externalJobs( new Job[ JOB_CAPACITY ] )
+      , _externalAllocated( 0 )
+      , _queued( 0 )
+      , _stop( false )
+    {
+      uint32_t hardwareThreads = std::max( std::thread::hardware_concurrency( ), 1u );
+      if ( workerCount == 0 )
+      {
+        workerCount = std::max( hardwareThreads - 1, 1u );
+      }
+
+      // Create every worker before starting them, thieves walk the whole list
+      for ( uint32_t i = 0; i < workerCount; ++i )
+      {
+        _workers.push_back( std::unique_ptr<Worker>( new Worker( ) ) );
+      }
+      for ( uint32_t i = 0; i < workerCount; ++i )
+      {
+        _workers[ i ]->thread = std::thread( &JobSystem::workerLoop, this, i );
+        if ( pinWorkers )
+        {
+          // Leave the first core to the thread that owns the system
+          pinThread( _workers[ i ]->thread, ( i + 1 ) % hardwareThreads );
+        }
+      }
+    }
+
+    JobSystem::~JobSystem( void )
+    {
+      // Workers drain the remaining jobs before exiting
+      _stop.store( true );
+      _sleepCondition.notify_all( );
+      for ( auto& worker : _workers )
+      {
+        if ( worker->thread.joinable( ) )
+        {
+          worker->thread.join( );
+        }
+      }
+    }
+
+    JobSystem& JobSystem::global( void )
+    {
+      static JobSystem instance;
+      return instance;
+    }
+
+    uint32_t JobSystem::currentThreadIndex( void ) const
+    {
+      if ( tlsContext.system == this )
+      {
+        return tlsContext.index;
+      }
+      return workerCount( );
+    }
+
+    JobSystem::Job* JobSystem::allocateJob( void )
+    {
+      uint32_t index = currentThreadIndex( );
+      Job* job;
+      if ( index < workerCount( ) )
+      {
+        Worker& worker = *_workers[ index ];
+        job = &worker.jobs[ worker.allocated++ & ( JOB_CAPACITY - 1 ) ];
+      }
+      else
+      {
+        std::lock_guard<std::mutex> lock( _externalMutex );
+        job = &_externalJobs[ _externalAllocated++ & ( JOB_CAPACITY - 1 ) ];
+        if ( job->busy.load( std::memory_order_acquire ) )
+        {
+          return nullptr;
+        }
+        job->busy.store( true, std::memory_order_relaxed );
+        return job;
+      }
+      if ( job->busy.load( std::memory_order_acquire ) )
+      {
+        // Ring full of jobs in flight
+        return nullptr;
+      }
+      job->busy.store( true, std::memory_order_relaxed );
+      return job;
+    }
+
+    void JobSystem::submit( Job* job )
+    {
+      uint32_t index = currentThreadIndex( );
+      if ( index < workerCount( ) )
+      {
+        _workers[ index ]->queue.push( job );
+      }
+      else
+      {
+        std::lock_guard<std::mutex> lock( _externalMutex );
+        _externalQueue.push_back( job );
+      }
+      _queued.fetch_add( 1, std::memory_order_release );
+      _sleepCondition.notify_one( );
+    }
+
+    JobSystem::Job* JobSystem::findJob( uint32_t threadIndex )
+    {
+      uint32_t count = workerCount( );
+      Job* job = nullptr;
+
+      if ( threadIndex < count )
+      {
+        job = static_cast< Job* >( _workers[ threadIndex ]->queue.pop( ) );
+      }
+      if ( !job )
+      {
+        std::lock_guard<std::mutex> lock( _externalMutex );
+        if ( !_externalQueue.empty( ) )
+        {
+          job = _externalQueue.front( );
+          _externalQueue.pop_front( );
+        }
+      }
+      for ( uint32_t i = 1; !job && i <= count; ++i )
+      {
+        uint32_t victim = ( threadIndex + i ) % count;
+        if ( victim != threadIndex )
+        {
+          job = static_cast< Job* >( _workers[ victim ]->queue.steal( ) );
+        }
+      }
+      if ( job )
+      {
+        _queued.fetch_sub( 1, std::memory_order_relaxed );
+      }
+      return job;
+    }
+
+    void JobSystem::execute( Job* job )
+    {
+      JobCounter* counter = job->counter;
+      job->task( );
+      job->task.reset( );
+      job->counter = nullptr;
+      job->busy.store( false, std::memory_order_release );
+      if ( counter )
+      {
+        counter->_pending.fetch_sub( 1, std::memory_order_acq_rel );
+      }
+    }
+
+    void JobSystem::wait( JobCounter& counter )
+    {
+      uint32_t index = currentThreadIndex( );
+      while ( !counter.isDone( ) )
+      {
+        Job* job = findJob( index );
+        if ( job )
+        {
+          execute( job );
+        }
+        else
+        {
+          std::this_thread::yield( );
+        }
+      }
+    }
+
+    void JobSystem::workerLoop( uint32_t index )
+    {
+      tlsContext.system = this;
+      tlsContext.index = index;
+
+      uint32_t idle = 0;
+      while ( true )
+      {
+        Job* job = findJob( index );
+        if ( job )
+        {
+          execute( job );
+          idle = 0;
+          continue;
+        }
+        if ( _stop.load( ) )
+        {
+          break;
+        }
+        if ( ++idle < SPIN_COUNT )
+        {
+          std::this_thread::yield( );
+          continue;
+        }
+        // The timeout covers a notify sent between the check and the wait
+        std::unique_lock<std::mutex> lock( _sleepMutex );
+        _sleepCondition.wait_for( lock, std::chrono::milliseconds( 1 ), [ this ]( )
+        {
+          return _stop.load( ) || _queued.load( std::memory_order_acquire ) > 0;
+        } );
+      }
+
+      tlsContext.system = nullptr;
+    }
+  }
+}
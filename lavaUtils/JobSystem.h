@@ -0,0 +1,255 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVAUTILS_JOBSYSTEM__
+#define __LAVAUTILS_JOBSYSTEM__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <lavaUtils/api.h>
+
+namespace lava
+{
+  namespace utility
+  {
+    /**
+    * Type-erased callable with inline storage. Functors up to INLINE_SIZE
+    *   bytes are stored in place; bigger ones fall back to the heap.
+    */
+    class Task
+    {
+    public:
+      static const size_t INLINE_SIZE = 48;
+
+      Task( void )
+        : _invoke( nullptr )
+        , _destroy( nullptr )
+      {
+      }
+      ~Task( void )
+      {
+        reset( );
+      }
+      Task( const Task& ) = delete;
+      Task& operator=( const Task& ) = delete;
+
+      template <typename F>
+      void set( F&& f )
+      {
+        typedef typename std::decay<F>::type Functor;
+        reset( );
+        setImpl<Functor>( std::forward<F>( f ),
+          std::integral_constant<bool, sizeof( Functor ) <= INLINE_SIZE &&
+            std::alignment_of<Functor>::value <=
+            std::alignment_of<Storage>::value>( ) );
+      }
+      void operator()( void )
+      {
+        _invoke( &_storage );
+      }
+      void reset( void )
+      {
+        if ( _destroy )
+        {
+          _destroy( &_storage );
+        }
+        _invoke = nullptr;
+        _destroy = nullptr;
+      }
+      explicit operator bool( void ) const
+      {
+        return _invoke != nullptr;
+      }
+    private:
+      template <typename Functor, typename F>
+      void setImpl( F&& f, std::true_type )
+      {
+        new ( &_storage ) Functor( std::forward<F>( f ) );
+        _invoke = [ ]( void* p ) { ( *static_cast< Functor* >( p ) )( ); };
+        _destroy = [ ]( void* p ) { static_cast< Functor* >( p )->~Functor( ); };
+      }
+      template <typename Functor, typename F>
+      void setImpl( F&& f, std::false_type )
+      {
+        *reinterpret_cast< Functor** >( &_storage ) =
+          new Functor( std::forward<F>( f ) );
+        _invoke = [ ]( void* p ) { ( **static_cast< Functor** >( p ) )( ); };
+        _destroy = [ ]( void* p ) { delete *static_cast< Functor** >( p ); };
+      }
+
+      typedef typename std::aligned_storage<INLINE_SIZE>::type Storage;
+      typedef void( *Function )( void* );
+
+      Storage _storage;
+      Function _invoke;
+      Function _destroy;
+    };
+
+    // Counts the unfinished jobs of a group, used to fork-join
+    class JobCounter
+    {
+    public:
+      JobCounter( void )
+        : _pending( 0 )
+      {
+      }
+      JobCounter( const JobCounter& ) = delete;
+      JobCounter& operator=( const JobCounter& ) = delete;
+
+      bool isDone( void ) const
+      {
+        return _pending.load( std::memory_order_acquire ) == 0;
+      }
+    private:
+      friend class JobSystem;
+      std::atomic<uint32_t> _pending;
+    };
+
+    /**
+    * Work-stealing scheduler. Every worker owns a lock-free deque (pushes
+    *   and pops at the bottom, thieves steal from the top); jobs pushed by
+    *   other threads go to a shared queue. Job storage is a fixed ring per
+    *   thread, so running a job does not allocate. If the ring is full the
+    *   job runs inline on the caller.
+    *   wait( ) executes pending jobs while the counter is not done, so
+    *   jobs can fork and join other jobs without deadlocking.
+    */
+    class JobSystem
+    {
+    public:
+      // Jobs that can be in flight per thread
+      static const uint32_t JOB_CAPACITY = 4096;
+
+      // workerCount 0 uses one worker per hardware thread minus the caller
+      LAVAUTILS_API
+      JobSystem( uint32_t workerCount = 0, bool pinWorkers = false );
+      LAVAUTILS_API
+      ~JobSystem( void );
+
+      JobSystem( const JobSystem& ) = delete;
+      JobSystem& operator=( const JobSystem& ) = delete;
+
+      // Engine-wide executor with the default settings
+      LAVAUTILS_API
+      static JobSystem& global( void );
+
+      template <typename F>
+      void run( F&& f, JobCounter* counter = nullptr )
+      {
+        Job* job = allocateJob( );
+        if ( !job )
+        {
+          f( );
+          return;
+        }
+        job->task.set( std::forward<F>( f ) );
+        job->counter = counter;
+        if ( counter )
+        {
+          counter->_pending.fetch_add( 1, std::memory_order_relaxed );
+        }
+        submit( job );
+      }
+
+      // Calls f( i ) for i in [0, count) in jobs of grain iterations
+      template <typename F>
+      void parallelFor( size_t count, size_t grain, F f, JobCounter& counter )
+      {
+        grain = std::max< size_t >( grain, 1 );
+        for ( size_t first = 0; first < count; first += grain )
+        {
+          size_t last = std::min( first + grain, count );
+          run( [ f, first, last ]( )
+          {
+            for ( size_t i = first; i < last; ++i )
+            {
+              f( i );
+            }
+          }, &counter );
+        }
+      }
+
+      // Runs other jobs until counter is done
+      LAVAUTILS_API
+      void wait( JobCounter& counter );
+
+      inline uint32_t workerCount( void ) const
+      {
+        return static_cast< uint32_t >( _workers.size( ) );
+      }
+
+      /**
+      * Index of the calling thread: [0, workerCount) for the workers and
+      *   workerCount for any other thread. Useful to pick worker-owned
+      *   resources like command pools; every non-worker thread that waits
+      *   may run jobs too and they all share workerCount, so resources for
+      *   them must be keyed by thread id instead.
+      */
+      LAVAUTILS_API
+      uint32_t currentThreadIndex( void ) const;
+    protected:
+      struct Job
+      {
+        Task task;
+        JobCounter* counter;
+        std::atomic<bool> busy;
+
+        Job( void )
+          : counter( nullptr )
+          , busy( false )
+        {
+        }
+      };
+      struct Worker;
+
+      LAVAUTILS_API
+      Job* allocateJob( void );
+      LAVAUTILS_API
+      void submit( Job* job );
+      Job* findJob( uint32_t threadIndex );
+      void execute( Job* job );
+      void workerLoop( uint32_t index );
+
+      std::vector<std::unique_ptr<Worker>> _workers;
+
+      // Jobs pushed from threads that are not workers
+      std::unique_ptr<Job[ ]> _externalJobs;
+      uint32_t _externalAllocated;
+      std::deque<Job*> _externalQueue;
+      std::mutex _externalMutex;
+
+      std::atomic<int> _queued;
+      std::atomic<bool> _stop;
+      std::mutex _sleepMutex;
+      std::condition_variable _sleepCondition;
+    };
+  }
+}
+
+#endif /* __LAVAUTILS_JOBSYSTEM__ */
@@ -18,6 +18,7 @@
  **/
 
 #include "Material.h"
+#include "MeshCache.h"
 #include <iostream>
 
 #ifdef LAVA_USE_ASSIMP
@@ -72,6 +73,18 @@ namespace lava
         useAlbedoTexture = false;
       }
     }
+    Material::Material( const MeshCache& cache, uint32_t index,
+      const std::string& globalPath )
+    {
+      const MeshCache::MaterialRef& material = cache.material( index );
+      albedoColor = glm::vec3( material.albedoColor[ 0 ],
+        material.albedoColor[ 1 ], material.albedoColor[ 2 ] );
+      useAlbedoTexture = material.useAlbedoTexture != 0;
+      if ( useAlbedoTexture )
+      {
+        albedoTexturePath = globalPath + cache.albedoTexturePath( index );
+      }
+    }
   }
 }
 
@@ -31,11 +31,16 @@ namespace lava
 {
   namespace utility
   {
+    class MeshCache;
+
     class Material
     {
     public:
       LAVAUTILS_API
       Material( const aiMaterial* mtl, const std::string& globalPath );
+      LAVAUTILS_API
+      Material( const MeshCache& cache, uint32_t index,
+        const std::string& globalPath );
       std::string albedoTexturePath;
       glm::vec3 albedoColor;
       bool useAlbedoTexture;
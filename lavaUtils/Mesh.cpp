@@ -18,6 +18,7 @@
  **/
 
 #include "Mesh.h"
+#include "MeshCache.h"
 
 #ifdef LAVA_USE_ASSIMP
 namespace lava
@@ -68,9 +69,24 @@ namespace lava
           indices.push_back(face.mIndices[j]);
       }
 
+      materialIndex = mesh->mMaterialIndex;
       numVertices = mesh->mNumVertices;
       numIndices = mesh->mNumFaces * 3;
     }
+    Mesh::Mesh( const MeshCache& cache, uint32_t index )
+    {
+      const MeshCache::Submesh& submesh = cache.submesh( index );
+      const Vertex* cachedVertices =
+        static_cast< const Vertex* >( cache.vertices( ) ) + submesh.firstVertex;
+      const uint32_t* cachedIndices = cache.indices( ) + submesh.firstIndex;
+
+      vertices.assign( cachedVertices, cachedVertices + submesh.vertexCount );
+      indices.assign( cachedIndices, cachedIndices + submesh.indexCount );
+
+      materialIndex = submesh.materialIndex;
+      numVertices = submesh.vertexCount;
+      numIndices = submesh.indexCount;
+    }
   }
 }
 #endif
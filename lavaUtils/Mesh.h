@@ -38,12 +38,18 @@ namespace lava
       glm::vec3 normal;
       glm::vec2 texCoord;
     };
+    class MeshCache;
+
     class Mesh
     {
     public:
       LAVAUTILS_API
       Mesh( const aiMesh *mesh );
+      // Copies submesh index of cache
+      LAVAUTILS_API
+      Mesh( const MeshCache& cache, uint32_t index );
     public:
+      uint32_t materialIndex;
       uint32_t numVertices;
       uint32_t numIndices;
       std::vector< Vertex > vertices;
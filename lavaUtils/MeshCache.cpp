@@ -0,0 +1,360 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "MeshCache.h"
+
+#ifdef LAVA_USE_ASSIMP
+  #include "Material.h"
+  #include "Mesh.h"
+  #include "ModelImporter.h"
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <lava/utils.hpp>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace lava
+{
+  namespace utility
+  {
+    namespace
+    {
+      inline uint64_t align16( uint64_t offset )
+      {
+        return ( offset + 15 ) & ~uint64_t( 15 );
+      }
+
+      // Same base path ModelImporter gives to the materials
+      std::string modelDirectory( const std::string& sourcePath )
+      {
+        std::size_t last = sourcePath.find_last_of( '/' );
+        return last != std::string::npos ?
+          sourcePath.substr( 0, last + 1 ) : std::string( "./" );
+      }
+    }
+
+    MeshCache::MeshCache( void )
+      : _data( nullptr )
+      , _size( 0 )
+      , _mapping( nullptr )
+      , _header( nullptr )
+      , _submeshes( nullptr )
+      , _materials( nullptr )
+      , _strings( nullptr )
+    {
+    }
+
+    MeshCache::~MeshCache( void )
+    {
+      if ( _data == nullptr )
+      {
+        return;
+      }
+#ifdef _WIN32
+      UnmapViewOfFile( _data );
+      CloseHandle( _mapping );
+#else
+      munmap( const_cast< unsigned char* >( _data ), _size );
+#endif
+    }
+
+    std::string MeshCache::cachePath( const std::string& sourcePath )
+    {
+      return sourcePath + ".lmc";
+    }
+
+    std::shared_ptr<MeshCache> MeshCache::open( const std::string& sourcePath )
+    {
+      std::shared_ptr<MeshCache> cache( new MeshCache( ) );
+      if ( !cache->map( cachePath( sourcePath ) ) || !cache->validate( ) )
+      {
+        return nullptr;
+      }
+
+      struct stat source;
+      if ( stat( sourcePath.c_str( ), &source ) == 0 &&
+        ( cache->_header->sourceSize != static_cast< uint64_t >( source.st_size ) ||
+          cache->_header->sourceTime != static_cast< int64_t >( source.st_mtime ) ) )
+      {
+        return nullptr;
+      }
+      return cache;
+    }
+
+    std::shared_ptr<MeshCache> MeshCache::load( const std::string& sourcePath )
+    {
+      std::shared_ptr<MeshCache> cache = open( sourcePath );
+#ifdef LAVA_USE_ASSIMP
+      if ( !cache )
+      {
+        ModelImporter importer( sourcePath );
+        cache = open( sourcePath );
+      }
+#endif
+      return cache;
+    }
+
+#ifdef LAVA_USE_ASSIMP
+    bool MeshCache::write( const std::string& sourcePath,
+      const std::vector<Mesh>& meshes, const std::vector<Material>& materials )
+    {
+      struct stat source;
+      if ( stat( sourcePath.c_str( ), &source ) != 0 )
+      {
+        return false;
+      }
+
+      Header header;
+      memset( &header, 0, sizeof( header ) );
+      header.magic = MAGIC;
+      header.version = VERSION;
+      header.sourceSize = static_cast< uint64_t >( source.st_size );
+      header.sourceTime = static_cast< int64_t >( source.st_mtime );
+      header.vertexStride = sizeof( Vertex );
+      header.submeshCount = static_cast< uint32_t >( meshes.size( ) );
+      header.materialCount = static_cast< uint32_t >( materials.size( ) );
+
+      std::vector<Submesh> submeshes;
+      submeshes.reserve( meshes.size( ) );
+      uint32_t vertexCount = 0;
+      uint32_t indexCount = 0;
+      for ( const auto& mesh : meshes )
+      {
+        Submesh submesh;
+        submesh.firstVertex = vertexCount;
+        submesh.vertexCount = static_cast< uint32_t >( mesh.vertices.size( ) );
+        submesh.firstIndex = indexCount;
+        submesh.indexCount = static_cast< uint32_t >( mesh.indices.size( ) );
+        submesh.materialIndex = mesh.materialIndex;
+        submesh.padding = 0;
+        submeshes.push_back( submesh );
+
+        vertexCount += submesh.vertexCount;
+        indexCount += submesh.indexCount;
+      }
+
+      // Texture paths are stored relative to the model, so it can be moved
+      const std::string directory = modelDirectory( sourcePath );
+      std::vector<MaterialRef> refs;
+      refs.reserve( materials.size( ) );
+      std::string strings;
+      for ( const auto& material : materials )
+      {
+        std::string texturePath = material.albedoTexturePath;
+        if ( texturePath.compare( 0, directory.size( ), directory ) == 0 )
+        {
+          texturePath.erase( 0, directory.size( ) );
+        }
+
+        MaterialRef ref;
+        ref.albedoColor[ 0 ] = material.albedoColor.x;
+        ref.albedoColor[ 1 ] = material.albedoColor.y;
+        ref.albedoColor[ 2 ] = material.albedoColor.z;
+        ref.useAlbedoTexture = material.useAlbedoTexture ? 1 : 0;
+        ref.albedoTexturePathOffset = static_cast< uint32_t >( strings.size( ) );
+        ref.albedoTexturePathSize =
+          static_cast< uint32_t >( texturePath.size( ) );
+        refs.push_back( ref );
+
+        strings += texturePath;
+      }
+      header.stringsSize = static_cast< uint32_t >( strings.size( ) );
+
+      uint64_t tablesSize = sizeof( Header ) + submeshes.size( ) * sizeof( Submesh ) +
+        refs.size( ) * sizeof( MaterialRef ) + strings.size( );
+      header.vertexOffset = align16( tablesSize );
+      header.vertexSize = uint64_t( vertexCount ) * sizeof( Vertex );
+      header.indexOffset = align16( header.vertexOffset + header.vertexSize );
+      header.indexSize = uint64_t( indexCount ) * sizeof( uint32_t );
+
+      std::vector<unsigned char> file(
+        static_cast< size_t >( header.indexOffset + header.indexSize ), 0 );
+      unsigned char* dst = file.data( );
+      memcpy( dst, &header, sizeof( header ) );
+      dst += sizeof( header );
+      if ( !submeshes.empty( ) )
+      {
+        memcpy( dst, submeshes.data( ), submeshes.size( ) * sizeof( Submesh ) );
+        dst += submeshes.size( ) * sizeof( Submesh );
+      }
+      if ( !refs.empty( ) )
+      {
+        memcpy( dst, refs.data( ), refs.size( ) * sizeof( MaterialRef ) );
+        dst += refs.size( ) * sizeof( MaterialRef );
+      }
+      memcpy( dst, strings.data( ), strings.size( ) );
+
+      for ( size_t i = 0; i < meshes.size( ); ++i )
+      {
+        memcpy( file.data( ) + header.vertexOffset +
+          uint64_t( submeshes[ i ].firstVertex ) * sizeof( Vertex ),
+          meshes[ i ].vertices.data( ), meshes[ i ].vertices.size( ) * sizeof( Vertex ) );
+        memcpy( file.data( ) + header.indexOffset +
+          uint64_t( submeshes[ i ].firstIndex ) * sizeof( uint32_t ),
+          meshes[ i ].indices.data( ), meshes[ i ].indices.size( ) * sizeof( uint32_t ) );
+      }
+
+      // Written aside and renamed, so readers never map a partial file
+      const std::string filePath = cachePath( sourcePath );
+      if ( !utils::writeFileAtomic( filePath,
+        { { file.data( ), file.size( ) } } ) )
+      {
+        std::cerr << "Failed to write mesh cache " << filePath << std::endl;
+        return false;
+      }
+      return true;
+    }
+#endif
+
+    bool MeshCache::map( const std::string& path )
+    {
+#ifdef _WIN32
+      HANDLE file = CreateFileA( path.c_str( ), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+      if ( file == INVALID_HANDLE_VALUE )
+      {
+        return false;
+      }
+      LARGE_INTEGER size;
+      if ( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 )
+      {
+        CloseHandle( file );
+        return false;
+      }
+      // The mapping keeps the file open
+      HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0,
+        nullptr );
+      CloseHandle( file );
+      if ( mapping == nullptr )
+      {
+        return false;
+      }
+      void* data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+      if ( data == nullptr )
+      {
+        CloseHandle( mapping );
+        return false;
+      }
+      _mapping = mapping;
+      _size = static_cast< size_t >( size.QuadPart );
+#else
+      int fd = ::open( path.c_str( ), O_RDONLY );
+      if ( fd < 0 )
+      {
+        return false;
+      }
+      struct stat info;
+      if ( fstat( fd, &info ) != 0 || info.st_size == 0 )
+      {
+        close( fd );
+        return false;
+      }
+      // The mapping keeps the file open
+      void* data = mmap( nullptr, static_cast< size_t >( info.st_size ),
+        PROT_READ, MAP_PRIVATE, fd, 0 );
+      close( fd );
+      if ( data == MAP_FAILED )
+      {
+        return false;
+      }
+      _size = static_cast< size_t >( info.st_size );
+      // Everything is read right away to be staged
+      posix_madvise( data, _size, POSIX_MADV_WILLNEED );
+#endif
+      _data = static_cast< const unsigned char* >( data );
+      return true;
+    }
+
+    bool MeshCache::validate( void )
+    {
+      if ( _size < sizeof( Header ) )
+      {
+        return false;
+      }
+      _header = reinterpret_cast< const Header* >( _data );
+      // A different Vertex layout makes the cache stale, it gets rewritten
+      if ( _header->magic != MAGIC || _header->version != VERSION ||
+        _header->vertexStride != sizeof( Vertex ) )
+      {
+        return false;
+      }
+      // Vertices and indices are read in place
+      if ( _header->vertexOffset % 16 != 0 || _header->indexOffset % 16 != 0 )
+      {
+        return false;
+      }
+
+      uint64_t submeshesOffset = sizeof( Header );
+      uint64_t materialsOffset = submeshesOffset +
+        uint64_t( _header->submeshCount ) * sizeof( Submesh );
+      uint64_t stringsOffset = materialsOffset +
+        uint64_t( _header->materialCount ) * sizeof( MaterialRef );
+      if ( stringsOffset + _header->stringsSize > _size ||
+        _header->vertexOffset > _size ||
+        _header->vertexSize > _size - _header->vertexOffset ||
+        _header->indexOffset > _size ||
+        _header->indexSize > _size - _header->indexOffset )
+      {
+        return false;
+      }
+      _submeshes = reinterpret_cast< const Submesh* >( _data + submeshesOffset );
+      _materials = reinterpret_cast< const MaterialRef* >( _data + materialsOffset );
+      _strings = reinterpret_cast< const char* >( _data + stringsOffset );
+
+      uint64_t vertexCount = _header->vertexSize / _header->vertexStride;
+      uint64_t indexCount = _header->indexSize / sizeof( uint32_t );
+      for ( uint32_t i = 0; i < _header->submeshCount; ++i )
+      {
+        if ( uint64_t( _submeshes[ i ].firstVertex ) + _submeshes[ i ].vertexCount > vertexCount ||
+          uint64_t( _submeshes[ i ].firstIndex ) + _submeshes[ i ].indexCount > indexCount )
+        {
+          return false;
+        }
+      }
+      for ( uint32_t i = 0; i < _header->materialCount; ++i )
+      {
+        if ( uint64_t( _materials[ i ].albedoTexturePathOffset ) +
+          _materials[ i ].albedoTexturePathSize > _header->stringsSize )
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+}
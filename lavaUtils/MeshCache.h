@@ -0,0 +1,162 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVAUTILS_MESH_CACHE__
+#define __LAVAUTILS_MESH_CACHE__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <lavaUtils/api.h>
+
+namespace lava
+{
+  namespace utility
+  {
+    class Mesh;
+    class Material;
+
+    /**
+    * Engine-native binary model, written the first time a model is imported
+    *   and memory-mapped afterwards. Vertices (Vertex) and indices (uint32_t)
+    *   are stored in the layout the GPU reads, so they can be copied into a
+    *   staging buffer straight from the mapping, with no parsing.
+    *
+    *   Layout: Header | Submesh[ submeshCount ] | Material[ materialCount ]
+    *     | strings | vertices | indices. Blobs are aligned to 16 bytes.
+    */
+    class MeshCache
+    {
+    public:
+      static const uint32_t MAGIC = 0x434D564C;  // "LVMC"
+      // Bump when the layout of the file or of Vertex changes
+      static const uint32_t VERSION = 1;
+
+      struct Header
+      {
+        uint32_t magic;
+        uint32_t version;
+        // Size and mtime of the source model, a mismatch marks the cache stale
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint32_t vertexStride;
+        uint32_t submeshCount;
+        uint32_t materialCount;
+        uint32_t stringsSize;
+        uint64_t vertexOffset;
+        uint64_t vertexSize;
+        uint64_t indexOffset;
+        uint64_t indexSize;
+      };
+      // Indices are relative to firstVertex
+      struct Submesh
+      {
+        uint32_t firstVertex;
+        uint32_t vertexCount;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t materialIndex;
+        uint32_t padding;
+      };
+      struct MaterialRef
+      {
+        float albedoColor[ 3 ];
+        uint32_t useAlbedoTexture;
+        // Range of the texture path in the string table
+        uint32_t albedoTexturePathOffset;
+        uint32_t albedoTexturePathSize;
+      };
+
+      LAVAUTILS_API
+      ~MeshCache( void );
+
+      MeshCache( const MeshCache& ) = delete;
+      MeshCache& operator=( const MeshCache& ) = delete;
+
+      // Cache file of sourcePath, next to it
+      LAVAUTILS_API
+      static std::string cachePath( const std::string& sourcePath );
+      /**
+      * Maps the cache of sourcePath. Returns nullptr if there is none or it
+      *   was written by another version, with another Vertex layout or from
+      *   another revision of the source. Without the source file the cache
+      *   is trusted as is.
+      */
+      LAVAUTILS_API
+      static std::shared_ptr<MeshCache> open( const std::string& sourcePath );
+      /**
+      * Same as open, but on a miss imports the model (which writes the
+      *   cache) and maps the result. Returns nullptr if it could not be
+      *   written or there is no importer (LAVA_USE_ASSIMP).
+      */
+      LAVAUTILS_API
+      static std::shared_ptr<MeshCache> load( const std::string& sourcePath );
+#ifdef LAVA_USE_ASSIMP
+      // Writes the cache of sourcePath, false on I/O error
+      LAVAUTILS_API
+      static bool write( const std::string& sourcePath,
+        const std::vector<Mesh>& meshes, const std::vector<Material>& materials );
+#endif
+
+      inline const Header& header( void ) const
+      {
+        return *_header;
+      }
+      inline const Submesh& submesh( uint32_t index ) const
+      {
+        return _submeshes[ index ];
+      }
+      inline const MaterialRef& material( uint32_t index ) const
+      {
+        return _materials[ index ];
+      }
+      // Relative to the directory of the model
+      inline std::string albedoTexturePath( uint32_t index ) const
+      {
+        return std::string( _strings + _materials[ index ].albedoTexturePathOffset,
+          _materials[ index ].albedoTexturePathSize );
+      }
+      // Vertices of every submesh, header( ).vertexStride bytes each
+      inline const void* vertices( void ) const
+      {
+        return _data + _header->vertexOffset;
+      }
+      inline const uint32_t* indices( void ) const
+      {
+        return reinterpret_cast< const uint32_t* >( _data + _header->indexOffset );
+      }
+    protected:
+      MeshCache( void );
+      bool map( const std::string& path );
+      bool validate( void );
+
+      const unsigned char* _data;
+      size_t _size;
+      // File mapping handle on Windows
+      void* _mapping;
+      const Header* _header;
+      const Submesh* _submeshes;
+      const MaterialRef* _materials;
+      const char* _strings;
+    };
+  }
+}
+
+#endif /* __LAVAUTILS_MESH_CACHE__ */
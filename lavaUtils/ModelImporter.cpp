@@ -18,6 +18,7 @@
  **/
 
 #include "ModelImporter.h"
+#include "MeshCache.h"
 
 #include <iostream>
 
@@ -27,10 +28,8 @@ namespace lava
 {
   namespace utility
   {
-    ModelImporter::ModelImporter( const std::string& path )
+    ModelImporter::ModelImporter( const std::string& path, bool useCache )
     {
-      Assimp::Importer imp;
-
       std::string globalPath;
       std::size_t last = path.find_last_of( '/' );
 
@@ -45,6 +44,22 @@ namespace lava
         globalPath = "./";
       }
 
+      std::shared_ptr<MeshCache> cache = useCache ?
+        MeshCache::open( path ) : nullptr;
+      if ( cache )
+      {
+        for ( uint32_t i = 0; i < cache->header( ).submeshCount; ++i )
+        {
+          _meshes.emplace_back( *cache, i );
+        }
+        for ( uint32_t i = 0; i < cache->header( ).materialCount; ++i )
+        {
+          _materials.emplace_back( *cache, i, globalPath );
+        }
+        return;
+      }
+
+      Assimp::Importer imp;
       aiScene const *scene = imp.ReadFile( path,
         aiProcessPreset_TargetRealtime_Fast | aiProcess_FlipUVs );
 
@@ -63,6 +78,11 @@ namespace lava
       {
         _materials.emplace_back( scene->mMaterials[ i ], globalPath );
       }
+
+      if ( useCache && !MeshCache::write( path, _meshes, _materials ) )
+      {
+        std::cerr << "Failed to write mesh cache for " << path << std::endl;
+      }
     }
   }
 }
@@ -35,11 +35,16 @@ namespace lava
 {
   namespace utility
   {
+    /**
+    * Imports a model with Assimp and writes its MeshCache, so later runs
+    *   read the binary cache instead (see MeshCache::cachePath). Pass
+    *   useCache = false to always import.
+    */
     class ModelImporter
     {
     public:
       LAVAUTILS_API
-      ModelImporter( const std::string& path );
+      ModelImporter( const std::string& path, bool useCache = true );
     public:
       std::vector< Mesh > _meshes;
       std::vector< Material > _materials;
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "ParallelRecorder.h"
+
+#include <algorithm>
+
+namespace lava
+{
+  namespace utility
+  {
+    ParallelRecorder::ParallelRecorder( const std::shared_ptr<Device>& device,
+      uint32_t familyIndex, JobSystem& jobSystem, uint32_t framesInFlight )
+      : _device( device )
+      , _familyIndex( familyIndex )
+      , _framesInFlight( framesInFlight )
+      , _frameIndex( 0 )
+      , _jobSystem( jobSystem )
+    {
+      for ( uint32_t i = 0; i < _jobSystem.workerCount( ); ++i )
+      {
+        _commandPools.push_back( device->createFrameCommandPool( familyIndex,
+          framesInFlight ) );
+      }
+    }
+
+    void ParallelRecorder::beginFrame( uint32_t frameIndex )
+    {
+      _frameIndex = frameIndex;
+      for ( auto& pool : _commandPools )
+      {
+        pool->beginFrame( frameIndex );
+      }
+      std::lock_guard<std::mutex> lock( _externalMutex );
+      for ( auto& it : _externalPools )
+      {
+        it.second->beginFrame( frameIndex );
+      }
+    }
+
+    FrameCommandPool* ParallelRecorder::currentPool( void )
+    {
+      uint32_t index = _jobSystem.currentThreadIndex( );
+      if ( index < _commandPools.size( ) )
+      {
+        return _commandPools[ index ].get( );
+      }
+
+      // Non-worker threads all share one index, so key them by id instead
+      std::lock_guard<std::mutex> lock( _externalMutex );
+      auto& pool = _externalPools[ std::this_thread::get_id( ) ];
+      if ( !pool )
+      {
+        pool = _device->createFrameCommandPool( _familyIndex,
+          _framesInFlight );
+        pool->beginFrame( _frameIndex );
+      }
+      return pool.get( );
+    }
+
+    std::vector<std::shared_ptr<CommandBuffer>> ParallelRecorder::record(
+      const std::shared_ptr<RenderPass>& renderPass, uint32_t subpass,
+      const std::shared_ptr<Framebuffer>& framebuffer,
+      const std::vector<DrawJob>& jobs, const DrawJob& prologue )
+    {
+      if ( jobs.empty( ) )
+      {
+        return std::vector<std::shared_ptr<CommandBuffer>>( );
+      }
+
+      // The caller helps while waiting, so it counts as one more thread
+      size_t numWorkers = _commandPools.size( ) + 1;
+      size_t chunkSize = ( jobs.size( ) + numWorkers - 1 ) / numWorkers;
+      size_t numChunks = ( jobs.size( ) + chunkSize - 1 ) / chunkSize;
+      std::vector<std::shared_ptr<CommandBuffer>> secondaries( numChunks );
+      JobCounter counter;
+
+      for ( size_t i = 0; i < numChunks; ++i )
+      {
+        size_t first = i * chunkSize;
+        size_t last = std::min( first + chunkSize, jobs.size( ) );
+        std::shared_ptr<CommandBuffer>* result = &secondaries[ i ];
+
+        _jobSystem.run( [ = , &jobs, &prologue ]( )
+        {
+          FrameCommandPool* pool = currentPool( );
+          auto cmd = pool->allocateCommandBuffer(
+            vk::CommandBufferLevel::eSecondary );
+          cmd->begin( vk::CommandBufferUsageFlagBits::eRenderPassContinue |
+            vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+            renderPass, subpass, framebuffer );
+          if ( prologue )
+          {
+            prologue( cmd );
+          }
+          for ( size_t j = first; j < last; ++j )
+          {
+            jobs[ j ]( cmd );
+          }
+          cmd->end( );
+          *result = cmd;
+        }, &counter );
+      }
+      _jobSystem.wait( counter );
+
+      return secondaries;
+    }
+
+    void ParallelRecorder::recordAndExecute(
+      const std::shared_ptr<CommandBuffer>& primary,
+      const std::shared_ptr<RenderPass>& renderPass, uint32_t subpass,
+      const std::shared_ptr<Framebuffer>& framebuffer,
+      const std::vector<DrawJob>& jobs, const DrawJob& prologue )
+    {
+      auto secondaries = record( renderPass, subpass, framebuffer, jobs,
+        prologue );
+      if ( !secondaries.empty( ) )
+      {
+        primary->executeCommands( secondaries );
+      }
+    }
+  }
+}
@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVAUTILS_PARALLEL_RECORDER__
+#define __LAVAUTILS_PARALLEL_RECORDER__
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <lava/lava.h>
+#include <lavaUtils/api.h>
+
+#include "JobSystem.h"
+
+namespace lava
+{
+  namespace utility
+  {
+    // Records a draw (or a few) on the secondary command buffer it receives
+    typedef std::function<void( const std::shared_ptr<CommandBuffer>& )> DrawJob;
+
+    /**
+    * Splits a list of draw jobs across the JobSystem threads. Every worker
+    *   owns its command pools, and so does every other thread that ends up
+    *   running a chunk while it waits on the same JobSystem (the caller of
+    *   record, or any unrelated thread calling JobSystem::wait); those get
+    *   their pools on first use. Each chunk records one secondary command
+    *   buffer on the pools of whichever thread runs it, inheriting the
+    *   render pass, subpass and framebuffer. Jobs are split in contiguous
+    *   chunks so the draw order is kept when the secondaries are executed.
+    *   record must not be called from two threads at the same time.
+    */
+    class ParallelRecorder
+    {
+    public:
+      LAVAUTILS_API
+      ParallelRecorder( const std::shared_ptr<Device>& device,
+        uint32_t familyIndex, JobSystem& jobSystem,
+        uint32_t framesInFlight = 1 );
+
+      /**
+      * Resets the command pools of frameIndex on every worker. The GPU work
+      *   recorded on them the last time must have finished.
+      */
+      LAVAUTILS_API
+      void beginFrame( uint32_t frameIndex );
+
+      /**
+      * Records the jobs and returns the secondaries in draw order. prologue,
+      *   if set, runs first on every secondary (bind pipeline, viewport...).
+      */
+      LAVAUTILS_API
+      std::vector<std::shared_ptr<CommandBuffer>> record(
+        const std::shared_ptr<RenderPass>& renderPass, uint32_t subpass,
+        const std::shared_ptr<Framebuffer>& framebuffer,
+        const std::vector<DrawJob>& jobs, const DrawJob& prologue = nullptr );
+
+      // Records the jobs and executes them on primary, which must be inside
+      //    renderPass with eSecondaryCommandBuffers contents
+      LAVAUTILS_API
+      void recordAndExecute( const std::shared_ptr<CommandBuffer>& primary,
+        const std::shared_ptr<RenderPass>& renderPass, uint32_t subpass,
+        const std::shared_ptr<Framebuffer>& framebuffer,
+        const std::vector<DrawJob>& jobs, const DrawJob& prologue = nullptr );
+    protected:
+      // Pool owned by the calling thread: its worker pool or an external one
+      FrameCommandPool* currentPool( void );
+
+      std::shared_ptr<Device> _device;
+      uint32_t _familyIndex;
+      uint32_t _framesInFlight;
+      uint32_t _frameIndex;
+      JobSystem& _jobSystem;
+      // One per worker, only used from that worker
+      std::vector<std::shared_ptr<FrameCommandPool>> _commandPools;
+      // One per non-worker thread that ran a chunk, only used from that thread
+      std::map<std::thread::id, std::shared_ptr<FrameCommandPool>>
+        _externalPools;
+      std::mutex _externalMutex;
+    };
+  }
+}
+
+#endif /* __LAVAUTILS_PARALLEL_RECORDER__ */
@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "PipelineCompiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace lava
+{
+  namespace utility
+  {
+    std::shared_ptr<Pipeline> PipelineHandle::wait( void )
+    {
+      _jobSystem.wait( _counter );
+      return get( );
+    }
+
+    PipelineCompiler::PipelineCompiler( const std::shared_ptr<Device>& device,
+      const std::shared_ptr<PipelineCache>& targetCache, JobSystem& jobSystem )
+      : _device( device )
+      , _targetCache( targetCache )
+      , _jobSystem( jobSystem )
+    {
+      // Warm every thread cache with what the target already knows
+      if ( _targetCache )
+      {
+        _initialData = _targetCache->getData( );
+      }
+      for ( uint32_t i = 0; i < _jobSystem.workerCount( ); ++i )
+      {
+        _threadCaches.push_back( _device->createPipelineCache(
+          _initialData.size( ),
+          _initialData.empty( ) ? nullptr : _initialData.data( ) ) );
+      }
+    }
+
+    PipelineCompiler::~PipelineCompiler( void )
+    {
+      flush( );
+    }
+
+    std::shared_ptr<PipelineCache> PipelineCompiler::threadCache( void )
+    {
+      uint32_t index = _jobSystem.currentThreadIndex( );
+      if ( index < _threadCaches.size( ) )
+      {
+        return _threadCaches[ index ];
+      }
+
+      // Non-worker threads all share one index, so key them by id instead
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto& cache = _externalCaches[ std::this_thread::get_id( ) ];
+      if ( !cache )
+      {
+        cache = _device->createPipelineCache( _initialData.size( ),
+          _initialData.empty( ) ? nullptr : _initialData.data( ) );
+      }
+      return cache;
+    }
+
+    template <typename Func>
+    std::shared_ptr<PipelineHandle> PipelineCompiler::enqueue(
+      const std::shared_ptr<Pipeline>& fallback, Func create )
+    {
+      auto handle = std::make_shared<PipelineHandle>( _jobSystem, fallback );
+      {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _inFlight.push_back( handle );
+      }
+
+      PipelineHandle* target = handle.get( );
+      _jobSystem.run( [ this, target, create ]( )
+      {
+        try
+        {
+          target->_pipeline = create( threadCache( ) );
+        }
+        catch ( std::exception& e )
+        {
+          std::cerr << "Pipeline compilation failed: " << e.what( ) << std::endl;
+          target->_failed.store( true, std::memory_order_release );
+          return;
+        }
+        target->_ready.store( true, std::memory_order_release );
+      }, &handle->_counter );
+
+      return handle;
+    }
+
+    std::shared_ptr<PipelineHandle> PipelineCompiler::compile(
+      const GraphicsPipelineDescription& description,
+      const std::shared_ptr<Pipeline>& fallback )
+    {
+      auto desc = std::make_shared<GraphicsPipelineDescription>( description );
+      std::shared_ptr<Device> device = _device;
+
+      return enqueue( fallback, [ device, desc ](
+        const std::shared_ptr<PipelineCache>& cache )
+      {
+        return device->createGraphicsPipeline( cache, desc->flags, desc->stages,
+          desc->vertexInputState ? vk::Optional<const PipelineVertexInputStateCreateInfo>(
+            *desc->vertexInputState ) : nullptr,
+          desc->inputAssemblyState ? vk::Optional<const vk::PipelineInputAssemblyStateCreateInfo>(
+            *desc->inputAssemblyState ) : nullptr,
+          desc->tessellationState ? vk::Optional<const vk::PipelineTessellationStateCreateInfo>(
+            *desc->tessellationState ) : nullptr,
+          desc->viewportState ? vk::Optional<const PipelineViewportStateCreateInfo>(
+            *desc->viewportState ) : nullptr,
+          desc->rasterizationState ? vk::Optional<const vk::PipelineRasterizationStateCreateInfo>(
+            *desc->rasterizationState ) : nullptr,
+          desc->multisampleState ? vk::Optional<const PipelineMultisampleStateCreateInfo>(
+            *desc->multisampleState ) : nullptr,
+          desc->depthStencilState ? vk::Optional<const vk::PipelineDepthStencilStateCreateInfo>(
+            *desc->depthStencilState ) : nullptr,
+          desc->colorBlendState ? vk::Optional<const PipelineColorBlendStateCreateInfo>(
+            *desc->colorBlendState ) : nullptr,
+          desc->dynamicState ? vk::Optional<const PipelineDynamicStateCreateInfo>(
+            *desc->dynamicState ) : nullptr,
+          desc->pipelineLayout, desc->renderPass, desc->subpass );
+      } );
+    }
+
+    std::shared_ptr<PipelineHandle> PipelineCompiler::compile(
+      const ComputePipelineDescription& description,
+      const std::shared_ptr<Pipeline>& fallback )
+    {
+      auto desc = std::make_shared<ComputePipelineDescription>( description );
+      std::shared_ptr<Device> device = _device;
+
+      return enqueue( fallback, [ device, desc ](
+        const std::shared_ptr<PipelineCache>& cache )
+      {
+        return device->createComputePipeline( cache, desc->flags, desc->stage,
+          desc->pipelineLayout );
+      } );
+    }
+
+    size_t PipelineCompiler::pending( void )
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _inFlight.erase( std::remove_if( _inFlight.begin( ), _inFlight.end( ),
+        [ ]( const std::shared_ptr<PipelineHandle>& handle )
+        {
+          return handle->_counter.isDone( );
+        } ), _inFlight.end( ) );
+      return _inFlight.size( );
+    }
+
+    void PipelineCompiler::flush( void )
+    {
+      std::vector<std::shared_ptr<PipelineHandle>> inFlight;
+      {
+        std::lock_guard<std::mutex> lock( _mutex );
+        inFlight.swap( _inFlight );
+      }
+      for ( auto& handle : inFlight )
+      {
+        handle->wait( );
+      }
+
+      if ( _targetCache )
+      {
+        std::vector<std::shared_ptr<PipelineCache>> caches = _threadCaches;
+        {
+          std::lock_guard<std::mutex> lock( _mutex );
+          for ( auto const& it : _externalCaches )
+          {
+            caches.push_back( it.second );
+          }
+        }
+        _targetCache->merge( caches );
+      }
+    }
+  }
+}
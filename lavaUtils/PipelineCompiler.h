@@ -0,0 +1,183 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVAUTILS_PIPELINE_COMPILER__
+#define __LAVAUTILS_PIPELINE_COMPILER__
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <lava/lava.h>
+#include <lavaUtils/api.h>
+
+#include "JobSystem.h"
+
+namespace lava
+{
+  namespace utility
+  {
+    // Owned copy of the arguments of Device::createGraphicsPipeline.
+    //    Null states are left out of the create info.
+    struct GraphicsPipelineDescription
+    {
+      vk::PipelineCreateFlags flags;
+      std::vector<PipelineShaderStageCreateInfo> stages;
+      std::shared_ptr<PipelineVertexInputStateCreateInfo> vertexInputState;
+      std::shared_ptr<vk::PipelineInputAssemblyStateCreateInfo> inputAssemblyState;
+      std::shared_ptr<vk::PipelineTessellationStateCreateInfo> tessellationState;
+      std::shared_ptr<PipelineViewportStateCreateInfo> viewportState;
+      std::shared_ptr<vk::PipelineRasterizationStateCreateInfo> rasterizationState;
+      std::shared_ptr<PipelineMultisampleStateCreateInfo> multisampleState;
+      std::shared_ptr<vk::PipelineDepthStencilStateCreateInfo> depthStencilState;
+      std::shared_ptr<PipelineColorBlendStateCreateInfo> colorBlendState;
+      std::shared_ptr<PipelineDynamicStateCreateInfo> dynamicState;
+      std::shared_ptr<PipelineLayout> pipelineLayout;
+      std::shared_ptr<RenderPass> renderPass;
+      uint32_t subpass = 0;
+    };
+
+    struct ComputePipelineDescription
+    {
+      ComputePipelineDescription( const PipelineShaderStageCreateInfo& stage_,
+        const std::shared_ptr<PipelineLayout>& pipelineLayout_,
+        vk::PipelineCreateFlags flags_ = vk::PipelineCreateFlags( ) )
+        : flags( flags_ )
+        , stage( stage_ )
+        , pipelineLayout( pipelineLayout_ )
+      {
+      }
+
+      vk::PipelineCreateFlags flags;
+      PipelineShaderStageCreateInfo stage;
+      std::shared_ptr<PipelineLayout> pipelineLayout;
+    };
+
+    /**
+    * Pipeline being compiled in the background. get( ) returns the fallback
+    *   until the compiled pipeline is ready, so the renderer can bind
+    *   whatever it returns every frame without stalling.
+    */
+    class PipelineHandle
+    {
+    public:
+      PipelineHandle( JobSystem& jobSystem,
+        const std::shared_ptr<Pipeline>& fallback )
+        : _jobSystem( jobSystem )
+        , _fallback( fallback )
+        , _ready( false )
+        , _failed( false )
+      {
+      }
+
+      // Compiled pipeline if ready, the fallback (may be null) otherwise
+      inline std::shared_ptr<Pipeline> get( void ) const
+      {
+        return _ready.load( std::memory_order_acquire ) ? _pipeline : _fallback;
+      }
+      inline bool isReady( void ) const
+      {
+        return _ready.load( std::memory_order_acquire );
+      }
+      // Compilation threw, get( ) keeps returning the fallback
+      inline bool failed( void ) const
+      {
+        return _failed.load( std::memory_order_acquire );
+      }
+      // Blocks (running other jobs) until compiled, returns get( )
+      LAVAUTILS_API
+      std::shared_ptr<Pipeline> wait( void );
+    protected:
+      friend class PipelineCompiler;
+
+      JobSystem& _jobSystem;
+      JobCounter _counter;
+      std::shared_ptr<Pipeline> _pipeline;
+      std::shared_ptr<Pipeline> _fallback;
+      std::atomic<bool> _ready;
+      std::atomic<bool> _failed;
+    };
+
+    /**
+    * Compiles pipelines on the JobSystem threads. Pipeline caches can not
+    *   be used from two threads at once, so every thread compiles against
+    *   its own cache (seeded from the target cache); flush( ) merges them
+    *   back into the target with PipelineCache::merge. Besides the workers,
+    *   any thread waiting on the JobSystem may run a compilation; those
+    *   threads get their own cache on first use.
+    */
+    class PipelineCompiler
+    {
+    public:
+      LAVAUTILS_API
+      PipelineCompiler( const std::shared_ptr<Device>& device,
+        const std::shared_ptr<PipelineCache>& targetCache = nullptr,
+        JobSystem& jobSystem = JobSystem::global( ) );
+      // Waits for the pending compilations and merges the caches
+      LAVAUTILS_API
+      ~PipelineCompiler( void );
+
+      PipelineCompiler( const PipelineCompiler& ) = delete;
+      PipelineCompiler& operator=( const PipelineCompiler& ) = delete;
+
+      LAVAUTILS_API
+      std::shared_ptr<PipelineHandle> compile(
+        const GraphicsPipelineDescription& description,
+        const std::shared_ptr<Pipeline>& fallback = nullptr );
+      LAVAUTILS_API
+      std::shared_ptr<PipelineHandle> compile(
+        const ComputePipelineDescription& description,
+        const std::shared_ptr<Pipeline>& fallback = nullptr );
+
+      // Compilations started and not yet finished
+      LAVAUTILS_API
+      size_t pending( void );
+
+      /**
+      * Waits for every pending compilation and merges the thread caches
+      *   into the target cache. Must not run concurrently with compile.
+      */
+      LAVAUTILS_API
+      void flush( void );
+    protected:
+      template <typename Func>
+      std::shared_ptr<PipelineHandle> enqueue(
+        const std::shared_ptr<Pipeline>& fallback, Func create );
+      // Cache owned by the calling thread: its worker cache or an external one
+      std::shared_ptr<PipelineCache> threadCache( void );
+
+      std::shared_ptr<Device> _device;
+      std::shared_ptr<PipelineCache> _targetCache;
+      JobSystem& _jobSystem;
+      // Target cache contents at construction, seeds every thread cache
+      std::vector<uint8_t> _initialData;
+      // One per worker, only used from that worker
+      std::vector<std::shared_ptr<PipelineCache>> _threadCaches;
+      // One per non-worker thread that ran a compilation, guarded by _mutex
+      std::map<std::thread::id, std::shared_ptr<PipelineCache>> _externalCaches;
+      std::vector<std::shared_ptr<PipelineHandle>> _inFlight;
+      std::mutex _mutex;
+    };
+  }
+}
+
+#endif /* __LAVAUTILS_PIPELINE_COMPILER__ */
@@ -0,0 +1,208 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "TaskGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+
+namespace lava
+{
+  namespace utility
+  {
+    TaskGraph::TaskGraph( JobSystem& jobSystem )
+      : _jobSystem( jobSystem )
+      , _dirty( true )
+    {
+    }
+
+    TaskGraph::TaskId TaskGraph::add( const std::string& name,
+      std::function<void( )> function, const std::vector<TaskId>& dependencies )
+    {
+      TaskId id = static_cast< TaskId >( _tasks.size( ) );
+      _tasks.push_back( std::unique_ptr<Task>( new Task( ) ) );
+      _tasks.back( )->name = name;
+      _tasks.back( )->function = std::move( function );
+      for ( TaskId dependency : dependencies )
+      {
+        precede( dependency, id );
+      }
+      _dirty = true;
+      return id;
+    }
+
+    void TaskGraph::precede( TaskId before, TaskId after )
+    {
+      assert( before < _tasks.size( ) && after < _tasks.size( ) );
+      assert( before != after );
+      _tasks[ before ]->successors.push_back( after );
+      _tasks[ after ]->predecessors.push_back( before );
+      _dirty = true;
+    }
+
+    void TaskGraph::sort( void )
+    {
+      // Kahn's algorithm, also finds the roots and catches cycles
+      _order.clear( );
+      _roots.clear( );
+      std::vector<size_t> pending( _tasks.size( ) );
+      for ( TaskId i = 0; i < _tasks.size( ); ++i )
+      {
+        pending[ i ] = _tasks[ i ]->predecessors.size( );
+        if ( pending[ i ] == 0 )
+        {
+          _roots.push_back( i );
+          _order.push_back( i );
+        }
+      }
+      for ( size_t i = 0; i < _order.size( ); ++i )
+      {
+        for ( TaskId successor : _tasks[ _order[ i ] ]->successors )
+        {
+          if ( --pending[ successor ] == 0 )
+          {
+            _order.push_back( successor );
+          }
+        }
+      }
+      assert( _order.size( ) == _tasks.size( ) && "TaskGraph has a cycle" );
+      _dirty = false;
+    }
+
+    void TaskGraph::run( void )
+    {
+      if ( _dirty )
+      {
+        sort( );
+      }
+      for ( auto& task : _tasks )
+      {
+        task->remaining.store( static_cast< uint32_t >(
+          task->predecessors.size( ) ), std::memory_order_relaxed );
+      }
+
+      _runStart = std::chrono::steady_clock::now( );
+      for ( TaskId root : _roots )
+      {
+        schedule( root );
+      }
+      _jobSystem.wait( _counter );
+
+      _stats.wallTime = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now( ) - _runStart ).count( );
+      computeStats( );
+    }
+
+    void TaskGraph::schedule( TaskId task )
+    {
+      _jobSystem.run( [ this, task ]( )
+      {
+        execute( task );
+      }, &_counter );
+    }
+
+    void TaskGraph::execute( TaskId id )
+    {
+      Task& task = *_tasks[ id ];
+      auto start = std::chrono::steady_clock::now( );
+      if ( task.function )
+      {
+        task.function( );
+      }
+      auto end = std::chrono::steady_clock::now( );
+      task.time = std::chrono::duration<double, std::milli>(
+        end - start ).count( );
+
+      // The job of this task is still counted, so _counter cannot reach
+      //    zero before the successors are scheduled
+      for ( TaskId successor : task.successors )
+      {
+        if ( _tasks[ successor ]->remaining.fetch_sub( 1,
+          std::memory_order_acq_rel ) == 1 )
+        {
+          schedule( successor );
+        }
+      }
+    }
+
+    void TaskGraph::computeStats( void )
+    {
+      // Longest path through the DAG weighted by task time
+      std::vector<double> finish( _tasks.size( ), 0.0 );
+      std::vector<TaskId> previous( _tasks.size( ), TaskId( -1 ) );
+      _stats.totalWorkTime = 0.0;
+      _stats.criticalPathTime = 0.0;
+      _stats.criticalPath.clear( );
+
+      TaskId last = TaskId( -1 );
+      for ( TaskId id : _order )
+      {
+        const Task& task = *_tasks[ id ];
+        double begin = 0.0;
+        for ( TaskId predecessor : task.predecessors )
+        {
+          if ( previous[ id ] == TaskId( -1 ) || finish[ predecessor ] > begin )
+          {
+            begin = finish[ predecessor ];
+            previous[ id ] = predecessor;
+          }
+        }
+        finish[ id ] = begin + task.time;
+        _stats.totalWorkTime += task.time;
+        if ( last == TaskId( -1 ) || finish[ id ] > _stats.criticalPathTime )
+        {
+          _stats.criticalPathTime = finish[ id ];
+          last = id;
+        }
+      }
+
+      for ( TaskId id = last; id != TaskId( -1 ); id = previous[ id ] )
+      {
+        _stats.criticalPath.push_back( id );
+      }
+      std::reverse( _stats.criticalPath.begin( ), _stats.criticalPath.end( ) );
+    }
+
+    const std::string& TaskGraph::getTaskName( TaskId task ) const
+    {
+      return _tasks[ task ]->name;
+    }
+
+    double TaskGraph::getTaskTime( TaskId task ) const
+    {
+      return _tasks[ task ]->time;
+    }
+
+    std::string TaskGraph::criticalPathToString( void ) const
+    {
+      std::stringstream ss;
+      for ( size_t i = 0; i < _stats.criticalPath.size( ); ++i )
+      {
+        const Task& task = *_tasks[ _stats.criticalPath[ i ] ];
+        if ( i != 0 )
+        {
+          ss << " -> ";
+        }
+        ss << task.name << " (" << task.time << " ms)";
+      }
+      return ss.str( );
+    }
+  }
+}
@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVAUTILS_TASKGRAPH__
+#define __LAVAUTILS_TASKGRAPH__
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <lavaUtils/api.h>
+
+#include "JobSystem.h"
+
+namespace lava
+{
+  namespace utility
+  {
+    /**
+    * Dependency graph of tasks built once and run every frame on a
+    *   JobSystem. A task is scheduled as soon as all the tasks it depends on
+    *   have finished, so independent branches run in parallel. Every run
+    *   measures the time of each task and the critical path: the chain of
+    *   dependent tasks that bounds the frame time no matter how many
+    *   threads are available.
+    *
+    *   TaskGraph graph;
+    *   auto update = graph.add( "UpdateComponents", [ & ]( ) { ... } );
+    *   auto transforms = graph.add( "Transforms", [ & ]( ) { ... }, { update } );
+    *   auto batch = graph.add( "ComputeBatchQueue", [ & ]( ) { ... }, { transforms } );
+    *   ...
+    *   graph.run( ); // each frame
+    */
+    class TaskGraph
+    {
+    public:
+      typedef uint32_t TaskId;
+
+      struct Stats
+      {
+        // Milliseconds from run( ) start to the last task finished
+        double wallTime = 0.0;
+        // Sum of the task times along the critical path
+        double criticalPathTime = 0.0;
+        // Sum of the times of all the tasks
+        double totalWorkTime = 0.0;
+        // Tasks in the critical path, in execution order
+        std::vector<TaskId> criticalPath;
+      };
+
+      LAVAUTILS_API
+      TaskGraph( JobSystem& jobSystem = JobSystem::global( ) );
+
+      TaskGraph( const TaskGraph& ) = delete;
+      TaskGraph& operator=( const TaskGraph& ) = delete;
+
+      // Adds a task that runs after all the dependencies have finished
+      LAVAUTILS_API
+      TaskId add( const std::string& name, std::function<void( )> function,
+        const std::vector<TaskId>& dependencies = { } );
+      // Makes after wait for before
+      LAVAUTILS_API
+      void precede( TaskId before, TaskId after );
+
+      // Runs every task once and blocks until all have finished
+      LAVAUTILS_API
+      void run( void );
+
+      inline const Stats& getStats( void ) const
+      {
+        return _stats;
+      }
+      LAVAUTILS_API
+      const std::string& getTaskName( TaskId task ) const;
+      // Milliseconds spent in the task during the last run
+      LAVAUTILS_API
+      double getTaskTime( TaskId task ) const;
+      // "A (0.1 ms) -> B (2.3 ms)", for logging
+      LAVAUTILS_API
+      std::string criticalPathToString( void ) const;
+
+      inline size_t size( void ) const
+      {
+        return _tasks.size( );
+      }
+    protected:
+      struct Task
+      {
+        std::string name;
+        std::function<void( )> function;
+        std::vector<TaskId> successors;
+        std::vector<TaskId> predecessors;
+        std::atomic<uint32_t> remaining;
+        double time;
+
+        Task( void )
+          : remaining( 0 )
+          , time( 0.0 )
+        {
+        }
+      };
+
+      void sort( void );
+      void schedule( TaskId task );
+      void execute( TaskId task );
+      void computeStats( void );
+
+      JobSystem& _jobSystem;
+      std::vector<std::unique_ptr<Task>> _tasks;
+      // Topological order, rebuilt when the graph changes
+      std::vector<TaskId> _order;
+      std::vector<TaskId> _roots;
+      bool _dirty;
+      JobCounter _counter;
+      std::chrono::steady_clock::time_point _runStart;
+      Stats _stats;
+    };
+  }
+}
+
+#endif /* __LAVAUTILS_TASKGRAPH__ */
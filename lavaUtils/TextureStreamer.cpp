@@ -0,0 +1,250 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#include "TextureStreamer.h"
+
+#include <lava/utils.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+namespace lava
+{
+  namespace utility
+  {
+    StreamedTexture::StreamedTexture( const std::string& filename,
+      vk::Format format, vk::ImageUsageFlags usage, vk::ImageLayout layout,
+      int priority, const std::shared_ptr<Texture>& placeholder )
+      : _filename( filename )
+      , _format( format )
+      , _usage( usage )
+      , _layout( layout )
+      , _priority( priority )
+      , _cancelled( false )
+      , _state( State::Queued )
+      , _ready( false )
+      , _placeholder( placeholder )
+      , _width( 0 )
+      , _height( 0 )
+      , _mipLevels( 0 )
+      , _sequence( 0 )
+    {
+    }
+
+    TextureStreamer::TextureStreamer( const std::shared_ptr<Device>& device,
+      const std::shared_ptr<UploadEngine>& uploader,
+      const std::shared_ptr<Texture>& placeholder, JobSystem& jobSystem,
+      uint32_t maxDecodes, vk::DeviceSize uploadBudget )
+      : _device( device )
+      , _uploader( uploader )
+      , _placeholder( placeholder )
+      , _jobSystem( jobSystem )
+      , _maxDecodes( maxDecodes != 0 ? maxDecodes :
+        std::max( jobSystem.workerCount( ), 1u ) )
+      , _uploadBudget( uploadBudget )
+      , _sequence( 0 )
+      , _decoding( 0 )
+    {
+    }
+
+    TextureStreamer::~TextureStreamer( void )
+    {
+      _jobSystem.wait( _counter );
+    }
+
+    std::shared_ptr<StreamedTexture> TextureStreamer::load(
+      const std::string& filename, vk::Format format, int priority,
+      vk::ImageUsageFlags usage, vk::ImageLayout layout )
+    {
+      auto texture = std::make_shared<StreamedTexture>( filename, format,
+        usage, layout, priority, _placeholder );
+
+      std::lock_guard<std::mutex> lock( _mutex );
+      texture->_sequence = _sequence++;
+      _queued.push_back( texture );
+      return texture;
+    }
+
+    void TextureStreamer::update( const std::shared_ptr<CommandBuffer>& cmd )
+    {
+      // Publish finished batches. Cancelled textures still take the acquire
+      //    barriers: the image was released by the transfer queue anyway.
+      while ( !_inFlight.empty( ) && _inFlight.front( ).token.isComplete( ) )
+      {
+        Batch& batch = _inFlight.front( );
+        _uploader->acquire( cmd, batch.token );
+        for ( auto const& texture : batch.textures )
+        {
+          if ( texture->isCancelled( ) )
+          {
+            texture->_texture.reset( );
+            texture->_state = StreamedTexture::State::Cancelled;
+          }
+          else
+          {
+            texture->_state = StreamedTexture::State::Ready;
+            texture->_ready.store( true, std::memory_order_release );
+          }
+        }
+        _inFlight.pop_front( );
+      }
+
+      std::vector<std::shared_ptr<StreamedTexture>> decoded;
+      {
+        std::lock_guard<std::mutex> lock( _mutex );
+
+        // Best request last, so starting one is a pop_back
+        _queued.erase( std::remove_if( _queued.begin( ), _queued.end( ),
+          []( const std::shared_ptr<StreamedTexture>& texture )
+          {
+            if ( texture->isCancelled( ) )
+            {
+              texture->_state = StreamedTexture::State::Cancelled;
+              return true;
+            }
+            return false;
+          } ), _queued.end( ) );
+        std::sort( _queued.begin( ), _queued.end( ),
+          []( const std::shared_ptr<StreamedTexture>& a,
+            const std::shared_ptr<StreamedTexture>& b )
+          {
+            return byPriority( b, a );
+          } );
+        while ( !_queued.empty( ) && _decoding.load( ) < _maxDecodes )
+        {
+          std::shared_ptr<StreamedTexture> texture = _queued.back( );
+          _queued.pop_back( );
+          texture->_state = StreamedTexture::State::Decoding;
+          ++_decoding;
+          _jobSystem.run( [ this, texture ]( )
+          {
+            decode( texture );
+          }, &_counter );
+        }
+
+        decoded.swap( _decoded );
+      }
+
+      std::sort( decoded.begin( ), decoded.end( ), byPriority );
+
+      Batch batch;
+      vk::DeviceSize uploaded = 0;
+      std::vector<std::shared_ptr<StreamedTexture>> deferred;
+      for ( auto const& texture : decoded )
+      {
+        vk::DeviceSize size = texture->_pixels.size( );
+        if ( texture->isCancelled( ) )
+        {
+          texture->_state = StreamedTexture::State::Cancelled;
+        }
+        else if ( !batch.textures.empty( ) && uploaded + size > _uploadBudget )
+        {
+          deferred.push_back( texture );
+          continue;
+        }
+        else
+        {
+          try
+          {
+            texture->_texture = std::make_shared<Texture2D>( _device,
+              texture->_pixels.data( ), texture->_width, texture->_height,
+              _uploader, texture->_format, texture->_usage, texture->_layout,
+              texture->_mipLevels );
+            texture->_state = StreamedTexture::State::Uploading;
+            batch.textures.push_back( texture );
+            uploaded += size;
+          }
+          catch ( const std::exception& e )
+          {
+            std::cerr << "Failed to upload " << texture->_filename << ": "
+              << e.what( ) << std::endl;
+            texture->_texture.reset( );
+            texture->_state = StreamedTexture::State::Failed;
+          }
+        }
+        std::vector<unsigned char>( ).swap( texture->_pixels );
+      }
+
+      if ( !deferred.empty( ) )
+      {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _decoded.insert( _decoded.end( ), deferred.begin( ), deferred.end( ) );
+      }
+
+      if ( !batch.textures.empty( ) )
+      {
+        batch.token = _uploader->flush( );
+        _inFlight.push_back( batch );
+      }
+    }
+
+    size_t TextureStreamer::pending( void )
+    {
+      size_t count = 0;
+      for ( auto const& batch : _inFlight )
+      {
+        count += batch.textures.size( );
+      }
+      std::lock_guard<std::mutex> lock( _mutex );
+      return count + _queued.size( ) + _decoded.size( ) + _decoding.load( );
+    }
+
+    bool TextureStreamer::byPriority( const std::shared_ptr<StreamedTexture>& a,
+      const std::shared_ptr<StreamedTexture>& b )
+    {
+      int pa = a->getPriority( );
+      int pb = b->getPriority( );
+      return pa != pb ? pa > pb : a->_sequence < b->_sequence;
+    }
+
+    void TextureStreamer::decode( const std::shared_ptr<StreamedTexture>& texture )
+    {
+      if ( texture->isCancelled( ) )
+      {
+        texture->_state = StreamedTexture::State::Cancelled;
+      }
+      else
+      {
+        try
+        {
+          uint32_t channels;
+          unsigned char* pixels = lava::utils::loadImageTexture(
+            texture->_filename, texture->_width, texture->_height, channels );
+          // Mips are built here too, off the render thread
+          texture->_mipLevels = lava::utils::mipLevelCount( texture->_width,
+            texture->_height );
+          texture->_pixels = lava::utils::buildMipChainRGBA8( pixels,
+            texture->_width, texture->_height, texture->_mipLevels );
+          free( pixels );
+          texture->_state = StreamedTexture::State::Decoded;
+
+          std::lock_guard<std::mutex> lock( _mutex );
+          _decoded.push_back( texture );
+        }
+        catch ( const std::exception& e )
+        {
+          std::cerr << "Failed to decode " << texture->_filename << ": "
+            << e.what( ) << std::endl;
+          texture->_state = StreamedTexture::State::Failed;
+        }
+      }
+      --_decoding;
+    }
+  }
+}
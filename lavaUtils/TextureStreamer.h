@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2017 - 2018, Lava
+ * All rights reserved.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+
+#ifndef __LAVAUTILS_TEXTURE_STREAMER__
+#define __LAVAUTILS_TEXTURE_STREAMER__
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <lava/lava.h>
+#include <lavaUtils/api.h>
+
+#include "JobSystem.h"
+
+namespace lava
+{
+  namespace utility
+  {
+    /**
+    * Texture being streamed by TextureStreamer. get( ) returns the
+    *   placeholder until the upload is done, so it can be bound right away.
+    */
+    class StreamedTexture
+    {
+    public:
+      enum class State
+      {
+        Queued,
+        Decoding,
+        Decoded,
+        Uploading,
+        Ready,
+        Failed,
+        Cancelled
+      };
+
+      StreamedTexture( const std::string& filename, vk::Format format,
+        vk::ImageUsageFlags usage, vk::ImageLayout layout, int priority,
+        const std::shared_ptr<Texture>& placeholder );
+
+      StreamedTexture( const StreamedTexture& ) = delete;
+      StreamedTexture& operator=( const StreamedTexture& ) = delete;
+
+      // Streamed texture if ready, the placeholder otherwise
+      inline std::shared_ptr<Texture> get( void ) const
+      {
+        return _ready.load( std::memory_order_acquire ) ? _texture : _placeholder;
+      }
+      inline bool isReady( void ) const
+      {
+        return _ready.load( std::memory_order_acquire );
+      }
+      inline State getState( void ) const
+      {
+        return _state.load( std::memory_order_acquire );
+      }
+      inline const std::string& getFilename( void ) const
+      {
+        return _filename;
+      }
+
+      // Higher first. Only affects work not started yet.
+      inline void setPriority( int priority )
+      {
+        _priority.store( priority, std::memory_order_relaxed );
+      }
+      inline int getPriority( void ) const
+      {
+        return _priority.load( std::memory_order_relaxed );
+      }
+      /**
+      * Drops the request (e.g. the asset left the screen). Work already
+      *   running finishes but its result is discarded; get( ) keeps
+      *   returning the placeholder.
+      */
+      inline void cancel( void )
+      {
+        _cancelled.store( true, std::memory_order_release );
+      }
+      inline bool isCancelled( void ) const
+      {
+        return _cancelled.load( std::memory_order_acquire );
+      }
+    protected:
+      friend class TextureStreamer;
+
+      std::string _filename;
+      vk::Format _format;
+      vk::ImageUsageFlags _usage;
+      vk::ImageLayout _layout;
+      std::atomic<int> _priority;
+      std::atomic<bool> _cancelled;
+      std::atomic<State> _state;
+      std::atomic<bool> _ready;
+      std::shared_ptr<Texture> _placeholder;
+      std::shared_ptr<Texture> _texture;
+      // Decoded RGBA8 mip chain, released once uploaded
+      std::vector<unsigned char> _pixels;
+      uint32_t _width;
+      uint32_t _height;
+      uint32_t _mipLevels;
+      uint64_t _sequence;
+    };
+
+    /**
+    * Loads textures without blocking the caller: files are decoded on the
+    *   JobSystem and uploaded in batches through an UploadEngine, one
+    *   submit per update( ). Requests are served by priority (then in
+    *   order) and can be cancelled.
+    *
+    * load( ) may be called from any thread; update( ) from the render
+    *   thread once per frame.
+    */
+    class TextureStreamer
+    {
+    public:
+      /**
+      * placeholder: bound until each texture is ready (e.g. a 1x1 texture).
+      * maxDecodes: decodes in flight, 0 uses one per JobSystem worker.
+      * uploadBudget: bytes uploaded per update( ), at least one texture.
+      */
+      LAVAUTILS_API
+      TextureStreamer( const std::shared_ptr<Device>& device,
+        const std::shared_ptr<UploadEngine>& uploader,
+        const std::shared_ptr<Texture>& placeholder,
+        JobSystem& jobSystem = JobSystem::global( ), uint32_t maxDecodes = 0,
+        vk::DeviceSize uploadBudget = 32 * 1024 * 1024 );
+      // Waits for the running decodes
+      LAVAUTILS_API
+      ~TextureStreamer( void );
+
+      TextureStreamer( const TextureStreamer& ) = delete;
+      TextureStreamer& operator=( const TextureStreamer& ) = delete;
+
+      LAVAUTILS_API
+      std::shared_ptr<StreamedTexture> load( const std::string& filename,
+        vk::Format format = vk::Format::eR8G8B8A8Unorm, int priority = 0,
+        vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eSampled,
+        vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal );
+
+      /**
+      * Publishes the uploads that completed, recording their acquire
+      *   barriers on cmd (textures are ready for the draws recorded after
+      *   this call), starts decodes and submits the decoded textures.
+      */
+      LAVAUTILS_API
+      void update( const std::shared_ptr<CommandBuffer>& cmd );
+
+      // Requests not ready, failed nor cancelled yet
+      LAVAUTILS_API
+      size_t pending( void );
+    protected:
+      struct Batch
+      {
+        UploadToken token;
+        std::vector<std::shared_ptr<StreamedTexture>> textures;
+      };
+      static bool byPriority( const std::shared_ptr<StreamedTexture>& a,
+        const std::shared_ptr<StreamedTexture>& b );
+      void decode( const std::shared_ptr<StreamedTexture>& texture );
+
+      std::shared_ptr<Device> _device;
+      std::shared_ptr<UploadEngine> _uploader;
+      std::shared_ptr<Texture> _placeholder;
+      JobSystem& _jobSystem;
+      uint32_t _maxDecodes;
+      vk::DeviceSize _uploadBudget;
+      uint64_t _sequence;
+      std::atomic<uint32_t> _decoding;
+      JobCounter _counter;
+
+      std::vector<std::shared_ptr<StreamedTexture>> _queued;
+      std::vector<std::shared_ptr<StreamedTexture>> _decoded;
+      std::deque<Batch> _inFlight;
+      std::mutex _mutex;
+    };
+  }
+}
+
+#endif /* __LAVAUTILS_TEXTURE_STREAMER__ */
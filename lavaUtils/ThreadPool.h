@@ -62,6 +62,8 @@ namespace lava
       void wait( void );
     };
 
+    // Fixed thread-per-queue pool. New code should use JobSystem, which
+    //    balances the load between workers.
     class ThreadPool
     {
     public:
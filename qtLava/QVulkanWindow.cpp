@@ -101,6 +101,20 @@ namespace lava
   {
     if ( !_dfbFramebuffer || !_dfbFramebuffer->swapchain( ) || _framePending ) return;
 
+    // Block only when the GPU is framesInFlight frames behind
+    FrameInFlight& frame = _frames[ _currentFrame ];
+    if ( frame.fence )
+    {
+      frame.fence->wait( );
+      frame.fence.reset( );
+      _device->getRetirementQueue( )->completeFrame( frame.number );
+    }
+    _device->getRetirementQueue( )->collect( );
+    if ( _pipelineCacheManager )
+    {
+      _pipelineCacheManager->update( );
+    }
+
     vk::Extent2D extent = _dfbFramebuffer->extent( );
     if ( _dfbFramebuffer->extent( ) != swapchainImageSize( ) )
     {
@@ -133,9 +147,25 @@ namespace lava
     }
 
     imageIdx = res.value;
-    cmds[ imageIdx ] = _cmdPool->allocateCommandBuffer( );
 
-    auto cmd = cmds[ imageIdx ];
+    // The image may still be used by a frame other than this slot when
+    //    there are fewer swapchain images than frames in flight
+    auto& imageFence = _imageFences[ imageIdx ];
+    if ( imageFence )
+    {
+      imageFence->wait( );
+      imageFence.reset( );
+    }
+
+    // Everything in this frame slot is free to reuse now
+    _frameCmdPool->beginFrame( _currentFrame );
+    for ( auto& arena : _uniformArenas )
+    {
+      arena->beginFrame( _currentFrame );
+    }
+    cmds[ _currentFrame ] = _frameCmdPool->allocateCommandBuffer( );
+
+    auto cmd = cmds[ _currentFrame ];
     cmd->begin( );
 
     if ( _frameGrabbing )
@@ -178,7 +208,7 @@ namespace lava
     {
       try
       {
-        auto cmd = cmds[ imageIdx ];
+        auto cmd = cmds[ _currentFrame ];
 
         if ( _gfxQueueFamilyIdx != _presQueueFamilyIdx && !_frameGrabbing )
         {
@@ -208,12 +238,16 @@ namespace lava
 
         cmd->end( );
 
+        auto fence = _device->acquireFence( );
         vk::Result res = _gfxQueue->submit( SubmitInfo{
           _dfbFramebuffer->swapchain( )->getPresentCompleteSemaphores( )[ imageIdx ],
           { vk::PipelineStageFlagBits::eColorAttachmentOutput },
           cmd,
-          _renderComplete
-        } );
+          _renderComplete[ imageIdx ]
+        }, fence );
+        _frames[ _currentFrame ].fence = fence;
+        _frames[ _currentFrame ].number = _frameNumber;
+        _imageFences[ imageIdx ] = fence;
       }
       catch ( std::exception e )
       {
@@ -256,7 +290,7 @@ namespace lava
     vk::Result presentResult = vk::Result::eSuccess;
     try
     {
-      auto waitSemaphores = { _renderComplete };
+      auto waitSemaphores = { _renderComplete[ imageIdx ] };
       auto swapchains = { _dfbFramebuffer->swapchain( ) };
       std::vector<uint32_t> imageIndices = { imageIdx };
       vk::Queue _queue = *_presQueue;
@@ -302,7 +336,10 @@ namespace lava
     }
 
     vulkanInstance( )->presentQueued( this );
-    _presQueue->waitIdle( ); // TODO: Neccesary??
+
+    // No wait here: the next frame slot is only waited for in beginFrame
+    _currentFrame = ( _currentFrame + 1 ) % _framesInFlight;
+    ++_frameNumber;
     
     if ( _continuousAnimation )
     {
@@ -660,6 +697,19 @@ namespace lava
       queueCreateInfos.push_back( dqci2 );
     }
 
+    // Dedicated transfer queue used by the upload engine, if any
+    std::vector<uint32_t> transferQueueFamilyIdxs =
+      _physicalDevice->getTransferQueueFamilyIndices( );
+    if ( !transferQueueFamilyIdxs.empty( ) )
+    {
+      vk::DeviceQueueCreateInfo dqci3;
+      dqci3.setQueueFamilyIndex( transferQueueFamilyIdxs.front( ) );
+      dqci3.setQueueCount( 1 );
+      dqci3.setPQueuePriorities( &queuePriority );
+
+      queueCreateInfos.push_back( dqci3 );
+    }
+
     _device = _physicalDevice->createDevice(
       queueCreateInfos,
       enabledLayerNames,
@@ -681,8 +731,11 @@ namespace lava
   
   bool QtVulkanWindow::setupPipelineCache( void )
   {
-    _pipelineCache = nullptr;
-    return true;
+    // Loaded now, saved periodically from beginFrame and at cleanup
+    _pipelineCacheManager = _device->createPipelineCacheManager(
+      _pipelineCacheDirectory );
+    _pipelineCache = _pipelineCacheManager->getPipelineCache( );
+    return _pipelineCacheManager->loadedFromDisk( );
   }
 
   void QtVulkanWindow::initVulkan( void )
@@ -721,22 +774,22 @@ namespace lava
       //vk::CommandPoolCreateFlagBits::eResetCommandBuffer, 
       _gfxQueueFamilyIdx );
 
-    size_t numImages = _dfbFramebuffer->swapchain( )->count( );
-    cmds.reserve( numImages );
-    for ( size_t i = 0; i < numImages; ++i )
-    {
-      cmds.push_back( _cmdPool->allocateCommandBuffer( ) );
-    }
+    cmds.resize( _framesInFlight );
+    _frames.resize( _framesInFlight );
+    _currentFrame = 0;
+    _frameCmdPool = _device->createFrameCommandPool( _gfxQueueFamilyIdx,
+      _framesInFlight );
+    createFrameResources( );
 
     setupPipelineCache( );
 
+    _uploadEngine = _device->createUploadEngine( _gfxQueueFamilyIdx );
+
     if ( renderer )
     {
       renderer->initResources( );
     }
 
-    _renderComplete = _device->createSemaphore( );
-
     _initialized = true;
   }
   
@@ -757,15 +810,21 @@ namespace lava
     }
 
     cmds.clear( );
+    _uniformArenas.clear( );
+    _frames.clear( );
+    _imageFences.clear( );
+    _frameCmdPool.reset( );
+
+    _uploadEngine.reset( );
+
+    // Saves the cache
+    _pipelineCache.reset( );
+    _pipelineCacheManager.reset( );
 
     delete _dfbFramebuffer;
     _dfbFramebuffer = nullptr;
 
-    if ( _renderComplete )
-    {
-      _renderComplete.reset( );
-      _renderComplete = nullptr;
-    }
+    _renderComplete.clear( );
 
     _initialized = false;
   }
@@ -773,5 +832,23 @@ namespace lava
   void QtVulkanWindow::recreateSwapchain( void )
   {
     _dfbFramebuffer->recreate( );
+    // recreate waited for the device, every frame slot is free
+    for ( auto& frame : _frames )
+    {
+      frame.fence.reset( );
+    }
+    createFrameResources( );
+  }
+
+  void QtVulkanWindow::createFrameResources( void )
+  {
+    size_t numImages = _dfbFramebuffer->swapchain( )->count( );
+    _imageFences.assign( numImages, nullptr );
+    _renderComplete.clear( );
+    for ( size_t i = 0; i < numImages; ++i )
+    {
+      // Not pooled: a failed present may leave them signaled
+      _renderComplete.push_back( _device->createSemaphore( ) );
+    }
   }
 }
\ No newline at end of file
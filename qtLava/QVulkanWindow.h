@@ -367,11 +367,31 @@ namespace lava
     std::shared_ptr< lava::Queue > _gfxQueue;
     std::shared_ptr< lava::Queue > _presQueue;
 
+    // One per frame in flight
     std::vector<std::shared_ptr< lava::CommandBuffer > > cmds;
 
+    struct FrameInFlight
+    {
+      // Signaled when the GPU finishes the last submit of this frame slot
+      std::shared_ptr< lava::Fence > fence;
+      uint64_t number = 0;
+    };
+    // One until a renderer opts in: renderers that write the same uniform
+    //    buffer every frame would race the GPU otherwise
+    uint32_t _framesInFlight = 1;
+    uint32_t _currentFrame = 0;
+    uint64_t _frameNumber = 0;
+    std::vector< FrameInFlight > _frames;
+    // Per-frame uniform slots, moved to the current frame in beginFrame
+    std::vector< std::shared_ptr< lava::UniformArena > > _uniformArenas;
+    // Fence of the last frame that rendered to each swapchain image
+    std::vector< std::shared_ptr< lava::Fence > > _imageFences;
+
     DefaultFramebuffer* _dfbFramebuffer = nullptr;
 
     std::shared_ptr< lava::CommandPool > _cmdPool;
+    std::shared_ptr< lava::FrameCommandPool > _frameCmdPool;
+    std::shared_ptr< lava::UploadEngine > _uploadEngine;
 
     bool _framePending = false;
     bool _frameGrabbing = false;
@@ -379,10 +399,15 @@ namespace lava
     std::shared_ptr< lava::Image > frameGrabImage = nullptr;
 
     std::shared_ptr< PipelineCache > _pipelineCache;
+    std::shared_ptr< PipelineCacheManager > _pipelineCacheManager;
+    std::string _pipelineCacheDirectory = ".";
 
     vk::SampleCountFlagBits sampleCount = vk::SampleCountFlagBits::e1;
 
-    std::shared_ptr< lava::Semaphore > _renderComplete = nullptr;
+    // One per swapchain image, waited by the present of that image
+    std::vector< std::shared_ptr< lava::Semaphore > > _renderComplete;
+
+    void createFrameResources( void );
   protected:
     QtVulkanWindowRenderer* renderer = nullptr;
   protected:
@@ -409,6 +434,12 @@ namespace lava
     {
       return _pipelineCache;
     }
+    // Where the pipeline cache is persisted, set before the window is shown
+    QTLAVA_API
+    void setPipelineCacheDirectory( const std::string& directory )
+    {
+      _pipelineCacheDirectory = directory;
+    }
   protected:
     //QTLAVA_API
     void beginFrame( void );
@@ -487,6 +518,12 @@ namespace lava
     {
       return _cmdPool;
     }
+    // Asynchronous uploads, released to the graphics queue family
+    QTLAVA_API
+    std::shared_ptr<UploadEngine> uploadEngine( void ) const
+    {
+      return _uploadEngine;
+    }
     QTLAVA_API
     vk::Format colorFormat( void ) const
     {
@@ -505,7 +542,56 @@ namespace lava
     QTLAVA_API
     std::shared_ptr<CommandBuffer> currentCommandBuffer( void ) const
     {
-      return cmds.at( imageIdx );
+      return cmds.at( _currentFrame );
+    }
+    /**
+    * Number of frames the CPU can record ahead of the GPU (1 by default).
+    *   Must be set before the window is exposed. Renderers that raise it keep
+    *   their per-frame data in uniformArena slots or index it with
+    *   currentFrameIndex( ).
+    */
+    QTLAVA_API
+    void setFramesInFlight( uint32_t count )
+    {
+      assert( !_initialized && count > 0 );
+      _framesInFlight = count;
+    }
+    QTLAVA_API
+    uint32_t framesInFlight( void ) const
+    {
+      return _framesInFlight;
+    }
+    // Index in [0, framesInFlight( )) of the frame being recorded, to pick
+    //    per-frame resources (uniform slots, descriptor sets, ...)
+    QTLAVA_API
+    uint32_t currentFrameIndex( void ) const
+    {
+      return _currentFrame;
+    }
+    // Monotonic frame counter, usable with RetirementQueue::retireAtFrame
+    QTLAVA_API
+    uint64_t currentFrameNumber( void ) const
+    {
+      return _frameNumber;
+    }
+    /**
+    * Uniform arena with one slot per frame in flight, owned by the window.
+    *   beginFrame switches it to the slot of currentFrameIndex( ) once the
+    *   GPU is done with it, so allocations made while recording a frame
+    *   never overwrite data of a frame still in flight. Create it from
+    *   initResources; it is released with the window resources.
+    */
+    QTLAVA_API
+    std::shared_ptr< UniformArena > createUniformArena(
+      vk::DeviceSize frameSize, vk::DeviceSize maxRange,
+      vk::ShaderStageFlags stages, uint32_t binding = 0 )
+    {
+      assert( _device );
+      auto arena = _device->createUniformArena( frameSize, _framesInFlight,
+        maxRange, stages, binding );
+      arena->beginFrame( _currentFrame );
+      _uniformArenas.push_back( arena );
+      return arena;
     }
     QTLAVA_API
     std::shared_ptr< RenderPass > renderPass( void ) const